@@ -0,0 +1,552 @@
+#pragma once
+#include "common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Common
+{
+
+class BufferPool;
+
+namespace Detail
+{
+
+struct BufferBlock;
+
+/**
+ * @brief Thread that created a buffer, owning its non-atomic reference count.
+ *
+ * Records are never freed, so a buffer can always reach the record of its owner, also after the
+ * owner thread exited. They stay linked in one list so leak checkers see them as reachable.
+ */
+struct OwnerRecord
+{
+    std::atomic<BufferBlock*> inbox{nullptr}; ///< Buffers waiting for the owner to merge their counts.
+    std::atomic<bool> orphaned{false};        ///< The owner thread exited, anyone may merge.
+    OwnerRecord* next_record{nullptr};        ///< Link in the list of all records.
+};
+
+/**
+ * @brief Create a record and link it into the list of all records.
+ */
+inline OwnerRecord* newOwnerRecord(const bool orphaned)
+{
+    static std::atomic<OwnerRecord*> records{nullptr};
+    auto* record{new OwnerRecord{}};
+    record->orphaned.store(orphaned, std::memory_order_relaxed);
+    record->next_record = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(record->next_record, record, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    return record;
+}
+
+/**
+ * @brief Header in front of the bytes of a buffer.
+ *
+ * Biased reference counting: the owner thread counts its references in `biased` without atomics,
+ * other threads count theirs in `shared`. A reference created on one thread may be dropped on
+ * another, so `shared` can go negative; the first time it does, the block is queued for its owner,
+ * which merges `biased` into `shared`. From then on, or once the owner's own count reaches zero,
+ * only `shared` is used and the block is freed when it reaches zero.
+ */
+struct BufferBlock
+{
+    static constexpr int64_t MERGED = 1; ///< `biased` has been folded into `shared`.
+    static constexpr int64_t QUEUED = 2; ///< Queued in the owner's inbox.
+    static constexpr int64_t ONE = 4;    ///< One reference in `shared`, the low bits hold the flags.
+
+    OwnerRecord* owner;                ///< Thread that created the buffer.
+    uint32_t biased{1};                ///< Owner references, owner thread only.
+    bool merged_by_owner{false};       ///< Owner-side copy of MERGED, owner thread only.
+    std::atomic<int64_t> shared{0};    ///< References of other threads times ONE, plus flags.
+    BufferBlock* next_queued{nullptr}; ///< Link in the owner's inbox.
+    BufferPool* pool;                  ///< Pool the storage returns to, `nullptr` if not pooled.
+    std::size_t capacity;              ///< Bytes following the header.
+
+    BufferBlock(OwnerRecord* owner_record, BufferPool* buffer_pool, const std::size_t bytes)
+        : owner{owner_record}
+        , pool{buffer_pool}
+        , capacity{bytes}
+    {
+    }
+
+    uint8_t* bytes()
+    {
+        return reinterpret_cast<uint8_t*>(this + 1);
+    }
+
+    static int64_t countOf(const int64_t value)
+    {
+        return (value - (value & (ONE - 1))) / ONE;
+    }
+};
+
+inline void releaseBlock(BufferBlock* block);
+
+/**
+ * @brief Fold the owner count into the shared count, once.
+ */
+inline void merge(BufferBlock* block)
+{
+    const int64_t biased{static_cast<int64_t>(block->biased)};
+    block->biased = 0;
+    block->merged_by_owner = true;
+    const int64_t previous{block->shared.fetch_add(biased * BufferBlock::ONE + BufferBlock::MERGED, std::memory_order_acq_rel)};
+    if (BufferBlock::countOf(previous) + biased == 0)
+    {
+        releaseBlock(block);
+    }
+}
+
+/**
+ * @brief Merge every block queued for an owner.
+ */
+inline void drainInbox(OwnerRecord* record)
+{
+    BufferBlock* block{record->inbox.exchange(nullptr, std::memory_order_acquire)};
+    while (block != nullptr)
+    {
+        BufferBlock* next{block->next_queued};
+        merge(block);
+        block = next;
+    }
+}
+
+/**
+ * @brief Marks the record of an exiting thread as orphaned and merges what is queued for it.
+ */
+struct OwnerGuard
+{
+    OwnerRecord* record{newOwnerRecord(false)};
+
+    ~OwnerGuard();
+};
+
+inline thread_local OwnerRecord* t_owner{nullptr};
+inline thread_local bool t_exiting{false};
+
+inline OwnerGuard::~OwnerGuard()
+{
+    t_owner = nullptr;
+    t_exiting = true;
+    record->orphaned.store(true, std::memory_order_seq_cst);
+    drainInbox(record);
+}
+
+/**
+ * @brief Record of the calling thread.
+ *
+ * Buffers created while the thread is exiting get an already orphaned record, which makes every
+ * thread use the shared count for them.
+ */
+inline OwnerRecord* currentOwner()
+{
+    if (t_owner == nullptr)
+    {
+        if (t_exiting)
+        {
+            static OwnerRecord* const orphan{newOwnerRecord(true)};
+            return orphan;
+        }
+        thread_local OwnerGuard guard{};
+        t_owner = guard.record;
+    }
+    return t_owner;
+}
+
+inline void retain(BufferBlock* block)
+{
+    if (block->owner == t_owner && !block->merged_by_owner)
+    {
+        ++block->biased;
+        return;
+    }
+    block->shared.fetch_add(BufferBlock::ONE, std::memory_order_relaxed);
+}
+
+inline void release(BufferBlock* block)
+{
+    OwnerRecord* owner{block->owner};
+    if (owner == t_owner && !block->merged_by_owner)
+    {
+        if (--block->biased == 0)
+        {
+            block->merged_by_owner = true;
+            const int64_t previous{block->shared.fetch_add(BufferBlock::MERGED, std::memory_order_acq_rel)};
+            if (BufferBlock::countOf(previous) == 0)
+            {
+                releaseBlock(block);
+            }
+        }
+        if (owner->inbox.load(std::memory_order_relaxed) != nullptr)
+        {
+            drainInbox(owner);
+        }
+        return;
+    }
+    const int64_t value{block->shared.fetch_sub(BufferBlock::ONE, std::memory_order_acq_rel) - BufferBlock::ONE};
+    const int64_t count{BufferBlock::countOf(value)};
+    if ((value & BufferBlock::MERGED) != 0)
+    {
+        if (count == 0)
+        {
+            releaseBlock(block);
+        }
+        return;
+    }
+    if (count >= 0 || (value & BufferBlock::QUEUED) != 0)
+    {
+        return;
+    }
+    // More references were dropped here than taken here: the owner has to merge the counts.
+    int64_t expected{value};
+    while ((expected & (BufferBlock::QUEUED | BufferBlock::MERGED)) == 0 &&
+           !block->shared.compare_exchange_weak(expected, expected | BufferBlock::QUEUED, std::memory_order_acq_rel))
+    {
+    }
+    if ((expected & (BufferBlock::QUEUED | BufferBlock::MERGED)) != 0)
+    {
+        return;
+    }
+    BufferBlock* head{owner->inbox.load(std::memory_order_relaxed)};
+    do
+    {
+        block->next_queued = head;
+    } while (!owner->inbox.compare_exchange_weak(head, block, std::memory_order_seq_cst, std::memory_order_relaxed));
+    // The owner may have exited before seeing the block, then nobody else will merge it.
+    if (owner->orphaned.load(std::memory_order_seq_cst))
+    {
+        drainInbox(owner);
+    }
+}
+
+} // namespace Detail
+
+/**
+ * @brief Recycles the storage of freed buffers by size class.
+ *
+ * Sizes are rounded up to a power of two between `MIN_CLASS` and `MAX_CLASS` bytes; larger
+ * buffers are not pooled. The pool must outlive every buffer allocated from it.
+ */
+class BufferPool
+{
+public:
+    static constexpr std::size_t MIN_CLASS = 64;
+    static constexpr std::size_t MAX_CLASS = 1 << 20;
+
+    /**
+     * @brief Constructor.
+     * @param max_cached Freed blocks kept per size class, the rest is released.
+     */
+    explicit BufferPool(const std::size_t max_cached = 64)
+        : m_max_cached{max_cached}
+    {
+    }
+
+    /**
+     * @brief Destructor that releases the cached blocks.
+     */
+    ~BufferPool()
+    {
+        for (std::vector<void*>& free_list : m_free)
+        {
+            for (void* memory : free_list)
+            {
+                ::operator delete(memory);
+            }
+        }
+    }
+
+    // Make this class uncopyable
+    UNCOPYABLE(BufferPool);
+
+    /**
+     * @brief Number of freed blocks waiting for reuse.
+     * @return The number of blocks.
+     */
+    std::size_t cached() const
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        std::size_t count{0};
+        for (const std::vector<void*>& free_list : m_free)
+        {
+            count += free_list.size();
+        }
+        return count;
+    }
+
+    /**
+     * @brief Number of pooled blocks still held by buffers.
+     * @return The number of blocks.
+     */
+    std::size_t outstanding() const
+    {
+        return m_outstanding.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class Buffer;
+    friend void Detail::releaseBlock(Detail::BufferBlock* block);
+
+    static constexpr std::size_t NUM_OF_CLASSES = 15; ///< 64 B to 1 MiB.
+
+    const std::size_t m_max_cached;
+    mutable std::mutex m_lock{};
+    std::vector<void*> m_free[NUM_OF_CLASSES]{};
+    std::atomic<std::size_t> m_outstanding{0};
+
+    static std::size_t classOf(const std::size_t size)
+    {
+        std::size_t index{0};
+        for (std::size_t capacity{MIN_CLASS}; capacity < size; capacity <<= 1)
+        {
+            ++index;
+        }
+        return index;
+    }
+
+    Detail::BufferBlock* allocate(const std::size_t size)
+    {
+        if (size > MAX_CLASS)
+        {
+            return create(nullptr, size);
+        }
+        const std::size_t index{classOf(size)};
+        void* memory{nullptr};
+        {
+            std::lock_guard<std::mutex> lock{m_lock};
+            if (!m_free[index].empty())
+            {
+                memory = m_free[index].back();
+                m_free[index].pop_back();
+            }
+        }
+        const std::size_t capacity{MIN_CLASS << index};
+        m_outstanding.fetch_add(1, std::memory_order_relaxed);
+        if (memory == nullptr)
+        {
+            return create(this, capacity);
+        }
+        return new (memory) Detail::BufferBlock(Detail::currentOwner(), this, capacity);
+    }
+
+    void recycle(Detail::BufferBlock* block)
+    {
+        const std::size_t index{classOf(block->capacity)};
+        block->~BufferBlock();
+        m_outstanding.fetch_sub(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock{m_lock};
+            if (m_free[index].size() < m_max_cached)
+            {
+                m_free[index].push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    static Detail::BufferBlock* create(BufferPool* pool, const std::size_t capacity)
+    {
+        void* memory{::operator new(sizeof(Detail::BufferBlock) + capacity)};
+        return new (memory) Detail::BufferBlock(Detail::currentOwner(), pool, capacity);
+    }
+};
+
+namespace Detail
+{
+
+inline void releaseBlock(BufferBlock* block)
+{
+    if (block->pool != nullptr)
+    {
+        block->pool->recycle(block);
+        return;
+    }
+    block->~BufferBlock();
+    ::operator delete(block);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Immutable, reference-counted byte buffer that can be sliced without copying.
+ *
+ * Copies and slices share the bytes. Copying and dropping a buffer on the thread that created it
+ * touches only a plain counter; other threads use an atomic one, so handing a buffer through a
+ * `Queue` or a `Bus` costs one atomic operation on the receiving side instead of one per hop.
+ * The buffer is cheap to move and fits where `std::shared_ptr<const std::vector<uint8_t>>` was
+ * used for payloads.
+ */
+class Buffer
+{
+public:
+    /**
+     * @brief Default constructor, creates an empty buffer.
+     */
+    Buffer() = default;
+
+    /**
+     * @brief Create a buffer holding a copy of some bytes.
+     * @param data The bytes to copy.
+     * @param size The number of bytes.
+     * @param pool Pool providing the storage, `nullptr` to allocate directly.
+     * @return The buffer.
+     */
+    static Buffer copyOf(const void* data, const std::size_t size, BufferPool* pool = nullptr)
+    {
+        return create(size, [data, size](uint8_t* bytes)
+                      { std::memcpy(bytes, data, size); }, pool);
+    }
+
+    /**
+     * @brief Create a buffer and fill it before it becomes immutable.
+     * @tparam Filler Callable taking `uint8_t*` that writes exactly `size` bytes.
+     * @param size The number of bytes.
+     * @param fill The filler.
+     * @param pool Pool providing the storage, `nullptr` to allocate directly.
+     * @return The buffer.
+     */
+    template<typename Filler>
+    static Buffer create(const std::size_t size, Filler fill, BufferPool* pool = nullptr)
+    {
+        Detail::BufferBlock* block{pool != nullptr ? pool->allocate(size) : BufferPool::create(nullptr, size)};
+        fill(block->bytes());
+        return Buffer{block, block->bytes(), size};
+    }
+
+    ~Buffer()
+    {
+        reset();
+    }
+
+    Buffer(const Buffer& other)
+        : m_block{other.m_block}
+        , m_data{other.m_data}
+        , m_size{other.m_size}
+    {
+        if (m_block != nullptr)
+        {
+            Detail::retain(m_block);
+        }
+    }
+
+    Buffer& operator=(const Buffer& other)
+    {
+        if (this != &other)
+        {
+            Buffer copy{other};
+            swap(copy);
+        }
+        return *this;
+    }
+
+    Buffer(Buffer&& other) noexcept
+        : m_block{std::exchange(other.m_block, nullptr)}
+        , m_data{std::exchange(other.m_data, nullptr)}
+        , m_size{std::exchange(other.m_size, 0)}
+    {
+    }
+
+    Buffer& operator=(Buffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            swap(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Merge the counts of buffers created on the calling thread and dropped elsewhere.
+     *
+     * Happens on every release by the creating thread and when it exits. A thread that created
+     * buffers and then stops using them for a long time can call this to free them sooner.
+     */
+    static void mergePending()
+    {
+        if (Detail::t_owner != nullptr)
+        {
+            Detail::drainInbox(Detail::t_owner);
+        }
+    }
+
+    /**
+     * @brief A buffer sharing a sub-range of the bytes, clamped to this buffer.
+     * @param offset First byte of the slice.
+     * @param length Number of bytes.
+     * @return The slice.
+     */
+    Buffer slice(const std::size_t offset, const std::size_t length) const
+    {
+        const std::size_t start{std::min(offset, m_size)};
+        const std::size_t count{std::min(length, m_size - start)};
+        if (count == 0)
+        {
+            return Buffer{};
+        }
+        Buffer result{*this};
+        result.m_data += start;
+        result.m_size = count;
+        return result;
+    }
+
+    /**
+     * @brief Drop the reference, leaving an empty buffer.
+     */
+    void reset()
+    {
+        if (m_block != nullptr)
+        {
+            Detail::release(m_block);
+        }
+        m_block = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* data() const
+    {
+        return m_data;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void swap(Buffer& other) noexcept
+    {
+        std::swap(m_block, other.m_block);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+
+private:
+    Detail::BufferBlock* m_block{nullptr};
+    const uint8_t* m_data{nullptr};
+    std::size_t m_size{0};
+
+    Buffer(Detail::BufferBlock* block, const uint8_t* data, const std::size_t size)
+        : m_block{block}
+        , m_data{data}
+        , m_size{size}
+    {
+    }
+};
+
+} // namespace Common
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <tuple>
 
 /**
  * @brief A macro to indicate that a function parameter is intentionally unused.
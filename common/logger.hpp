@@ -1,7 +1,239 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <ostream>
+#include <streambuf>
+#include <string>
 
-#define LOG_INFO(message) std::cout << message << std::endl;
-#define LOG_DEBUG(message) std::cout << message << std::endl;
-#define LOG_WARNING(message) std::cerr << message << std::endl;
-#define LOG_ERROR(message) std::cerr << message << std::endl;
\ No newline at end of file
+#ifndef LOG_RATE_LIMIT_BURST
+#define LOG_RATE_LIMIT_BURST 5 ///< Messages per call site and window before suppression starts.
+#endif
+
+#ifndef LOG_RATE_LIMIT_WINDOW_MS
+#define LOG_RATE_LIMIT_WINDOW_MS 1000 ///< Length of a rate limit window.
+#endif
+
+namespace Logger
+{
+
+/**
+ * @brief Severity of a log message.
+ */
+enum class Level : uint8_t
+{
+    DEBUG = 0,
+    INFO = 1,
+    WARNING = 2,
+    ERROR = 3
+};
+
+/**
+ * @brief Destination for log messages that replaces `std::cout`/`std::cerr` while installed.
+ *
+ * `write` is called concurrently from every logging thread and must be thread-safe.
+ */
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+
+    /**
+     * @brief Write one message.
+     * @param level Severity of the message.
+     * @param text The formatted message, without a line break.
+     * @param length Length of the message in bytes.
+     */
+    virtual void write(const Level level, const char* text, const std::size_t length) = 0;
+
+    /**
+     * @brief Push buffered messages to their destination from a fatal signal handler.
+     *
+     * Must only use async-signal-safe operations. Does nothing by default.
+     */
+    virtual void flushFromSignal()
+    {
+    }
+};
+
+/**
+ * @brief Slot holding the installed sink.
+ */
+inline std::atomic<Sink*>& sinkSlot()
+{
+    static std::atomic<Sink*> sink{nullptr};
+    return sink;
+}
+
+/**
+ * @brief The installed sink.
+ * @return The sink, `nullptr` if messages go to the standard streams.
+ */
+inline Sink* sink()
+{
+    return sinkSlot().load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Install a sink for every log macro, or `nullptr` to go back to the standard streams.
+ *
+ * The sink must stay alive until it is uninstalled and no thread is logging any more.
+ *
+ * @param sink The sink to install.
+ * @return The previously installed sink.
+ */
+inline Sink* setSink(Sink* sink)
+{
+    return sinkSlot().exchange(sink, std::memory_order_acq_rel);
+}
+
+/**
+ * @brief Per-thread buffer a message is formatted into before it is handed to the sink.
+ *
+ * Cleared after every message but keeps its capacity, so formatting does not allocate once the
+ * buffer has grown to the longest message of the thread.
+ */
+class LineBuffer : public std::streambuf
+{
+public:
+    std::ostream stream{this}; ///< Formats into this buffer.
+
+    const std::string& text() const
+    {
+        return m_text;
+    }
+
+    void clear()
+    {
+        m_text.clear();
+    }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            m_text.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* text, std::streamsize length) override
+    {
+        m_text.append(text, static_cast<std::size_t>(length));
+        return length;
+    }
+
+private:
+    std::string m_text{};
+};
+
+/**
+ * @brief The line buffer of the calling thread.
+ */
+inline LineBuffer& threadBuffer()
+{
+    thread_local LineBuffer buffer{};
+    return buffer;
+}
+
+/**
+ * @brief Hand the contents of a line buffer to a sink and clear it.
+ */
+inline void submit(Sink& sink, const Level level, LineBuffer& buffer)
+{
+    sink.write(level, buffer.text().data(), buffer.text().size());
+    buffer.clear();
+}
+
+/**
+ * @brief Lock-free rate limit state of one logging call site.
+ *
+ * At most `burst` messages pass per window, the rest are counted. The next message that passes
+ * reports how many were suppressed before it. Constant-initialized, so a function-local static
+ * needs no guard.
+ */
+class RateLimiter
+{
+public:
+    constexpr RateLimiter() = default;
+
+    /**
+     * @brief Decide whether a message may be written now.
+     * @param suppressed Set to the number of messages suppressed since the last one that passed.
+     * @param burst Messages allowed per window.
+     * @param window_ms Length of a window in milliseconds.
+     * @return `true` if the message should be written.
+     */
+    bool allow(uint64_t& suppressed, const uint32_t burst = LOG_RATE_LIMIT_BURST,
+               const int64_t window_ms = LOG_RATE_LIMIT_WINDOW_MS)
+    {
+        const int64_t now{std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count()};
+        int64_t start{m_window_start.load(std::memory_order_relaxed)};
+        if (now - start >= window_ms && m_window_start.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        {
+            m_emitted.store(0, std::memory_order_relaxed);
+        }
+        if (m_emitted.fetch_add(1, std::memory_order_relaxed) < burst)
+        {
+            suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+private:
+    std::atomic<int64_t> m_window_start{INT64_MIN / 2}; ///< First window opens on the first call.
+    std::atomic<uint32_t> m_emitted{0};                 ///< Messages written in the current window.
+    std::atomic<uint64_t> m_suppressed{0};              ///< Messages dropped since the last report.
+};
+
+} // namespace Logger
+
+#define LOG_WRITE(level, output, message)                               \
+    {                                                                   \
+        ::Logger::Sink* log_sink{::Logger::sink()};                     \
+        if (log_sink == nullptr)                                        \
+        {                                                               \
+            output << message << std::endl;                             \
+        }                                                               \
+        else                                                            \
+        {                                                               \
+            ::Logger::LineBuffer& log_buffer{::Logger::threadBuffer()}; \
+            log_buffer.stream << message;                               \
+            ::Logger::submit(*log_sink, level, log_buffer);             \
+        }                                                               \
+    }
+
+#define LOG_INFO(message) LOG_WRITE(::Logger::Level::INFO, std::cout, message)
+#define LOG_DEBUG(message) LOG_WRITE(::Logger::Level::DEBUG, std::cout, message)
+#define LOG_WARNING(message) LOG_WRITE(::Logger::Level::WARNING, std::cerr, message)
+#define LOG_ERROR(message) LOG_WRITE(::Logger::Level::ERROR, std::cerr, message)
+
+#define LOG_RATE_LIMITED(level, output, message)                                                  \
+    {                                                                                             \
+        static ::Logger::RateLimiter log_rate_limiter{};                                          \
+        uint64_t log_suppressed{0};                                                               \
+        if (log_rate_limiter.allow(log_suppressed))                                               \
+        {                                                                                         \
+            if (log_suppressed > 0)                                                               \
+            {                                                                                     \
+                LOG_WRITE(level, output, message << " [repeated " << log_suppressed << " times]") \
+            }                                                                                     \
+            else                                                                                  \
+            {                                                                                     \
+                LOG_WRITE(level, output, message)                                                 \
+            }                                                                                     \
+        }                                                                                         \
+    }
+
+// Same as the plain macros, but every call site writes at most LOG_RATE_LIMIT_BURST messages per
+// LOG_RATE_LIMIT_WINDOW_MS and reports how many it suppressed with the next message it writes.
+#define LOG_INFO_RATE_LIMITED(message) LOG_RATE_LIMITED(::Logger::Level::INFO, std::cout, message)
+#define LOG_DEBUG_RATE_LIMITED(message) LOG_RATE_LIMITED(::Logger::Level::DEBUG, std::cout, message)
+#define LOG_WARNING_RATE_LIMITED(message) LOG_RATE_LIMITED(::Logger::Level::WARNING, std::cerr, message)
+#define LOG_ERROR_RATE_LIMITED(message) LOG_RATE_LIMITED(::Logger::Level::ERROR, std::cerr, message)
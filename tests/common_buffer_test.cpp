@@ -0,0 +1,136 @@
+#include "common/buffer.hpp"
+#include "thread_safe/queue.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Common;
+
+// Create a buffer holding a string
+Buffer bufferOf(const std::string &text, BufferPool *pool = nullptr) { return Buffer::copyOf(text.data(), text.size(), pool); }
+
+// Read a buffer back as a string
+std::string textOf(const Buffer &buffer) { return std::string(reinterpret_cast<const char *>(buffer.data()), buffer.size()); }
+
+// Copies and slices share the bytes
+TEST(BufferTest, CopyAndSlice) {
+    Buffer buffer = bufferOf("hello world");
+    EXPECT_EQ(textOf(buffer), "hello world");
+
+    Buffer copy = buffer;
+    EXPECT_EQ(copy.data(), buffer.data());
+
+    Buffer world = buffer.slice(6, 100);
+    EXPECT_EQ(textOf(world), "world");
+    EXPECT_EQ(world.data(), buffer.data() + 6);
+    EXPECT_EQ(textOf(world.slice(1, 3)), "orl");
+    EXPECT_TRUE(buffer.slice(20, 5).empty());
+
+    Buffer moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(textOf(moved), "hello world");
+}
+
+// Storage returns to the pool once the last slice is gone, and is reused
+TEST(BufferTest, PoolRecycles) {
+    BufferPool pool;
+    Buffer slice;
+    {
+        Buffer buffer = bufferOf("pooled payload", &pool);
+        slice = buffer.slice(0, 6);
+    }
+    EXPECT_EQ(pool.cached(), 0u);
+    EXPECT_EQ(textOf(slice), "pooled");
+    slice.reset();
+    EXPECT_EQ(pool.cached(), 1u);
+
+    Buffer reused = bufferOf("again", &pool);
+    EXPECT_EQ(pool.cached(), 0u);
+    reused.reset();
+    EXPECT_EQ(pool.cached(), 1u);
+}
+
+// Buffers created here and dropped on another thread are freed after merging
+TEST(BufferTest, DroppedByOtherThread) {
+    constexpr int COUNT = 32;
+    BufferPool pool;
+    std::vector<Buffer> buffers;
+    for (int i = 0; i < COUNT; ++i) {
+        buffers.push_back(bufferOf("payload " + std::to_string(i), &pool));
+    }
+    std::thread consumer([&buffers]() { buffers.clear(); });
+    consumer.join();
+    Buffer::mergePending();
+    EXPECT_EQ(pool.outstanding(), 0u);
+    EXPECT_EQ(pool.cached(), static_cast<size_t>(COUNT));
+}
+
+// Buffers outliving the thread that created them are freed by the last holder
+TEST(BufferTest, OwnerExitsFirst) {
+    constexpr int COUNT = 32;
+    BufferPool pool;
+    std::vector<Buffer> buffers;
+    std::thread producer([&]() {
+        for (int i = 0; i < COUNT; ++i) {
+            Buffer buffer = bufferOf("payload", &pool);
+            buffers.push_back(buffer);
+            buffers.push_back(buffer.slice(0, 3));
+        }
+    });
+    producer.join();
+    EXPECT_EQ(pool.outstanding(), static_cast<size_t>(COUNT));
+    buffers.clear();
+    EXPECT_EQ(pool.cached(), static_cast<size_t>(COUNT));
+}
+
+// Buffers handed through a queue to several consumers are all freed exactly once
+TEST(BufferTest, ThroughQueue) {
+    constexpr int COUNT = 2000;
+    constexpr int CONSUMERS = 3;
+    BufferPool pool(COUNT);
+    ThreadSafe::Queue<Buffer>::Settings settings;
+    settings.control = ThreadSafe::Queue<Buffer>::Control::PUSH;
+    ThreadSafe::Queue<Buffer> queue(settings);
+    queue.openPush();
+
+    std::atomic<size_t> bytes{0};
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < CONSUMERS; ++c) {
+        consumers.emplace_back([&]() {
+            Buffer buffer;
+            while (queue.pop(buffer)) {
+                Buffer copy = buffer.slice(1, buffer.size());
+                bytes += copy.size() + 1;
+                buffer.reset();
+            }
+        });
+    }
+    std::vector<Buffer> kept;
+    for (int i = 0; i < COUNT; ++i) {
+        Buffer buffer = bufferOf("message " + std::to_string(i), &pool);
+        queue.push(buffer);
+        if (i % 2 == 0) {
+            kept.push_back(std::move(buffer));
+        }
+    }
+    queue.closePush();
+    for (auto &consumer : consumers) {
+        consumer.join();
+    }
+    kept.clear();
+    Buffer::mergePending();
+
+    size_t expected = 0;
+    for (int i = 0; i < COUNT; ++i) {
+        expected += std::string("message " + std::to_string(i)).size();
+    }
+    EXPECT_EQ(bytes.load(), expected);
+    EXPECT_EQ(pool.outstanding(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+#include "common/logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes the same warning many times from one call site
+void logStorm(int count) {
+    for (int i = 0; i < count; ++i) {
+        LOG_WARNING_RATE_LIMITED("Storm warning " << i);
+    }
+}
+
+// Count the lines written to a stream
+int countLines(const std::string &text) {
+    int lines = 0;
+    for (char c : text) {
+        if (c == '\n') {
+            ++lines;
+        }
+    }
+    return lines;
+}
+
+// Only the burst of a storm reaches the stream
+TEST(LoggerTest, RateLimitedMacroSuppressesStorm) {
+    std::ostringstream captured;
+    std::streambuf *original = std::cerr.rdbuf(captured.rdbuf());
+    logStorm(1000);
+    std::cerr.rdbuf(original);
+
+    EXPECT_EQ(countLines(captured.str()), LOG_RATE_LIMIT_BURST);
+    EXPECT_NE(captured.str().find("Storm warning 0"), std::string::npos);
+}
+
+// Suppressed messages are reported by the first message of the next window
+TEST(LoggerTest, RateLimiterReportsSuppressed) {
+    Logger::RateLimiter limiter;
+    uint64_t suppressed = 0;
+    constexpr uint32_t BURST = 2;
+    constexpr int64_t WINDOW_MS = 50;
+
+    EXPECT_TRUE(limiter.allow(suppressed, BURST, WINDOW_MS));
+    EXPECT_TRUE(limiter.allow(suppressed, BURST, WINDOW_MS));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FALSE(limiter.allow(suppressed, BURST, WINDOW_MS));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(WINDOW_MS + 10));
+    EXPECT_TRUE(limiter.allow(suppressed, BURST, WINDOW_MS));
+    EXPECT_EQ(suppressed, 3u);
+    EXPECT_TRUE(limiter.allow(suppressed, BURST, WINDOW_MS));
+    EXPECT_EQ(suppressed, 0u);
+}
+
+// Concurrent callers share the budget of one call site
+TEST(LoggerTest, RateLimiterConcurrent) {
+    Logger::RateLimiter limiter;
+    constexpr uint32_t BURST = 10;
+    constexpr int THREADS = 4;
+    constexpr int CALLS = 1000;
+    std::atomic<int> allowed{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&]() {
+            uint64_t suppressed = 0;
+            for (int i = 0; i < CALLS; ++i) {
+                if (limiter.allow(suppressed, BURST, 60000)) {
+                    ++allowed;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(allowed.load(), static_cast<int>(BURST));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,161 @@
+#include "thread_safe/allocation_hooks.hpp"
+#include "thread_safe/queue.hpp"
+#include "thread_safe/thread.hpp"
+#include "thread_safe/variable.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+/**
+ * @brief Test that allocations and deallocations are counted for the calling thread.
+ */
+TEST(AllocationHooksTest, CountsThreadAllocations)
+{
+    const AllocationCounters process_start = processAllocations();
+    AllocationScope scope;
+    void* ptr = ::operator new(100);
+    AllocationCounters counters = scope.counters();
+    EXPECT_EQ(counters.allocations, 1u);
+    EXPECT_EQ(counters.bytes, 100u);
+    ::operator delete(ptr);
+    EXPECT_EQ(scope.counters().deallocations, 1u);
+
+    // Allocations of other threads are not counted for this one.
+    std::atomic<bool> go{false};
+    std::thread other([&go]()
+                      {
+        while (!go)
+        {
+            std::this_thread::yield();
+        }
+        ::operator delete(::operator new(16)); });
+    const AllocationCounters before_other = threadAllocations();
+    go = true;
+    other.join();
+    EXPECT_EQ((threadAllocations() - before_other).allocations, 0u);
+    EXPECT_GE((processAllocations() - process_start).allocations, 2u);
+}
+
+/**
+ * @brief Test that a NoAllocationScope counts violations and can be nested.
+ */
+TEST(AllocationHooksTest, NoAllocationScopeCountsViolations)
+{
+    NoAllocationScope outer;
+    EXPECT_EQ(outer.violations(), 0u);
+    {
+        NoAllocationScope inner;
+        ::operator delete(::operator new(8));
+        EXPECT_EQ(inner.violations(), 1u);
+    }
+    EXPECT_EQ(outer.violations(), 1u);
+}
+
+/**
+ * @brief Test that the abort policy stops the process at the allocation.
+ */
+TEST(AllocationHooksTest, NoAllocationScopeAborts)
+{
+    EXPECT_DEATH(
+        {
+            NoAllocationScope scope(NoAllocationScope::Policy::ABORT);
+            ::operator delete(::operator new(8));
+        },
+        "Allocation inside a NoAllocationScope");
+}
+
+/**
+ * @brief Test that push and pop allocate nothing once the queue storage has grown.
+ */
+TEST(AllocationHooksTest, QueueSteadyState)
+{
+    constexpr int OPERATIONS = 10000;
+    ThreadSafe::Queue<int>::Settings settings;
+    settings.size = 64;
+    settings.real_time = true;
+    ThreadSafe::Queue<int> queue(settings);
+    int value = 0;
+
+    AllocationScope scope;
+    {
+        NoAllocationScope no_allocation;
+        for (int i = 0; i < OPERATIONS; ++i)
+        {
+            ASSERT_TRUE(queue.push(i));
+            ASSERT_TRUE(queue.pop(value));
+        }
+        EXPECT_EQ(no_allocation.violations(), 0u);
+    }
+    const double per_operation = scope.perOperation(OPERATIONS);
+    RecordProperty("allocations_per_operation", std::to_string(per_operation));
+    EXPECT_EQ(per_operation, 0.0);
+}
+
+/**
+ * @brief Test that the loop of a running Thread allocates nothing per iteration.
+ */
+TEST(AllocationHooksTest, ThreadLoopSteadyState)
+{
+    constexpr uint64_t WARM_UP = 100;
+    constexpr uint64_t ITERATIONS = 10000;
+    std::atomic<uint64_t> iteration{0};
+    std::atomic<uint64_t> allocations{0};
+    AllocationCounters start{};
+
+    Thread<bool> thread("allocation-loop");
+    thread.invoke([&]() -> bool
+                  {
+        const uint64_t current = ++iteration;
+        if (current == WARM_UP)
+        {
+            start = threadAllocations();
+        }
+        else if (current == WARM_UP + ITERATIONS)
+        {
+            allocations = (threadAllocations() - start).allocations;
+        }
+        return true; });
+    thread.setPredicate([&]() -> bool
+                        { return iteration < WARM_UP + ITERATIONS; });
+    ASSERT_TRUE(thread.start(RunMode::LOOP));
+    while (iteration < WARM_UP + ITERATIONS)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    thread.stop();
+    RecordProperty("allocations_per_iteration", std::to_string(static_cast<double>(allocations) / ITERATIONS));
+    EXPECT_EQ(allocations.load(), 0u);
+}
+
+/**
+ * @brief Test that Variable::invoke adds no allocations of its own.
+ */
+TEST(AllocationHooksTest, VariableInvokeSteadyState)
+{
+    constexpr int OPERATIONS = 10000;
+    Variable<std::vector<int>> variable;
+    variable.invoke([](std::vector<int>& values)
+                    { values.reserve(1); });
+
+    NoAllocationScope no_allocation;
+    for (int i = 0; i < OPERATIONS; ++i)
+    {
+        variable.invoke([i](std::vector<int>& values)
+                        {
+            values.push_back(i);
+            values.pop_back(); });
+    }
+    EXPECT_EQ(no_allocation.violations(), 0u);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,99 @@
+#include "thread_safe/batch_controller.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+BatchController::Settings testSettings()
+{
+    BatchController::Settings settings;
+    settings.latency_budget_us = 1000;
+    settings.min_batch = 2;
+    settings.max_batch = 20;
+    settings.initial_batch = 8;
+    settings.batch_step = 2;
+    settings.max_linger_us = 300;
+    settings.linger_step_us = 100;
+    return settings;
+}
+
+} // namespace
+
+/**
+ * @brief Test that full batches within the budget grow the batch size and the linger time additively.
+ */
+TEST(BatchControllerTest, GrowsWhileFallingBehind)
+{
+    BatchController controller(testSettings());
+    EXPECT_EQ(controller.batchSize(), 8u);
+    EXPECT_EQ(controller.lingerUs(), 0u);
+
+    controller.record(8, 0, std::chrono::microseconds(100)); // Full batch.
+    EXPECT_EQ(controller.batchSize(), 10u);
+    EXPECT_EQ(controller.lingerUs(), 100u);
+    controller.record(3, 50, std::chrono::microseconds(100)); // Partial, but a backlog is left.
+    EXPECT_EQ(controller.batchSize(), 12u);
+    EXPECT_EQ(controller.lingerUs(), 200u);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        controller.record(controller.batchSize(), 50, std::chrono::microseconds(100));
+    }
+    EXPECT_EQ(controller.batchSize(), 20u);  // Capped by max_batch.
+    EXPECT_EQ(controller.lingerUs(), 300u); // Capped by max_linger_us.
+
+    // Processing leaves only 50 us of the budget for lingering.
+    BatchController slow(testSettings());
+    slow.record(8, 0, std::chrono::microseconds(950));
+    EXPECT_EQ(slow.batchSize(), 10u);
+    EXPECT_EQ(slow.lingerUs(), 50u);
+}
+
+/**
+ * @brief Test that a batch over the latency budget cuts both values multiplicatively.
+ */
+TEST(BatchControllerTest, ShrinksOverBudget)
+{
+    BatchController controller(testSettings());
+    controller.record(8, 10, std::chrono::microseconds(100));
+    controller.record(10, 10, std::chrono::microseconds(100));
+    ASSERT_EQ(controller.batchSize(), 12u);
+    ASSERT_EQ(controller.lingerUs(), 200u);
+
+    controller.record(12, 10, std::chrono::microseconds(900)); // 200 + 900 > 1000.
+    EXPECT_EQ(controller.batchSize(), 6u);
+    EXPECT_EQ(controller.lingerUs(), 100u);
+    for (int i = 0; i < 5; ++i)
+    {
+        controller.record(controller.batchSize(), 10, std::chrono::microseconds(5000));
+    }
+    EXPECT_EQ(controller.batchSize(), 2u); // Floored at min_batch.
+}
+
+/**
+ * @brief Test that partial batches draining the queue remove the linger time, keeping the batch size.
+ */
+TEST(BatchControllerTest, StopsLingeringAtLowLoad)
+{
+    BatchController controller(testSettings());
+    for (int i = 0; i < 3; ++i)
+    {
+        controller.record(controller.batchSize(), 10, std::chrono::microseconds(100));
+    }
+    ASSERT_EQ(controller.lingerUs(), 300u);
+    const std::size_t batch = controller.batchSize();
+
+    for (int i = 0; i < 20; ++i)
+    {
+        controller.record(1, 0, std::chrono::microseconds(10));
+    }
+    EXPECT_EQ(controller.lingerUs(), 0u);
+    EXPECT_EQ(controller.batchSize(), batch);
+
+    controller.record(0, 100, std::chrono::microseconds(100000)); // Empty pops are ignored.
+    EXPECT_EQ(controller.batchSize(), batch);
+}
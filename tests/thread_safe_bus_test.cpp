@@ -0,0 +1,131 @@
+#include "thread_safe/bus.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+// Every subscriber of a topic receives the same payload object
+TEST(BusTest, FanOutSharesPayload) {
+    Bus<std::string> bus;
+    Bus<std::string>::SubscriberSettings settings;
+    auto first = bus.subscribe("news", settings);
+    auto second = bus.subscribe("news", settings);
+    auto other = bus.subscribe("sports", settings);
+    EXPECT_EQ(bus.subscribers("news"), 2u);
+
+    auto message = std::make_shared<const std::string>("hello");
+    EXPECT_EQ(bus.publish("news", message), 2u);
+
+    Bus<std::string>::Message received_first;
+    Bus<std::string>::Message received_second;
+    ASSERT_TRUE(first->receive(received_first, 100));
+    ASSERT_TRUE(second->receive(received_second, 100));
+    EXPECT_EQ(received_first.get(), message.get());
+    EXPECT_EQ(received_second.get(), message.get());
+    EXPECT_EQ(other->pending(), 0u);
+}
+
+// Publishing to a topic without subscribers delivers nothing
+TEST(BusTest, NoSubscribers) {
+    Bus<int> bus;
+    EXPECT_EQ(bus.emplace("empty", 1), 0u);
+    EXPECT_EQ(bus.subscribers("empty"), 0u);
+}
+
+// A destroyed subscription stops receiving and wakes its receiver
+TEST(BusTest, Unsubscribe) {
+    Bus<int> bus;
+    Bus<int>::SubscriberSettings settings;
+    auto subscription = bus.subscribe("topic", settings);
+    auto kept = bus.subscribe("topic", settings);
+
+    std::thread receiver([&]() {
+        Bus<int>::Message message;
+        EXPECT_FALSE(subscription->receive(message));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    subscription->unsubscribe();
+    receiver.join();
+
+    EXPECT_EQ(bus.subscribers("topic"), 1u);
+    EXPECT_EQ(bus.emplace("topic", 5), 1u);
+    subscription.reset();
+    EXPECT_EQ(kept->pending(), 1u);
+}
+
+// Each subscriber applies its own discard policy
+TEST(BusTest, PerSubscriberDiscard) {
+    Bus<int> bus;
+    Bus<int>::SubscriberSettings oldest;
+    oldest.capacity = 4;
+    oldest.discard = Bus<int>::Discard::DISCARD_OLDEST;
+    Bus<int>::SubscriberSettings newest;
+    newest.capacity = 4;
+    newest.discard = Bus<int>::Discard::DISCARD_NEWEST;
+    Bus<int>::SubscriberSettings blocking;
+    blocking.capacity = 4;
+    blocking.discard = Bus<int>::Discard::NO_DISCARD;
+    auto keeps_latest = bus.subscribe("topic", oldest);
+    auto keeps_first = bus.subscribe("topic", newest);
+    auto blocks = bus.subscribe("topic", blocking);
+
+    for (int i = 0; i < 10; ++i) {
+        bus.emplace("topic", i);
+    }
+
+    std::vector<Bus<int>::Message> messages;
+    EXPECT_EQ(keeps_latest->receiveBatch(messages, 10, 0), 4u);
+    EXPECT_EQ(*messages.front(), 6);
+    EXPECT_EQ(keeps_latest->dropped(), 6u);
+
+    messages.clear();
+    EXPECT_EQ(keeps_first->receiveBatch(messages, 10, 0), 4u);
+    EXPECT_EQ(*messages.front(), 0);
+    EXPECT_EQ(*messages.back(), 3);
+    EXPECT_EQ(keeps_first->dropped(), 6u);
+
+    messages.clear();
+    EXPECT_EQ(blocks->receiveBatch(messages, 10, 0), 4u);
+    EXPECT_EQ(blocks->dropped(), 6u);
+}
+
+// Concurrent publishers, subscribers coming and going
+TEST(BusTest, ConcurrentPublishSubscribe) {
+    constexpr int MESSAGES = 2000;
+    Bus<int> bus;
+    Bus<int>::SubscriberSettings settings;
+    settings.capacity = MESSAGES;
+    auto steady = bus.subscribe("topic", settings);
+    std::atomic<bool> running{true};
+
+    std::thread churn([&]() {
+        while (running) {
+            auto temporary = bus.subscribe("topic", settings);
+            std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> publishers;
+    for (int p = 0; p < 2; ++p) {
+        publishers.emplace_back([&]() {
+            for (int i = 0; i < MESSAGES / 2; ++i) {
+                bus.emplace("topic", i);
+            }
+        });
+    }
+    for (auto &publisher : publishers) {
+        publisher.join();
+    }
+    running = false;
+    churn.join();
+
+    EXPECT_EQ(steady->pending(), static_cast<size_t>(MESSAGES));
+    EXPECT_EQ(bus.subscribers("topic"), 1u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+#include "thread_safe/cpu_topology.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace ThreadSafe;
+
+// Temporary cgroup-like directory, removed with its files at the end of the test
+class FakeCgroup
+{
+public:
+    FakeCgroup()
+    {
+        char path[] = "/tmp/cgroup_test_XXXXXX";
+        m_dir = ::mkdtemp(path);
+    }
+
+    ~FakeCgroup()
+    {
+        for (const char* name : {"cpu.max", "cpu.cfs_quota_us", "cpu.cfs_period_us", "cpuset.cpus", "cpuset.cpus.effective"})
+        {
+            ::unlink((m_dir + "/" + name).c_str());
+        }
+        ::rmdir(m_dir.c_str());
+    }
+
+    void write(const std::string& name, const std::string& content) const
+    {
+        std::ofstream file{m_dir + "/" + name};
+        file << content << "\n";
+    }
+
+    const std::string& dir() const
+    {
+        return m_dir;
+    }
+
+private:
+    std::string m_dir;
+};
+
+/**
+ * @brief Test that the budget is within the CPUs of the host.
+ */
+TEST(CpuTopologyTest, BudgetWithinHardware)
+{
+    const uint32_t budget = cpuBudget();
+    EXPECT_GE(budget, 1u);
+    if (std::thread::hardware_concurrency() > 0)
+    {
+        EXPECT_LE(budget, std::thread::hardware_concurrency());
+    }
+    EXPECT_EQ(cpuBudget(), budget);
+}
+
+/**
+ * @brief Test the cgroup v2 quota, rounded up to whole CPUs.
+ */
+TEST(CpuTopologyTest, CgroupV2Quota)
+{
+    FakeCgroup cgroup;
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 0u);
+    cgroup.write("cpu.max", "max 100000");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 0u);
+    cgroup.write("cpu.max", "400000 100000");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 4u);
+    cgroup.write("cpu.max", "150000 100000");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 2u);
+    cgroup.write("cpuset.cpus.effective", "0");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 1u);
+}
+
+/**
+ * @brief Test the cgroup v1 quota and cpuset.
+ */
+TEST(CpuTopologyTest, CgroupV1QuotaAndCpuset)
+{
+    FakeCgroup cgroup;
+    cgroup.write("cpu.cfs_quota_us", "-1");
+    cgroup.write("cpu.cfs_period_us", "100000");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 0u);
+    cgroup.write("cpuset.cpus", "0-3,8-11");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 8u);
+    cgroup.write("cpu.cfs_quota_us", "300000");
+    EXPECT_EQ(cgroupCpuLimit(cgroup.dir()), 3u);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
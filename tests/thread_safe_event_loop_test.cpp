@@ -0,0 +1,123 @@
+#include "thread_safe/event_loop.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+// Posted tasks run on the loop thread in the order they were posted
+TEST(EventLoopTest, PostRunsInOrder) {
+    EventLoop loop("loop");
+    std::vector<int> order;
+    std::promise<void> done;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(loop.post([&order, i]() { order.push_back(i); }));
+    }
+    loop.post([&]() {
+        EXPECT_TRUE(loop.isLoopThread());
+        done.set_value();
+    });
+    EXPECT_FALSE(loop.isLoopThread());
+    ASSERT_TRUE(loop.start());
+    done.get_future().wait();
+    ASSERT_EQ(order.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+    EXPECT_FALSE(loop.post(EventLoop::Task{}));
+}
+
+// Timers run by time, not by post order, and not before their time
+TEST(EventLoopTest, TimersRunByTime) {
+    EventLoop loop("timers");
+    ASSERT_TRUE(loop.start());
+    std::mutex lock;
+    std::vector<int> order;
+    std::promise<void> done;
+    const auto posted = EventLoop::Clock::now();
+    std::atomic<int64_t> elapsed_ms{0};
+    loop.postDelayed([&]() {
+        elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(EventLoop::Clock::now() - posted).count();
+        done.set_value();
+    }, 60);
+    loop.postDelayed([&]() { std::lock_guard<std::mutex> guard(lock); order.push_back(3); }, 40);
+    loop.postAt([&]() { std::lock_guard<std::mutex> guard(lock); order.push_back(1); }, posted + std::chrono::milliseconds(10));
+    loop.postDelayed([&]() { std::lock_guard<std::mutex> guard(lock); order.push_back(2); }, 20);
+    loop.post([&]() { std::lock_guard<std::mutex> guard(lock); order.push_back(0); });
+    done.get_future().wait();
+    EXPECT_GE(elapsed_ms.load(), 60);
+    std::lock_guard<std::mutex> guard(lock);
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+}
+
+// An earlier timer posted while the loop sleeps until a later one still runs on time
+TEST(EventLoopTest, EarlierTimerWakesLoop) {
+    EventLoop loop("wake");
+    ASSERT_TRUE(loop.start());
+    std::promise<void> late;
+    std::promise<void> early;
+    loop.postDelayed([&]() { late.set_value(); }, 2000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto posted = EventLoop::Clock::now();
+    loop.postDelayed([&]() { early.set_value(); }, 10);
+    early.get_future().wait();
+    EXPECT_LT(EventLoop::Clock::now() - posted, std::chrono::milliseconds(1000));
+    // The late timer is dropped by stop.
+    EXPECT_TRUE(loop.stop());
+}
+
+// Tasks posted from many threads all run, also those posted right before stop
+TEST(EventLoopTest, ManyPosters) {
+    constexpr int POSTERS = 4;
+    constexpr int COUNT = 5000;
+    EventLoop loop("posters");
+    ASSERT_TRUE(loop.start());
+    int executed = 0; // Only touched on the loop thread.
+    std::vector<std::thread> posters;
+    for (int p = 0; p < POSTERS; ++p) {
+        posters.emplace_back([&]() {
+            for (int i = 0; i < COUNT; ++i) {
+                loop.post([&executed]() { ++executed; });
+            }
+        });
+    }
+    for (auto &poster : posters) {
+        poster.join();
+    }
+    EXPECT_TRUE(loop.stop());
+    EXPECT_EQ(executed, POSTERS * COUNT);
+    EXPECT_FALSE(loop.stop());
+}
+
+// A timer callback can post further work, and the loop can be restarted
+TEST(EventLoopTest, RepostAndRestart) {
+    EventLoop loop("repost");
+    std::atomic<int> ticks{0};
+    std::promise<void> done;
+    std::function<void()> tick = [&]() {
+        if (++ticks == 5) {
+            done.set_value();
+            return;
+        }
+        loop.postDelayed(tick, 1);
+    };
+    ASSERT_TRUE(loop.start());
+    loop.post(tick);
+    done.get_future().wait();
+    EXPECT_TRUE(loop.stop());
+    EXPECT_EQ(ticks.load(), 5);
+
+    std::promise<void> again;
+    ASSERT_TRUE(loop.start());
+    loop.post([&]() { again.set_value(); });
+    again.get_future().wait();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+#include "thread_safe/fatal_handler.hpp"
+#include "thread_safe/thread.hpp"
+#include "thread_safe/thread_registry.hpp"
+#include <chrono>
+#include <csignal>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace ThreadSafe;
+
+// Read everything from a file descriptor until EOF
+std::string readAll(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(count));
+    }
+    return text;
+}
+
+// A running Thread is registered with its name and heartbeat, and leaves on stop
+TEST(FatalHandlerTest, ThreadRegistry) {
+    Thread<bool> thread("registered-worker", ThreadPriority::NORMAL);
+    thread.invoke([]() -> bool {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return true;
+    });
+    ASSERT_TRUE(thread.start(RunMode::LOOP));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    bool found = false;
+    int64_t heartbeat = 0;
+    ThreadRegistry::forEach([&](const ThreadRegistry::Entry &entry) {
+        if (std::string(entry.name) == "registered-worker") {
+            found = true;
+            heartbeat = entry.heartbeat_ns.load();
+        }
+    });
+    EXPECT_TRUE(found);
+    EXPECT_LT(ThreadRegistry::now() - heartbeat, 1000000000);
+
+    thread.stop();
+    found = false;
+    ThreadRegistry::forEach([&](const ThreadRegistry::Entry &entry) {
+        if (std::string(entry.name) == "registered-worker") {
+            found = true;
+        }
+    });
+    EXPECT_FALSE(found);
+}
+
+// A crashing process reports the signal, the registered threads and a backtrace, then dies of the signal
+TEST(FatalHandlerTest, ReportOnCrash) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        ::close(fds[0]);
+        FatalHandler::Settings settings;
+        settings.fd = fds[1];
+        FatalHandler::install(settings);
+        static Thread<bool> worker("crash-worker", ThreadPriority::NORMAL);
+        worker.invoke([]() -> bool {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return true;
+        });
+        worker.start(RunMode::LOOP);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::raise(SIGSEGV);
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    const std::string report = readAll(fds[0]);
+    ::close(fds[0]);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+
+    ASSERT_TRUE(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGSEGV);
+    EXPECT_NE(report.find("Fatal signal 11 (SIGSEGV)"), std::string::npos) << report;
+    EXPECT_NE(report.find("\"crash-worker\" last heartbeat"), std::string::npos) << report;
+    EXPECT_NE(report.find("Backtrace:"), std::string::npos) << report;
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
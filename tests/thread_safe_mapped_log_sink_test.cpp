@@ -0,0 +1,168 @@
+#include "thread_safe/mapped_log_sink.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ThreadSafe;
+
+// Split a log into its lines
+std::vector<std::string> lines(const std::string &log) {
+    std::vector<std::string> result;
+    std::istringstream stream(log);
+    std::string line;
+    while (std::getline(stream, line)) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+// Text of a line after the level and timestamp prefix
+std::string message(const std::string &line) {
+    const size_t first = line.find(' ');
+    const size_t second = line.find(' ', first + 1);
+    return second == std::string::npos ? std::string() : line.substr(second + 1);
+}
+
+class MappedLogSinkTest : public ::testing::Test {
+protected:
+    std::string path = "/tmp/thread_safe_mapped_log_sink_test_" + std::to_string(::getpid()) + ".log";
+
+    void TearDown() override { std::remove(path.c_str()); }
+};
+
+// Messages are read back in order with their level
+TEST_F(MappedLogSinkTest, WriteAndRead) {
+    MappedLogSink sink;
+    ASSERT_TRUE(sink.open(path, 4096));
+    sink.write(Logger::Level::INFO, "first", 5);
+    sink.write(Logger::Level::ERROR, "second", 6);
+    sink.close();
+
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_EQ(log.size(), 2u);
+    EXPECT_EQ(log[0][0], 'I');
+    EXPECT_EQ(message(log[0]), "first");
+    EXPECT_EQ(log[1][0], 'E');
+    EXPECT_EQ(message(log[1]), "second");
+}
+
+// A full file keeps only the newest complete messages
+TEST_F(MappedLogSinkTest, WrapAround) {
+    MappedLogSink sink;
+    ASSERT_TRUE(sink.open(path, 256));
+    for (int i = 0; i < 100; ++i) {
+        const std::string text = "message " + std::to_string(i);
+        sink.write(Logger::Level::INFO, text.data(), text.size());
+    }
+    sink.close();
+
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_FALSE(log.empty());
+    EXPECT_LT(log.size(), 100u);
+    const int first = std::stoi(message(log.front()).substr(8));
+    for (size_t i = 0; i < log.size(); ++i) {
+        EXPECT_EQ(message(log[i]), "message " + std::to_string(first + static_cast<int>(i)));
+    }
+    EXPECT_EQ(message(log.back()), "message 99");
+}
+
+// Reopening a file with the same capacity continues after its last message
+TEST_F(MappedLogSinkTest, Reopen) {
+    {
+        MappedLogSink sink;
+        ASSERT_TRUE(sink.open(path, 1024));
+        sink.write(Logger::Level::INFO, "before", 6);
+    }
+    {
+        MappedLogSink sink;
+        ASSERT_TRUE(sink.open(path, 1024));
+        sink.write(Logger::Level::INFO, "after", 5);
+    }
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_EQ(log.size(), 2u);
+    EXPECT_EQ(message(log[0]), "before");
+    EXPECT_EQ(message(log[1]), "after");
+}
+
+// The log macros write into the installed sink instead of the standard streams
+TEST_F(MappedLogSinkTest, InstalledSink) {
+    MappedLogSink sink;
+    ASSERT_TRUE(sink.open(path, 4096));
+    Logger::setSink(&sink);
+    LOG_WARNING("Value is " << 42);
+    LOG_WARNING_RATE_LIMITED("Limited " << 7);
+    Logger::setSink(nullptr);
+    sink.close();
+
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_EQ(log.size(), 2u);
+    EXPECT_EQ(log[0][0], 'W');
+    EXPECT_EQ(message(log[0]), "Value is 42");
+    EXPECT_EQ(message(log[1]), "Limited 7");
+}
+
+// Messages survive the process being killed without closing the sink
+TEST_F(MappedLogSinkTest, SurvivesCrash) {
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        static MappedLogSink sink;
+        if (!sink.open(path, 4096)) {
+            ::_exit(1);
+        }
+        Logger::setSink(&sink);
+        LOG_ERROR("Last words");
+        std::abort();
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFSIGNALED(status));
+
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_EQ(log.size(), 1u);
+    EXPECT_EQ(message(log[0]), "Last words");
+}
+
+// Concurrent writers never interleave inside a message
+TEST_F(MappedLogSinkTest, ConcurrentWriters) {
+    constexpr int THREADS = 4;
+    constexpr int MESSAGES = 1000;
+    MappedLogSink sink;
+    ASSERT_TRUE(sink.open(path, 1 << 20));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&sink, t]() {
+            for (int i = 0; i < MESSAGES; ++i) {
+                const std::string text = "thread " + std::to_string(t) + " message " + std::to_string(i);
+                sink.write(Logger::Level::DEBUG, text.data(), text.size());
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    sink.close();
+
+    const auto log = lines(MappedLogSink::read(path));
+    ASSERT_EQ(log.size(), static_cast<size_t>(THREADS * MESSAGES));
+    std::vector<int> next(THREADS, 0);
+    for (const auto &line : log) {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(std::sscanf(message(line).c_str(), "thread %d message %d", &t, &i), 2) << line;
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, THREADS);
+        EXPECT_EQ(i, next[t]++);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include "thread_safe/parking_lot.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+/**
+ * @brief Park `count` threads one after another and record the order in which they wake up.
+ */
+std::vector<int> wakeOrder(ParkingLot::Policy policy, int count)
+{
+    ParkingLot lot(policy);
+    std::mutex lock;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i)
+    {
+        threads.emplace_back([&, i]()
+                             {
+            lot.park([]() { return false; }, ParkingLot::Clock::time_point::max());
+            std::lock_guard<std::mutex> guard{lock};
+            order.push_back(i); });
+        // Wait until this thread is parked so the parking order is deterministic.
+        while (lot.parked() != static_cast<std::size_t>(i + 1))
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        EXPECT_TRUE(lot.unparkOne());
+        while (true)
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            if (order.size() == static_cast<std::size_t>(i + 1))
+            {
+                break;
+            }
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return order;
+}
+
+} // namespace
+
+/**
+ * @brief Test that FIFO wakes the longest parked thread first.
+ */
+TEST(ParkingLotTest, FifoOrder)
+{
+    EXPECT_EQ(wakeOrder(ParkingLot::Policy::FIFO, 3), (std::vector<int>{0, 1, 2}));
+}
+
+/**
+ * @brief Test that LIFO wakes the most recently parked thread first.
+ */
+TEST(ParkingLotTest, LifoOrder)
+{
+    EXPECT_EQ(wakeOrder(ParkingLot::Policy::LIFO, 3), (std::vector<int>{2, 1, 0}));
+}
+
+/**
+ * @brief Test that every parked thread is woken under the affinity policy.
+ */
+TEST(ParkingLotTest, AffinityWakesEveryone)
+{
+    EXPECT_EQ(wakeOrder(ParkingLot::Policy::AFFINITY, 3).size(), 3u);
+}
+
+/**
+ * @brief Test for ready predicate, timeout and unparkAll.
+ */
+TEST(ParkingLotTest, ReadyTimeoutUnparkAll)
+{
+    ParkingLot lot;
+    EXPECT_FALSE(lot.unparkOne()); // Nobody parked.
+    EXPECT_TRUE(lot.park([]() { return true; }, ParkingLot::Clock::time_point::max()));
+    EXPECT_FALSE(lot.park([]() { return false; }, ParkingLot::Clock::now() + std::chrono::milliseconds(50)));
+
+    std::atomic<int> woken{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]()
+                             {
+            if (lot.park([]() { return false; }, ParkingLot::Clock::time_point::max())) {
+                ++woken;
+            } });
+    }
+    while (lot.parked() != 4)
+    {
+        std::this_thread::yield();
+    }
+    lot.unparkAll();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(woken.load(), 4);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,194 @@
+#include "thread_safe/pi_mutex.hpp"
+#include "thread_safe/thread.hpp"
+#include "thread_safe/wait.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <time.h>
+
+using namespace ThreadSafe;
+
+// Burn CPU time of the calling thread, time spent preempted does not count
+void spinCpu(std::chrono::milliseconds duration) {
+    auto cpuTime = []() {
+        timespec time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    };
+    const auto end = cpuTime() + duration;
+    while (cpuTime() < end) {
+    }
+}
+
+// Busy wait for wall-clock time, keeping lower priorities off the CPU
+void spinWall(std::chrono::milliseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// Set the priority of the calling thread, false if the process may not use SCHED_FIFO
+bool setPriority(ThreadPriority priority) {
+    setNaitiveThreadPriority(priority, currentNativeThreadHandle());
+    int policy = 0;
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    return policy == SCHED_FIFO && param.sched_priority == defaultNativeThreadPrioritys().at(priority);
+}
+
+// Runs the calling thread and every thread it starts on one CPU at SCHED_FIFO, restores on exit
+class RealTimeScope {
+public:
+    RealTimeScope() {
+        pthread_getschedparam(pthread_self(), &m_policy, &m_param);
+        if (sched_getaffinity(0, sizeof(m_affinity), &m_affinity) != 0) {
+            return;
+        }
+        cpu_set_t single;
+        CPU_ZERO(&single);
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &m_affinity)) {
+                CPU_SET(cpu, &single);
+                break;
+            }
+        }
+        m_pinned = sched_setaffinity(0, sizeof(single), &single) == 0;
+        m_valid = m_pinned && setPriority(ThreadPriority::HIGHEST);
+    }
+
+    ~RealTimeScope() {
+        pthread_setschedparam(pthread_self(), m_policy, &m_param);
+        if (m_pinned) {
+            sched_setaffinity(0, sizeof(m_affinity), &m_affinity);
+        }
+    }
+
+    bool valid() const { return m_valid; }
+
+private:
+    int m_policy = 0;
+    sched_param m_param{};
+    cpu_set_t m_affinity{};
+    bool m_pinned = false;
+    bool m_valid = false;
+};
+
+// Classic priority inversion: how long does a TIME_CRITICAL thread wait for a mutex that a LOWEST
+// thread holds for 20 ms of work, while a NORMAL thread hogs the only CPU for 200 ms
+std::chrono::milliseconds inversionLatency(bool inherit) {
+    PiMutex mutex(inherit);
+    std::atomic<bool> locked{false};
+    std::atomic<bool> mid_running{false};
+    std::chrono::steady_clock::duration latency{};
+
+    std::thread low([&]() {
+        setPriority(ThreadPriority::LOWEST);
+        std::lock_guard<PiMutex> lock(mutex);
+        locked = true;
+        spinCpu(std::chrono::milliseconds(20));
+    });
+    while (!locked) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Preempts the lock owner as soon as it is running.
+    std::thread mid([&]() {
+        setPriority(ThreadPriority::NORMAL);
+        mid_running = true;
+        spinWall(std::chrono::milliseconds(200));
+    });
+    while (!mid_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::thread high([&]() {
+        setPriority(ThreadPriority::TIME_CRITICAL);
+        const auto start = std::chrono::steady_clock::now();
+        std::lock_guard<PiMutex> lock(mutex);
+        latency = std::chrono::steady_clock::now() - start;
+    });
+    high.join();
+    mid.join();
+    low.join();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(latency);
+}
+
+// Lock, try_lock and unlock with and without priority inheritance
+TEST(PiMutexTest, LockAndTryLock) {
+    for (bool inherit : {true, false}) {
+        PiMutex mutex(inherit);
+        EXPECT_EQ(mutex.inheritsPriority(), inherit);
+        {
+            std::unique_lock<PiMutex> lock(mutex);
+            std::thread other([&]() { EXPECT_FALSE(mutex.try_lock()); });
+            other.join();
+        }
+        EXPECT_TRUE(mutex.try_lock());
+        mutex.unlock();
+    }
+}
+
+// Timed waits return on timeout and on notification
+TEST(PiMutexTest, ConditionVariable) {
+    PiMutex mutex;
+    PiConditionVariable condition;
+    bool ready = false;
+
+    std::unique_lock<PiMutex> lock(mutex);
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(condition.wait_for(lock, std::chrono::milliseconds(20), [&]() { return ready; }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    std::thread notifier([&]() {
+        std::lock_guard<PiMutex> guard(mutex);
+        ready = true;
+        condition.notify_one();
+    });
+    EXPECT_TRUE(condition.wait_for(lock, std::chrono::hours::max(), [&]() { return ready; }));
+    lock.unlock();
+    notifier.join();
+}
+
+// A priority-inheritance Wait wakes every waiter
+TEST(PiMutexTest, WaitWithPriorityInheritance) {
+    Wait wait(true);
+    std::atomic<bool> flag{false};
+    std::atomic<int> woken{0};
+    std::thread waiters[3];
+    for (auto &waiter : waiters) {
+        waiter = std::thread([&]() {
+            if (wait.waitFor(std::chrono::seconds(5), [&]() { return flag.load(); }) == Wait::Status::SUCCESS) {
+                ++woken;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    flag = true;
+    wait.notify();
+    for (auto &waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_EQ(woken.load(), 3);
+}
+
+// The lock owner is boosted past the medium-priority thread, so the wait stays near the 20 ms of work
+TEST(PiMutexTest, MixedPriorityLatency) {
+    RealTimeScope scope;
+    if (!scope.valid()) {
+        GTEST_SKIP() << "SCHED_FIFO or CPU affinity not permitted";
+    }
+    const auto inherited = inversionLatency(true);
+    const auto inverted = inversionLatency(false);
+    RecordProperty("inherit_ms", static_cast<int>(inherited.count()));
+    RecordProperty("no_inherit_ms", static_cast<int>(inverted.count()));
+    EXPECT_LT(inherited, std::chrono::milliseconds(100));
+    // Without inheritance the high-priority thread also waits for the medium one.
+    EXPECT_GE(inverted, std::chrono::milliseconds(100));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,301 @@
+#include "thread_safe/queue_capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+const std::string CAPTURE_PATH{"thread_safe_queue_capture_test.bin"};
+
+std::vector<CaptureRecord> loadCapture()
+{
+    std::vector<CaptureRecord> records;
+    EXPECT_TRUE(QueueCapture<int>::load(CAPTURE_PATH, records));
+    return records;
+}
+
+} // namespace
+
+/**
+ * @brief Test that every push is recorded in order with its payload, and nothing after stop.
+ */
+TEST(QueueCaptureTest, RecordsPushesWithPayload)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    QueueCapture<int> capture;
+    QueueCapture<int>::Settings settings;
+    settings.payload = true;
+    settings.flush_bytes = 64; // Exercise several writes.
+    ASSERT_TRUE(capture.start(queue, CAPTURE_PATH, settings));
+    EXPECT_FALSE(capture.start(queue, CAPTURE_PATH, settings));
+
+    std::thread producer([&queue]()
+                         {
+        for (int i = 0; i < 50; ++i)
+        {
+            queue.push(i);
+        } });
+    for (int i = 50; i < 100; ++i)
+    {
+        queue.push(i);
+    }
+    producer.join();
+    EXPECT_EQ(capture.records(), 100u);
+    ASSERT_TRUE(capture.stop());
+    queue.push(1000);
+    EXPECT_EQ(capture.records(), 100u);
+
+    const std::vector<CaptureRecord> records = loadCapture();
+    ASSERT_EQ(records.size(), 100u);
+    std::vector<bool> seen(100, false);
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        if (i > 0)
+        {
+            EXPECT_GE(records[i].offset_ns, records[i - 1].offset_ns);
+        }
+        EXPECT_EQ(records[i].size, sizeof(int));
+        int value = -1;
+        ASSERT_TRUE(Serializer<int>{}.deserialize(records[i].payload.data(), records[i].payload.size(), value));
+        ASSERT_GE(value, 0);
+        ASSERT_LT(value, 100);
+        seen[static_cast<std::size_t>(value)] = true;
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 100);
+    std::remove(CAPTURE_PATH.c_str());
+}
+
+/**
+ * @brief Test that sizes come from `size_of` and that payloads are left out by default.
+ */
+TEST(QueueCaptureTest, RecordsSizesWithoutPayload)
+{
+    Queue<std::string>::Settings queue_settings;
+    queue_settings.size = 2;
+    queue_settings.discard = Queue<std::string>::Discard::DISCARD_NEWEST;
+    Queue<std::string> queue(queue_settings);
+    QueueCapture<std::string> capture;
+    QueueCapture<std::string>::Settings settings;
+    settings.size_of = [](const std::string& elem) -> std::size_t
+    {
+        return elem.size();
+    };
+    ASSERT_TRUE(capture.start(queue, CAPTURE_PATH, settings));
+    EXPECT_TRUE(queue.push("a"));
+    EXPECT_TRUE(queue.push("bbbb"));
+    EXPECT_FALSE(queue.push("discarded")); // Rejected pushes are recorded as well.
+    ASSERT_TRUE(capture.stop());
+
+    std::vector<CaptureRecord> records;
+    ASSERT_TRUE(QueueCapture<std::string>::load(CAPTURE_PATH, records));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].size, 1u);
+    EXPECT_EQ(records[1].size, 4u);
+    EXPECT_EQ(records[2].size, 9u);
+    EXPECT_TRUE(records[0].admitted);
+    EXPECT_TRUE(records[1].admitted);
+    EXPECT_FALSE(records[2].admitted);
+    EXPECT_TRUE(records[0].payload.empty());
+    std::remove(CAPTURE_PATH.c_str());
+}
+
+/**
+ * @brief Test that a push blocked on a full queue is recorded when it arrived, and a timeout too.
+ */
+TEST(QueueCaptureTest, RecordsArrivalsDuringOverload)
+{
+    Queue<int>::Settings queue_settings;
+    queue_settings.size = 1;
+    Queue<int> queue(queue_settings);
+    QueueCapture<int> capture;
+    QueueCapture<int>::Settings settings;
+    settings.payload = true;
+    ASSERT_TRUE(capture.start(queue, CAPTURE_PATH, settings));
+    ASSERT_TRUE(queue.push(1));
+    EXPECT_FALSE(queue.push(2, 10)); // Times out on the full queue.
+
+    std::thread consumer([&queue]()
+                         {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        int elem{0};
+        queue.pop(elem); });
+    ASSERT_TRUE(queue.push(3)); // Blocks until the consumer made room.
+    consumer.join();
+    ASSERT_TRUE(capture.stop());
+
+    const std::vector<CaptureRecord> records = loadCapture();
+    ASSERT_EQ(records.size(), 3u);
+    std::vector<int> values;
+    for (const auto& record : records)
+    {
+        int value{0};
+        ASSERT_TRUE(Serializer<int>{}.deserialize(record.payload.data(), record.payload.size(), value));
+        values.push_back(value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(records[0].admitted);
+    EXPECT_FALSE(records[1].admitted);
+    EXPECT_TRUE(records[2].admitted);
+    // Stamped on arrival, well before the consumer made room.
+    EXPECT_LT(records[2].offset_ns - records[1].offset_ns, 40000000u);
+    std::remove(CAPTURE_PATH.c_str());
+}
+
+/**
+ * @brief Test that start replaces the arrival callback of the queue and stop removes it.
+ */
+TEST(QueueCaptureTest, StopDetachesCallback)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    uint32_t pushed{0};
+    queue.setArrivalCallback([&pushed](const int&, std::chrono::steady_clock::time_point, bool)
+                             { ++pushed; });
+    {
+        QueueCapture<int> capture;
+        ASSERT_TRUE(capture.start(queue, CAPTURE_PATH, QueueCapture<int>::Settings{}));
+        queue.push(1);
+        EXPECT_EQ(pushed, 0u);
+        ASSERT_TRUE(capture.stop());
+        queue.push(2);
+        EXPECT_EQ(capture.records(), 1u);
+
+        // Set after the capture stopped, the callback is left alone by its destructor.
+        queue.setArrivalCallback([&pushed](const int&, std::chrono::steady_clock::time_point, bool)
+                                 { ++pushed; });
+        queue.push(3);
+    }
+    queue.push(4);
+    EXPECT_EQ(pushed, 2u);
+    std::remove(CAPTURE_PATH.c_str());
+}
+
+/**
+ * @brief Test that a truncated last record is dropped and a foreign file is rejected.
+ */
+TEST(QueueCaptureTest, LoadToleratesTruncatedTail)
+{
+    {
+        Queue<int> queue(Queue<int>::Settings{});
+        QueueCapture<int> capture;
+        ASSERT_TRUE(capture.start(queue, CAPTURE_PATH, QueueCapture<int>::Settings{}));
+        for (int i = 0; i < 3; ++i)
+        {
+            queue.push(i);
+        }
+        // The destructor stops the capture.
+    }
+    std::vector<char> bytes;
+    {
+        std::ifstream file(CAPTURE_PATH, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream file(CAPTURE_PATH, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 3));
+    }
+    EXPECT_EQ(loadCapture().size(), 2u);
+
+    {
+        std::ofstream file(CAPTURE_PATH, std::ios::binary | std::ios::trunc);
+        file << "not a capture";
+    }
+    std::vector<CaptureRecord> records;
+    EXPECT_FALSE(QueueCapture<int>::load(CAPTURE_PATH, records));
+    EXPECT_FALSE(QueueCapture<int>::load("missing_capture.bin", records));
+    std::remove(CAPTURE_PATH.c_str());
+}
+
+/**
+ * @brief Test that a replay keeps the recorded gaps and reports the outcome of each submission.
+ */
+TEST(QueueCaptureTest, ReplayReproducesArrivals)
+{
+    using Clock = QueueReplay<int>::Clock;
+    std::vector<CaptureRecord> records;
+    for (uint64_t i = 0; i < 5; ++i)
+    {
+        CaptureRecord record;
+        record.offset_ns = i * 20000000; // Every 20 ms.
+        record.size = static_cast<uint32_t>(i);
+        records.push_back(record);
+    }
+
+    Queue<int>::Settings queue_settings;
+    queue_settings.size = 4;
+    queue_settings.discard = Queue<int>::Discard::DISCARD_NEWEST;
+    Queue<int> queue(queue_settings);
+    std::vector<Clock::time_point> scheduled;
+    QueueReplay<int>::Settings settings;
+    settings.factory = [](const CaptureRecord& record) -> int
+    {
+        return static_cast<int>(record.size) * 10;
+    };
+    const auto start = Clock::now();
+    const auto result = QueueReplay<int>::run(records, [&](const int& elem, const Clock::time_point at) -> bool
+                                              {
+                                                  scheduled.push_back(at);
+                                                  return queue.push(elem, 0); },
+                                              settings);
+    EXPECT_EQ(result.offered, 5u);
+    EXPECT_EQ(result.accepted, 4u); // The fifth push finds the queue full.
+    EXPECT_GE(result.duration, std::chrono::milliseconds(80));
+    EXPECT_GT(result.throughput(), 0.0);
+    ASSERT_EQ(scheduled.size(), 5u);
+    EXPECT_EQ(scheduled[4] - scheduled[0], std::chrono::milliseconds(80));
+    EXPECT_GE(scheduled[0], start);
+    EXPECT_EQ(queue.snapshot(), (std::vector<int>{0, 10, 20, 30}));
+
+    // Twice as fast, and without pacing.
+    settings.speed = 2.0;
+    const auto faster = QueueReplay<int>::run(records, [](const int&, const Clock::time_point) -> bool
+                                              { return true; },
+                                              settings);
+    EXPECT_GE(faster.duration, std::chrono::milliseconds(40));
+    EXPECT_LT(faster.duration, result.duration);
+    settings.speed = 0.0;
+    const auto unpaced = QueueReplay<int>::run(records, [](const int&, const Clock::time_point) -> bool
+                                               { return true; },
+                                               settings);
+    EXPECT_LT(unpaced.duration, std::chrono::milliseconds(40));
+    EXPECT_EQ(unpaced.max_lag, Clock::duration::zero());
+}
+
+/**
+ * @brief Test that a capture replays its payloads against a differently configured queue.
+ */
+TEST(QueueCaptureTest, CaptureThenReplay)
+{
+    Queue<int> production(Queue<int>::Settings{});
+    QueueCapture<int> capture;
+    QueueCapture<int>::Settings settings;
+    settings.payload = true;
+    ASSERT_TRUE(capture.start(production, CAPTURE_PATH, settings));
+    for (int i = 0; i < 10; ++i)
+    {
+        production.push(i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_TRUE(capture.stop());
+
+    const std::vector<CaptureRecord> records = loadCapture();
+    ASSERT_EQ(records.size(), 10u);
+    Queue<int>::Settings candidate_settings;
+    candidate_settings.wake = Queue<int>::Wake::AFFINITY;
+    Queue<int> candidate(candidate_settings);
+    const auto result = QueueReplay<int>::run(records, [&candidate](const int& elem, const QueueReplay<int>::Clock::time_point) -> bool
+                                              { return candidate.push(elem); });
+    EXPECT_EQ(result.accepted, 10u);
+    EXPECT_GE(result.duration, std::chrono::nanoseconds(records.back().offset_ns));
+    EXPECT_EQ(candidate.snapshot(), production.snapshot());
+    std::remove(CAPTURE_PATH.c_str());
+}
@@ -0,0 +1,193 @@
+#include "thread_safe/queue_snapshot.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+struct Order
+{
+    std::string symbol{};
+    int quantity{0};
+};
+
+/**
+ * @brief Custom serializer for a non-trivially-copyable element type.
+ */
+struct OrderSerializer
+{
+    void serialize(const Order& order, std::vector<uint8_t>& out) const
+    {
+        Serializer<int>{}.serialize(order.quantity, out);
+        Serializer<std::string>{}.serialize(order.symbol, out);
+    }
+
+    bool deserialize(const uint8_t* data, std::size_t size, Order& order) const
+    {
+        if (size < sizeof(int))
+        {
+            return false;
+        }
+        return Serializer<int>{}.deserialize(data, sizeof(int), order.quantity)
+               && Serializer<std::string>{}.deserialize(data + sizeof(int), size - sizeof(int), order.symbol);
+    }
+};
+
+const std::string SNAPSHOT_PATH{"thread_safe_queue_snapshot_test.bin"};
+
+} // namespace
+
+/**
+ * @brief Test for saving a consistent copy and restoring it into a new queue.
+ */
+TEST(QueueSnapshotTest, SaveCopyAndLoad)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+
+    ASSERT_TRUE(QueueSnapshot<int>::save(queue, SNAPSHOT_PATH));
+    ASSERT_TRUE(QueueSnapshot<int>::save(queue, SNAPSHOT_PATH)); // Replaces the previous snapshot.
+    EXPECT_EQ(queue.size(), 100u); // Copy mode keeps the elements.
+    EXPECT_FALSE(std::ifstream{SNAPSHOT_PATH + ".tmp"}.good());
+
+    Queue<int> restored(Queue<int>::Settings{});
+    ASSERT_TRUE(QueueSnapshot<int>::load(restored, SNAPSHOT_PATH));
+    ASSERT_EQ(restored.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+    {
+        int value{-1};
+        ASSERT_TRUE(restored.pop(value, 0));
+        EXPECT_EQ(value, i);
+    }
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+/**
+ * @brief Test for draining a push-controlled queue into a snapshot.
+ */
+TEST(QueueSnapshotTest, SaveDrain)
+{
+    Queue<std::string>::Settings settings;
+    settings.control = Queue<std::string>::Control::PUSH;
+    Queue<std::string> queue(settings);
+    queue.openPush();
+    ASSERT_TRUE(queue.push("first"));
+    ASSERT_TRUE(queue.push("second"));
+
+    ASSERT_TRUE(QueueSnapshot<std::string>::save(queue, SNAPSHOT_PATH, QueueSnapshot<std::string>::Mode::DRAIN));
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_FALSE(queue.push("late")); // Push is closed after draining.
+
+    Queue<std::string> restored(Queue<std::string>::Settings{});
+    ASSERT_TRUE(QueueSnapshot<std::string>::load(restored, SNAPSHOT_PATH));
+    std::string value;
+    ASSERT_TRUE(restored.pop(value, 0));
+    EXPECT_EQ(value, "first");
+    ASSERT_TRUE(restored.pop(value, 0));
+    EXPECT_EQ(value, "second");
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+/**
+ * @brief Test for a user-provided serializer.
+ */
+TEST(QueueSnapshotTest, CustomSerializer)
+{
+    using Snapshot = QueueSnapshot<Order, OrderSerializer>;
+    Queue<Order> queue(Queue<Order>::Settings{});
+    ASSERT_TRUE(queue.push(Order{"ABC", 10}));
+    ASSERT_TRUE(queue.push(Order{"XYZ", 20}));
+    ASSERT_TRUE(Snapshot::save(queue, SNAPSHOT_PATH));
+
+    Queue<Order> restored(Queue<Order>::Settings{});
+    ASSERT_TRUE(Snapshot::load(restored, SNAPSHOT_PATH));
+    Order order;
+    ASSERT_TRUE(restored.pop(order, 0));
+    EXPECT_EQ(order.symbol, "ABC");
+    EXPECT_EQ(order.quantity, 10);
+    ASSERT_TRUE(restored.pop(order, 0));
+    EXPECT_EQ(order.symbol, "XYZ");
+    EXPECT_EQ(order.quantity, 20);
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+/**
+ * @brief Test that missing and corrupted files are rejected without touching the queue.
+ */
+TEST(QueueSnapshotTest, RejectInvalidFile)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    EXPECT_FALSE(QueueSnapshot<int>::load(queue, "does_not_exist.bin"));
+
+    {
+        std::ofstream file{SNAPSHOT_PATH, std::ios::binary};
+        file << "not a snapshot";
+    }
+    EXPECT_FALSE(QueueSnapshot<int>::load(queue, SNAPSHOT_PATH));
+    EXPECT_EQ(queue.size(), 0u);
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+/**
+ * @brief Test that a corrupted element count is rejected instead of allocating for it.
+ */
+TEST(QueueSnapshotTest, RejectCorruptedCount)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(QueueSnapshot<int>::save(queue, SNAPSHOT_PATH));
+    {
+        // The count follows the 32-bit magic and version.
+        std::fstream file{SNAPSHOT_PATH, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(2 * sizeof(uint32_t));
+        const uint64_t count{std::numeric_limits<uint64_t>::max() / 2};
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    Queue<int> restored(Queue<int>::Settings{});
+    EXPECT_FALSE(QueueSnapshot<int>::load(restored, SNAPSHOT_PATH));
+    EXPECT_EQ(restored.size(), 0u);
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+/**
+ * @brief Test that a load into a queue without room for every element reports the loss.
+ */
+TEST(QueueSnapshotTest, LoadReportsDiscarded)
+{
+    Queue<int> queue(Queue<int>::Settings{});
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_TRUE(QueueSnapshot<int>::save(queue, SNAPSHOT_PATH));
+
+    Queue<int>::Settings settings;
+    settings.size = 2;
+    settings.discard = Queue<int>::Discard::DISCARD_NEWEST;
+    Queue<int> restored(settings);
+    EXPECT_FALSE(QueueSnapshot<int>::load(restored, SNAPSHOT_PATH));
+    EXPECT_EQ(restored.size(), 2u);
+
+    // A later record evicting an earlier one is reported the same way.
+    settings.discard = Queue<int>::Discard::DISCARD_OLDEST;
+    Queue<int> evicting(settings);
+    EXPECT_FALSE(QueueSnapshot<int>::load(evicting, SNAPSHOT_PATH));
+    EXPECT_EQ(evicting.drain(), (std::vector<int>{1, 2}));
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
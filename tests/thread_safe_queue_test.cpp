@@ -1,8 +1,13 @@
 #include "thread_safe/queue.hpp"
+#include "thread_safe/thread.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <gtest/gtest.h>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 using Queue = ThreadSafe::Queue<int>;
 
@@ -260,6 +265,448 @@ TEST(QueueTest, WaitOpenTest)
     ASSERT_TRUE(queue.waitPopOpen(100)); // Now it should succeed.
 }
 
+/**
+ * @brief Test for snapshot, drain and bulkLoad.
+ */
+TEST(QueueTest, SnapshotDrainBulkLoad)
+{
+    Queue::Settings settings;
+    settings.size = 3;
+    settings.discard = Queue::Discard::DISCARD_OLDEST;
+    Queue queue(settings);
+
+    int discarded = -1;
+    queue.setDiscardedCallback([&discarded](const int& elem)
+                               { discarded = elem; });
+
+    ASSERT_EQ(queue.bulkLoad({1, 2, 3, 4}), 3u); // 1 is discarded to respect the size.
+    EXPECT_EQ(discarded, 1);
+    EXPECT_EQ(queue.snapshot(), (std::vector<int>{2, 3, 4}));
+    EXPECT_EQ(queue.size(), 3u); // Snapshot does not remove elements.
+
+    EXPECT_EQ(queue.drain(), (std::vector<int>{2, 3, 4}));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+/**
+ * @brief Test for the affinity wake policy with several parked consumers.
+ */
+TEST(QueueTest, AffinityWake)
+{
+    Queue::Settings settings;
+    settings.wake = Queue::Wake::AFFINITY;
+    Queue queue(settings);
+
+    int popped_value;
+    ASSERT_FALSE(queue.pop(popped_value, 50)); // Parked pop still honours the timeout.
+
+    constexpr int CONSUMERS{4};
+    constexpr int ELEMENTS{1000};
+    std::atomic<int> popped{0};
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < CONSUMERS; ++i)
+    {
+        consumers.emplace_back([&]()
+                               {
+            int value;
+            while (popped < ELEMENTS && queue.pop(value, 100)) {
+                ++popped;
+            } });
+    }
+    for (int i = 0; i < ELEMENTS; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    for (auto& consumer : consumers)
+    {
+        consumer.join();
+    }
+    ASSERT_EQ(popped.load(), ELEMENTS); // Every push woke a consumer, nothing was stranded.
+}
+
+/**
+ * @brief Test that closing pop wakes a consumer parked with the affinity policy.
+ */
+TEST(QueueTest, AffinityWakeClosePop)
+{
+    Queue::Settings settings;
+    settings.wake = Queue::Wake::AFFINITY;
+    settings.control = Queue::Control::POP;
+    Queue queue(settings);
+    queue.openPop();
+
+    std::thread closer([&]()
+                       {
+        sleep_ms(100);
+        queue.closePop(); });
+
+    int popped_value;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(queue.pop(popped_value)); // Would block forever without the wake-up.
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    closer.join();
+}
+
+/**
+ * @brief Test that the ready callback fires only when an element is added to an empty queue.
+ */
+TEST(QueueTest, ReadyCallback)
+{
+    Queue::Settings settings;
+    Queue queue(settings);
+    int ready = 0;
+    queue.setReadyCallback([&ready]()
+                           { ++ready; });
+
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    ASSERT_EQ(ready, 1);
+
+    int popped_value;
+    ASSERT_TRUE(queue.pop(popped_value));
+    ASSERT_TRUE(queue.pop(popped_value));
+    ASSERT_TRUE(queue.push(3));
+    ASSERT_EQ(ready, 2);
+
+    queue.drain();
+    ASSERT_EQ(queue.bulkLoad({4, 5}), 2u);
+    ASSERT_EQ(ready, 3);
+}
+
+/**
+ * @brief Test that a short burst passes CoDel untouched while a standing backlog is discarded.
+ */
+TEST(QueueTest, CodelDiscardsStandingBacklog)
+{
+    Queue::Settings settings;
+    settings.discard = Queue::Discard::CODEL;
+    settings.codel.target_ms = 5;
+    settings.codel.interval_ms = 20;
+    Queue queue(settings);
+    int discarded = 0;
+    queue.setDiscardedCallback([&discarded](const int&)
+                               { ++discarded; });
+
+    int popped_value;
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.pop(popped_value, 0));
+        ASSERT_EQ(popped_value, i);
+    }
+    ASSERT_EQ(discarded, 0);
+
+    sleep_ms(30); // Let the interval of the burst end.
+    for (int i = 0; i < 50; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    sleep_ms(30);
+    ASSERT_TRUE(queue.pop(popped_value, 0)); // Waited 30 ms, longer than the target.
+    ASSERT_EQ(popped_value, 0);
+    sleep_ms(30);
+    ASSERT_FALSE(queue.pop(popped_value, 0)); // Not a single element met the target during the interval.
+    ASSERT_EQ(discarded, 49);
+    ASSERT_EQ(queue.size(), 0u);
+}
+
+/**
+ * @brief Test that adaptive LIFO serves fresh elements first while CoDel sees an overload.
+ */
+TEST(QueueTest, CodelAdaptiveLifo)
+{
+    Queue::Settings settings;
+    settings.discard = Queue::Discard::CODEL;
+    settings.codel.target_ms = 5;
+    settings.codel.interval_ms = 20;
+    settings.codel.adaptive_lifo = true;
+    Queue queue(settings);
+    int discarded = 0;
+    queue.setDiscardedCallback([&discarded](const int&)
+                               { ++discarded; });
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    sleep_ms(30);
+    int popped_value;
+    ASSERT_TRUE(queue.pop(popped_value, 0));
+    ASSERT_EQ(popped_value, 0); // No overload seen yet, FIFO.
+    sleep_ms(30);
+    for (int i = 100; i < 103; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    std::vector<int> fresh;
+    ASSERT_EQ(queue.popBatch(fresh, 10, 0), 3u);
+    ASSERT_EQ(fresh, (std::vector<int>{102, 101, 100}));
+    ASSERT_EQ(discarded, 9);
+}
+
+/**
+ * @brief Test that adaptive LIFO stays on while the backlog stands, although fresh elements wait briefly.
+ */
+TEST(QueueTest, CodelAdaptiveLifoKeepsOverload)
+{
+    Queue::Settings settings;
+    settings.discard = Queue::Discard::CODEL;
+    settings.codel.target_ms = 100;
+    settings.codel.interval_ms = 20;
+    settings.codel.adaptive_lifo = true;
+    Queue queue(settings);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    sleep_ms(120);
+    int popped_value;
+    ASSERT_TRUE(queue.pop(popped_value, 0));
+    ASSERT_EQ(popped_value, 0); // No overload seen yet, FIFO.
+    for (int i = 100; i < 102; ++i)
+    {
+        sleep_ms(25); // Ends the interval, the head still waits longer than the target.
+        ASSERT_TRUE(queue.push(i));
+        ASSERT_TRUE(queue.pop(popped_value, 0));
+        ASSERT_EQ(popped_value, i);
+    }
+}
+
+/**
+ * @brief Test that the byte bound applies the discard policy like the element bound.
+ */
+TEST(QueueTest, ByteBound)
+{
+    using Bytes = ThreadSafe::Queue<std::string>;
+    Bytes::Settings settings;
+    settings.discard = Bytes::Discard::DISCARD_OLDEST;
+    settings.size_of = [](const std::string& elem)
+    { return elem.size(); };
+    settings.max_bytes = 100;
+    Bytes queue(settings);
+    std::vector<std::string> discarded;
+    queue.setDiscardedCallback([&discarded](const std::string& elem)
+                               { discarded.push_back(elem); });
+
+    ASSERT_TRUE(queue.push(std::string(40, 'a')));
+    ASSERT_TRUE(queue.push(std::string(40, 'b')));
+    ASSERT_EQ(queue.bytes(), 80u);
+    ASSERT_TRUE(queue.push(std::string(30, 'c'))); // Drops the oldest to stay within 100 bytes.
+    ASSERT_EQ(discarded, (std::vector<std::string>{std::string(40, 'a')}));
+    ASSERT_EQ(queue.bytes(), 70u);
+    ASSERT_EQ(queue.size(), 2u);
+
+    ASSERT_TRUE(queue.push(std::string(500, 'd'))); // Too large for any queue, admitted alone.
+    ASSERT_EQ(queue.size(), 1u);
+    ASSERT_EQ(queue.bytes(), 500u);
+    std::string popped_value;
+    ASSERT_TRUE(queue.pop(popped_value, 0));
+    ASSERT_EQ(queue.bytes(), 0u);
+}
+
+/**
+ * @brief Test that queues sharing a budget discard or block when it is exhausted.
+ */
+TEST(QueueTest, SharedBudget)
+{
+    using Bytes = ThreadSafe::Queue<std::string>;
+    auto budget = std::make_shared<ThreadSafe::MemoryBudget>(100);
+    Bytes::Settings settings;
+    settings.size_of = [](const std::string& elem)
+    { return elem.size(); };
+    settings.budget = budget;
+    settings.discard = Bytes::Discard::DISCARD_NEWEST;
+    Bytes dropping(settings);
+    settings.discard = Bytes::Discard::NO_DISCARD;
+    Bytes blocking(settings);
+    int discarded = 0;
+    dropping.setDiscardedCallback([&discarded](const std::string&)
+                                  { ++discarded; });
+
+    ASSERT_TRUE(blocking.push(std::string(60, 'a')));
+    ASSERT_TRUE(dropping.push(std::string(30, 'b')));
+    ASSERT_EQ(budget->used(), 90u);
+    ASSERT_FALSE(dropping.push(std::string(20, 'c'))); // The other queue holds most of the budget.
+    ASSERT_EQ(discarded, 1);
+    ASSERT_FALSE(blocking.push(std::string(20, 'd'), 20));
+
+    // Bytes popped from the other queue unblock the waiting push.
+    std::thread consumer([&]()
+                         {
+        sleep_ms(50);
+        std::string popped_value;
+        ASSERT_TRUE(dropping.pop(popped_value)); });
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(blocking.push(std::string(20, 'e')));
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+    consumer.join();
+    ASSERT_EQ(budget->used(), 80u);
+
+    std::vector<std::string> drained = blocking.drain();
+    ASSERT_EQ(drained.size(), 2u);
+    ASSERT_EQ(budget->used(), 0u);
+}
+
+/**
+ * @brief Test that an evicting queue only evicts for the budget if its own bytes can make room.
+ */
+TEST(QueueTest, SharedBudgetEvictsOwnBytesOnly)
+{
+    using Bytes = ThreadSafe::Queue<std::string>;
+    auto budget = std::make_shared<ThreadSafe::MemoryBudget>(100);
+    Bytes::Settings settings;
+    settings.size_of = [](const std::string& elem)
+    { return elem.size(); };
+    settings.budget = budget;
+    settings.discard = Bytes::Discard::NO_DISCARD;
+    Bytes other(settings);
+    settings.discard = Bytes::Discard::DISCARD_OLDEST;
+    Bytes evicting(settings);
+    std::vector<std::string> discarded;
+    evicting.setDiscardedCallback([&discarded](const std::string& elem)
+                                  { discarded.push_back(elem); });
+
+    ASSERT_TRUE(other.push(std::string(70, 'a')));
+    ASSERT_TRUE(evicting.push(std::string(10, 'b')));
+    ASSERT_TRUE(evicting.push(std::string(10, 'c')));
+    ASSERT_TRUE(evicting.push(std::string(10, 'd')));
+
+    // Even an empty queue would leave only 30 bytes, so only the new element is discarded.
+    ASSERT_FALSE(evicting.push(std::string(50, 'e')));
+    ASSERT_EQ(discarded.size(), 1u);
+    ASSERT_EQ(discarded[0], std::string(50, 'e'));
+    ASSERT_EQ(evicting.size(), 3u);
+    ASSERT_EQ(budget->used(), 100u);
+
+    // Evicting the oldest two makes room for this one.
+    ASSERT_TRUE(evicting.push(std::string(20, 'f')));
+    ASSERT_EQ(discarded.size(), 3u);
+    ASSERT_EQ(discarded[1], std::string(10, 'b'));
+    ASSERT_EQ(discarded[2], std::string(10, 'c'));
+    ASSERT_EQ(evicting.size(), 2u);
+    ASSERT_EQ(budget->used(), 100u);
+}
+
+/**
+ * @brief Test that a queue destroyed with elements left returns their bytes to the shared budget.
+ */
+TEST(QueueTest, DestroyReleasesBudget)
+{
+    using Bytes = ThreadSafe::Queue<std::string>;
+    auto budget = std::make_shared<ThreadSafe::MemoryBudget>(1000);
+    Bytes::Settings settings;
+    settings.size_of = [](const std::string& elem)
+    { return elem.size(); };
+    settings.budget = budget;
+    Bytes survivor(settings);
+    {
+        Bytes destroyed(settings);
+        ASSERT_TRUE(destroyed.push(std::string(600, 'a')));
+        ASSERT_TRUE(survivor.push(std::string(100, 'b')));
+        ASSERT_EQ(budget->used(), 700u);
+    }
+    ASSERT_EQ(budget->used(), 100u);
+    ASSERT_TRUE(survivor.push(std::string(800, 'c'), 0));
+}
+
+/**
+ * @brief Test that the arrival callback can be replaced and removed while another thread pushes.
+ */
+TEST(QueueTest, ArrivalCallbackSwappedWhilePushing)
+{
+    ThreadSafe::Queue<int> queue(ThreadSafe::Queue<int>::Settings{});
+    std::atomic<bool> running{true};
+    std::atomic<uint32_t> first{0};
+    std::atomic<uint32_t> second{0};
+    std::thread producer([&]()
+                         {
+        int elem{0};
+        while (running)
+        {
+            queue.push(elem);
+            queue.pop(elem, 0);
+        } });
+    for (int i = 0; i < 100; ++i)
+    {
+        queue.setArrivalCallback([&first](const int&, std::chrono::steady_clock::time_point, bool)
+                                 { ++first; });
+        queue.setArrivalCallback([&second](const int&, std::chrono::steady_clock::time_point, bool)
+                                 { ++second; });
+    }
+    while (second == 0)
+    {
+        std::this_thread::yield();
+    }
+    queue.setArrivalCallback(nullptr);
+    const uint32_t removed_at{second};
+    // A push that loaded the callback before it was removed may still finish calling it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint32_t settled{second};
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    running = false;
+    producer.join();
+    ASSERT_LE(settled, removed_at + 1);
+    ASSERT_EQ(second, settled);
+}
+
+/**
+ * @brief Test for the real-time mode shared by a time-critical consumer and low-priority producers.
+ */
+TEST(QueueTest, RealTimeMixedPriorities)
+{
+    constexpr int PRODUCERS = 2;
+    constexpr int COUNT = 5000;
+    Queue::Settings settings;
+    settings.size = 64;
+    settings.real_time = true;
+    Queue queue(settings);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < PRODUCERS; ++producer)
+    {
+        producers.emplace_back([&queue, producer]()
+                               {
+            ThreadSafe::setNaitiveThreadPriority(ThreadSafe::ThreadPriority::LOWEST, ThreadSafe::currentNativeThreadHandle());
+            for (int i = 0; i < COUNT; ++i)
+            {
+                ASSERT_TRUE(queue.push(producer * COUNT + i));
+            } });
+    }
+    std::vector<int> last(PRODUCERS, -1);
+    std::thread consumer([&]()
+                         {
+        ThreadSafe::setNaitiveThreadPriority(ThreadSafe::ThreadPriority::TIME_CRITICAL, ThreadSafe::currentNativeThreadHandle());
+        std::vector<int> batch;
+        int received = 0;
+        while (received < PRODUCERS * COUNT)
+        {
+            batch.clear();
+            const std::size_t count = received % 2 == 0 ? queue.popBatch(batch, 16, 5000) : queue.pop(batch.emplace_back(), 5000);
+            ASSERT_GT(count, 0u);
+            for (int value : batch)
+            {
+                // Each producer's elements arrive in order.
+                ASSERT_GT(value % COUNT, last[value / COUNT]);
+                last[value / COUNT] = value % COUNT;
+            }
+            received += static_cast<int>(batch.size());
+        } });
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    consumer.join();
+    for (int producer = 0; producer < PRODUCERS; ++producer)
+    {
+        ASSERT_EQ(last[producer], COUNT - 1);
+    }
+    ASSERT_EQ(queue.size(), 0u);
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,206 @@
+#include "thread_safe/queue_worker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+using IntQueue = Queue<int>;
+using IntWorker = QueueWorker<int>;
+
+/**
+ * @brief Test for popBatch on the queue itself.
+ */
+TEST(QueueWorkerTest, PopBatch)
+{
+    IntQueue queue(IntQueue::Settings{});
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+
+    std::vector<int> batch;
+    EXPECT_EQ(queue.popBatch(batch, 3, 0), 3u);
+    EXPECT_EQ(batch, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(queue.popBatch(batch, 10, 0), 2u); // Appends the remaining elements.
+    EXPECT_EQ(batch, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(queue.popBatch(batch, 10, 50), 0u); // Empty, times out.
+}
+
+/**
+ * @brief Test that popBatch lingers for a full batch, and returns as soon as it is full.
+ */
+TEST(QueueWorkerTest, PopBatchLinger)
+{
+    IntQueue queue(IntQueue::Settings{});
+    ASSERT_TRUE(queue.push(0));
+    std::thread producer([&queue]()
+                         {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int i = 1; i < 4; ++i)
+        {
+            queue.push(i);
+        } });
+
+    std::vector<int> batch;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(queue.popBatch(batch, 4, 0, 2000000), 4u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(batch, (std::vector<int>{0, 1, 2, 3}));
+    producer.join();
+
+    // A partial batch comes back once the linger time is over.
+    ASSERT_TRUE(queue.push(4));
+    batch.clear();
+    EXPECT_EQ(queue.popBatch(batch, 4, 0, 10000), 1u);
+}
+
+/**
+ * @brief Test that every element is processed exactly once across several threads, in batches.
+ */
+TEST(QueueWorkerTest, ProcessAllInBatches)
+{
+    IntQueue::Settings queue_settings;
+    queue_settings.control = IntQueue::Control::PUSH;
+    IntQueue queue(queue_settings);
+    queue.openPush();
+
+    std::mutex lock;
+    std::vector<int> seen;
+    std::size_t largest_batch{0};
+    IntWorker::Settings settings;
+    settings.threads = 3;
+    settings.batch_size = 16;
+    IntWorker worker(queue, [&](std::vector<int>& batch)
+                     {
+        std::lock_guard<std::mutex> guard{lock};
+        largest_batch = std::max(largest_batch, batch.size());
+        seen.insert(seen.end(), batch.begin(), batch.end()); },
+                     settings);
+
+    constexpr int ELEMENTS{1000};
+    for (int i = 0; i < ELEMENTS; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_TRUE(worker.start());
+    EXPECT_FALSE(worker.start()); // Already running.
+    ASSERT_TRUE(worker.stop());   // Drains before stopping.
+
+    EXPECT_FALSE(queue.push(ELEMENTS)); // Push was closed by stop.
+    ASSERT_EQ(seen.size(), static_cast<std::size_t>(ELEMENTS));
+    std::sort(seen.begin(), seen.end());
+    std::vector<int> expected(ELEMENTS);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(seen, expected);
+    EXPECT_LE(largest_batch, settings.batch_size);
+    EXPECT_GT(largest_batch, 1u); // The backlog was consumed in batches.
+
+    auto metrics = worker.metrics();
+    EXPECT_EQ(metrics.processed, static_cast<uint64_t>(ELEMENTS));
+    EXPECT_LT(metrics.batches, static_cast<uint64_t>(ELEMENTS));
+    EXPECT_EQ(metrics.backlog, 0u);
+}
+
+/**
+ * @brief Test for backlog and lag metrics while the handler is slower than the producer.
+ */
+TEST(QueueWorkerTest, BacklogMetrics)
+{
+    IntQueue queue(IntQueue::Settings{});
+    IntWorker::Settings settings;
+    settings.batch_size = 1;
+    IntWorker worker(queue, [](std::vector<int>&)
+                     { std::this_thread::sleep_for(std::chrono::milliseconds(10)); },
+                     settings);
+    ASSERT_TRUE(worker.start());
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto metrics = worker.metrics();
+    EXPECT_GT(metrics.processed, 0u);
+    EXPECT_GT(metrics.backlog, 0u);
+    EXPECT_GT(metrics.throughput, 0.0);
+    EXPECT_GT(metrics.lag.count(), 0);
+    EXPECT_GE(metrics.batch_time.count(), 10000);
+    EXPECT_TRUE(worker.stop(false)); // Stops without draining the backlog.
+}
+
+/**
+ * @brief Test that a worker with a controller grows its batches while a backlog builds up.
+ */
+TEST(QueueWorkerTest, AdaptiveBatchSize)
+{
+    IntQueue::Settings queue_settings;
+    queue_settings.control = IntQueue::Control::PUSH;
+    IntQueue queue(queue_settings);
+    queue.openPush();
+    BatchController::Settings controller_settings;
+    controller_settings.initial_batch = 1;
+    controller_settings.max_batch = 64;
+    controller_settings.batch_step = 4;
+    IntWorker::Settings settings;
+    settings.controller = std::make_shared<BatchController>(controller_settings);
+    std::atomic<std::size_t> largest_batch{0};
+    std::atomic<int> processed{0};
+    IntWorker worker(queue, [&](std::vector<int>& batch)
+                     {
+        largest_batch = std::max(largest_batch.load(), batch.size());
+        processed += static_cast<int>(batch.size()); },
+                     settings);
+
+    constexpr int ELEMENTS{2000};
+    for (int i = 0; i < ELEMENTS; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_TRUE(worker.start());
+    ASSERT_TRUE(worker.stop());
+    EXPECT_EQ(processed.load(), ELEMENTS);
+    EXPECT_GT(largest_batch.load(), 1u);
+    EXPECT_GT(settings.controller->batchSize(), 1u);
+}
+
+/**
+ * @brief Test that a draining stop returns on a queue without push control.
+ */
+TEST(QueueWorkerTest, DrainWithoutPushControl)
+{
+    for (const std::size_t threads : {std::size_t{1}, std::size_t{4}})
+    {
+        IntQueue queue(IntQueue::Settings{});
+        std::atomic<int> processed{0};
+        IntWorker::Settings settings;
+        settings.threads = threads;
+        settings.batch_size = 8;
+        IntWorker worker(queue, [&processed](std::vector<int>& batch)
+                         { processed += static_cast<int>(batch.size()); },
+                         settings);
+        constexpr int ELEMENTS{500};
+        for (int i = 0; i < ELEMENTS; ++i)
+        {
+            ASSERT_TRUE(queue.push(i));
+        }
+        ASSERT_TRUE(worker.start());
+        const auto start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(worker.stop());
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+        EXPECT_EQ(processed.load(), ELEMENTS);
+        EXPECT_EQ(queue.size(), 0u);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+#include "thread_safe/reactor.hpp"
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <future>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ThreadSafe;
+
+// Create a non-blocking pipe
+void nonBlockingPipe(int fds[2]) {
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+}
+
+// Read everything available from a non-blocking descriptor
+std::string readAll(int fd) {
+    std::string data;
+    char buffer[256];
+    ssize_t count = 0;
+    while ((count = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, static_cast<size_t>(count));
+    }
+    return data;
+}
+
+// A readable pipe calls its handler on the reactor thread
+TEST(ReactorTest, PipeReadable) {
+    int fds[2];
+    nonBlockingPipe(fds);
+    Reactor reactor("reactor");
+    std::promise<std::string> received;
+    std::string data;
+    ASSERT_TRUE(reactor.add(fds[0], Reactor::READABLE, [&](uint32_t events) {
+        EXPECT_TRUE(reactor.isReactorThread());
+        EXPECT_NE(events & Reactor::READABLE, 0u);
+        data += readAll(fds[0]);
+        if (data.size() == 10) {
+            received.set_value(data);
+        }
+    }));
+    EXPECT_FALSE(reactor.add(fds[0], Reactor::READABLE, [](uint32_t) {}));
+    ASSERT_TRUE(reactor.start());
+    ASSERT_EQ(::write(fds[1], "hello", 5), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(::write(fds[1], "world", 5), 5);
+    auto future = received.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(future.get(), "helloworld");
+    EXPECT_TRUE(reactor.stop());
+    EXPECT_TRUE(reactor.remove(fds[0]));
+    EXPECT_FALSE(reactor.remove(fds[0]));
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// A socketpair echo: the reactor answers every request, the peer hangup is reported
+TEST(ReactorTest, SocketPairEcho) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+    Reactor reactor("echo");
+    std::promise<void> hangup;
+    ASSERT_TRUE(reactor.add(fds[0], Reactor::READABLE, [&](uint32_t events) {
+        const std::string request = readAll(fds[0]);
+        if (!request.empty()) {
+            EXPECT_EQ(::write(fds[0], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+        }
+        if (events & Reactor::HANGUP) {
+            reactor.remove(fds[0]);
+            hangup.set_value();
+        }
+    }));
+    ASSERT_TRUE(reactor.start());
+
+    for (int i = 0; i < 20; ++i) {
+        const std::string request = "ping " + std::to_string(i);
+        ASSERT_EQ(::write(fds[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+        std::string reply;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (reply.size() < request.size() && std::chrono::steady_clock::now() < deadline) {
+            reply += readAll(fds[1]);
+        }
+        EXPECT_EQ(reply, request);
+    }
+    ::shutdown(fds[1], SHUT_WR);
+    auto future = hangup.get_future();
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// Queue elements are handled on the reactor thread in order, between I/O events
+TEST(ReactorTest, QueueSource) {
+    constexpr int COUNT = 1000;
+    Reactor::Settings settings;
+    settings.queue_batch = 16;
+    Reactor reactor("queues", ThreadPriority::NORMAL, settings);
+    Queue<int>::Settings queue_settings;
+    Queue<int> queue(queue_settings);
+    queue.push(-1); // Queued before the registration.
+
+    std::vector<int> received;
+    std::promise<void> done;
+    ASSERT_TRUE(reactor.addQueue<int>(queue, [&](int &value) {
+        EXPECT_TRUE(reactor.isReactorThread());
+        received.push_back(value);
+        if (value == COUNT - 1) {
+            done.set_value();
+        }
+    }));
+    EXPECT_FALSE(reactor.addQueue<int>(queue, [](int &) {}));
+
+    int fds[2];
+    nonBlockingPipe(fds);
+    std::atomic<int> reads{0};
+    ASSERT_TRUE(reactor.add(fds[0], Reactor::READABLE, [&](uint32_t) {
+        readAll(fds[0]);
+        ++reads;
+    }));
+    ASSERT_TRUE(reactor.start());
+
+    std::thread producer([&]() {
+        for (int i = 0; i < COUNT; ++i) {
+            queue.push(i);
+            if (i % 100 == 0) {
+                ASSERT_EQ(::write(fds[1], "x", 1), 1);
+            }
+        }
+    });
+    producer.join();
+    auto future = done.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(reactor.stop());
+
+    ASSERT_EQ(received.size(), static_cast<size_t>(COUNT + 1));
+    for (int i = 0; i <= COUNT; ++i) {
+        EXPECT_EQ(received[i], i - 1);
+    }
+    EXPECT_GT(reads.load(), 0);
+    EXPECT_TRUE(reactor.removeQueue(queue));
+    EXPECT_FALSE(reactor.removeQueue(queue));
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// Stop returns while nothing is ready and the reactor can be restarted
+TEST(ReactorTest, StopAndRestart) {
+    Reactor reactor("restart");
+    ASSERT_TRUE(reactor.start());
+    EXPECT_FALSE(reactor.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(reactor.stop());
+
+    Queue<std::string>::Settings settings;
+    Queue<std::string> queue(settings);
+    std::promise<std::string> received;
+    ASSERT_TRUE(reactor.addQueue<std::string>(queue, [&](std::string &value) { received.set_value(value); }));
+    ASSERT_TRUE(reactor.start());
+    queue.push("again");
+    auto future = received.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(future.get(), "again");
+    EXPECT_TRUE(reactor.stop());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
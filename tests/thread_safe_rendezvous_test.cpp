@@ -0,0 +1,157 @@
+#include "thread_safe/queue.hpp"
+#include "thread_safe/rendezvous.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+// put blocks until a taker arrives and receives the element
+TEST(RendezvousTest, PutWaitsForTaker) {
+    Rendezvous<std::string> channel;
+    std::atomic<bool> returned{false};
+    std::thread putter([&]() {
+        EXPECT_TRUE(channel.put("hello"));
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(returned);
+
+    std::string value;
+    EXPECT_TRUE(channel.take(value));
+    EXPECT_EQ(value, "hello");
+    putter.join();
+    EXPECT_TRUE(returned);
+}
+
+// take blocks until a putter arrives
+TEST(RendezvousTest, TakeWaitsForPutter) {
+    Rendezvous<int> channel;
+    int value = 0;
+    std::thread taker([&]() { EXPECT_TRUE(channel.take(value)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(channel.put(7));
+    taker.join();
+    EXPECT_EQ(value, 7);
+}
+
+// Timed out waiters withdraw and leave nothing behind
+TEST(RendezvousTest, Timeout) {
+    Rendezvous<int> channel;
+    EXPECT_FALSE(channel.put(1, 0));
+    EXPECT_FALSE(channel.put(1, 20));
+    int value = 0;
+    EXPECT_FALSE(channel.take(value, 0));
+    EXPECT_FALSE(channel.take(value, 20));
+    EXPECT_FALSE(channel.put(2, 0));
+}
+
+// close wakes every waiter and fails later calls
+TEST(RendezvousTest, Close) {
+    Rendezvous<int> channel;
+    std::vector<std::thread> takers;
+    std::atomic<int> failed{0};
+    for (int i = 0; i < 3; ++i) {
+        takers.emplace_back([&]() {
+            int value = 0;
+            if (!channel.take(value)) {
+                ++failed;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    channel.close();
+    for (auto &taker : takers) {
+        taker.join();
+    }
+    EXPECT_EQ(failed.load(), 3);
+    EXPECT_TRUE(channel.isClosed());
+    EXPECT_FALSE(channel.put(1, 10));
+}
+
+// Every element put by several producers is taken exactly once
+TEST(RendezvousTest, ManyPuttersAndTakers) {
+    constexpr int THREADS = 4;
+    constexpr int ITEMS = 1000;
+    Rendezvous<int> channel;
+    std::atomic<long> sum{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS; ++i) {
+                EXPECT_TRUE(channel.put(t * ITEMS + i));
+            }
+        });
+        threads.emplace_back([&]() {
+            for (int i = 0; i < ITEMS; ++i) {
+                int value = 0;
+                EXPECT_TRUE(channel.take(value));
+                sum += value;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const long total = THREADS * ITEMS;
+    EXPECT_EQ(sum.load(), total * (total - 1) / 2);
+}
+
+// Request/reply round trips through two rendezvous channels versus two queues
+TEST(RendezvousTest, RequestReplyLatency) {
+    constexpr int ROUND_TRIPS = 20000;
+
+    Rendezvous<int> requests;
+    Rendezvous<int> replies;
+    std::thread server([&]() {
+        int request = 0;
+        while (requests.take(request)) {
+            replies.put(request + 1);
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUND_TRIPS; ++i) {
+        int reply = 0;
+        ASSERT_TRUE(requests.put(i));
+        ASSERT_TRUE(replies.take(reply));
+        ASSERT_EQ(reply, i + 1);
+    }
+    const auto rendezvous_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    requests.close();
+    server.join();
+
+    Queue<int>::Settings settings;
+    settings.control = Queue<int>::Control::PUSH;
+    Queue<int> request_queue(settings);
+    Queue<int> reply_queue(settings);
+    request_queue.openPush();
+    reply_queue.openPush();
+    std::thread queue_server([&]() {
+        int request = 0;
+        while (request_queue.pop(request)) {
+            reply_queue.push(request + 1);
+        }
+    });
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUND_TRIPS; ++i) {
+        int reply = 0;
+        ASSERT_TRUE(request_queue.push(i));
+        ASSERT_TRUE(reply_queue.pop(reply));
+        ASSERT_EQ(reply, i + 1);
+    }
+    const auto queue_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    request_queue.closePush();
+    queue_server.join();
+
+    std::cout << "Average round trip, rendezvous: " << rendezvous_ns / ROUND_TRIPS
+              << " ns, queue: " << queue_ns / ROUND_TRIPS << " ns" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,226 @@
+#include "thread_safe/resource_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+struct Connection
+{
+    int id{0};
+    bool healthy{true};
+};
+
+using Pool = ResourcePool<Connection>;
+
+/**
+ * @brief Factory numbering the connections it creates.
+ */
+class Factory
+{
+public:
+    Pool::Factory make()
+    {
+        return [this]() -> std::unique_ptr<Connection>
+        {
+            auto connection = std::make_unique<Connection>();
+            connection->id = ++m_created;
+            return connection;
+        };
+    }
+
+    int created() const
+    {
+        return m_created.load();
+    }
+
+private:
+    std::atomic<int> m_created{0};
+};
+
+Pool::Settings poolSettings(const std::size_t max_size)
+{
+    Pool::Settings settings;
+    settings.max_size = max_size;
+    return settings;
+}
+
+void waitForWaiters(const Pool& pool, const std::size_t waiting)
+{
+    while (pool.waiting() < waiting)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Test that resources are created on demand and that the most recently returned is reused first.
+ */
+TEST(ResourcePoolTest, LazyCreationAndLifoReuse)
+{
+    Factory factory;
+    Pool pool(factory.make(), poolSettings(3));
+    EXPECT_EQ(pool.size(), 0u);
+    {
+        Pool::Lease first = pool.acquire();
+        Pool::Lease second = pool.acquire();
+        ASSERT_TRUE(first);
+        ASSERT_TRUE(second);
+        EXPECT_EQ(first->id, 1);
+        EXPECT_EQ((*second).id, 2);
+        EXPECT_EQ(pool.size(), 2u);
+        first.release();
+        EXPECT_FALSE(first);
+        EXPECT_EQ(pool.idle(), 1u);
+    }
+    EXPECT_EQ(pool.idle(), 2u);
+    Pool::Lease lease = pool.acquire();
+    EXPECT_EQ(lease->id, 2);
+    Pool::Lease moved = std::move(lease);
+    EXPECT_FALSE(lease);
+    EXPECT_EQ(moved->id, 2);
+    EXPECT_EQ(factory.created(), 2);
+}
+
+/**
+ * @brief Test that acquire blocks at `max_size` and gives up after the timeout.
+ */
+TEST(ResourcePoolTest, TimesOutWhenExhausted)
+{
+    Factory factory;
+    Pool pool(factory.make(), poolSettings(1));
+    Pool::Lease held = pool.acquire();
+    ASSERT_TRUE(held);
+    const auto start = std::chrono::steady_clock::now();
+    Pool::Lease lease = pool.acquire(50);
+    EXPECT_FALSE(lease);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    EXPECT_EQ(pool.waiting(), 0u);
+    EXPECT_EQ(factory.created(), 1);
+}
+
+/**
+ * @brief Test that returned resources are handed to the waiters in arrival order.
+ */
+TEST(ResourcePoolTest, FifoHandoff)
+{
+    Factory factory;
+    Pool pool(factory.make(), poolSettings(1));
+    Pool::Lease held = pool.acquire();
+    std::mutex order_lock;
+    std::vector<int> order;
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i)
+    {
+        waiters.emplace_back([&pool, &order_lock, &order, i]()
+                             {
+            Pool::Lease lease = pool.acquire();
+            ASSERT_TRUE(lease);
+            std::lock_guard<std::mutex> lock(order_lock);
+            order.push_back(i); });
+        waitForWaiters(pool, static_cast<std::size_t>(i) + 1);
+    }
+    // A new caller does not overtake the waiters.
+    EXPECT_FALSE(pool.acquire(0));
+    held.release();
+    for (auto& waiter : waiters)
+    {
+        waiter.join();
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(factory.created(), 1);
+}
+
+/**
+ * @brief Test that an invalidated resource is destroyed and lets a waiter create a replacement.
+ */
+TEST(ResourcePoolTest, InvalidateLetsWaiterCreate)
+{
+    Factory factory;
+    Pool pool(factory.make(), poolSettings(1));
+    Pool::Lease held = pool.acquire();
+    int id = 0;
+    std::thread waiter([&pool, &id]()
+                       {
+        Pool::Lease lease = pool.acquire();
+        id = lease ? lease->id : -1; });
+    waitForWaiters(pool, 1);
+    held.invalidate();
+    waiter.join();
+    EXPECT_EQ(id, 2);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.idle(), 1u);
+}
+
+/**
+ * @brief Test that idle resources failing the health check are replaced.
+ */
+TEST(ResourcePoolTest, ValidateDropsUnhealthy)
+{
+    Factory factory;
+    Pool::Settings settings = poolSettings(2);
+    settings.validate = [](Connection& connection) -> bool
+    {
+        return connection.healthy;
+    };
+    Pool pool(factory.make(), settings);
+    {
+        Pool::Lease first = pool.acquire();
+        Pool::Lease second = pool.acquire();
+        first->healthy = false;
+        second->healthy = false;
+    }
+    Pool::Lease lease = pool.acquire();
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(lease->id, 3);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.idle(), 0u);
+}
+
+/**
+ * @brief Test that resources idle for too long are destroyed, down to `min_idle`.
+ */
+TEST(ResourcePoolTest, EvictsIdle)
+{
+    Factory factory;
+    Pool::Settings settings = poolSettings(4);
+    settings.idle_timeout_ms = 20;
+    settings.min_idle = 1;
+    Pool pool(factory.make(), settings);
+    {
+        std::vector<Pool::Lease> leases;
+        for (int i = 0; i < 3; ++i)
+        {
+            leases.push_back(pool.acquire());
+        }
+    }
+    EXPECT_EQ(pool.idle(), 3u);
+    EXPECT_EQ(pool.evictIdle(), 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(pool.evictIdle(), 2u);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.idle(), 1u);
+}
+
+/**
+ * @brief Test that a failing factory yields an empty lease and frees the slot.
+ */
+TEST(ResourcePoolTest, FactoryFailure)
+{
+    Pool pool([]() -> std::unique_ptr<Connection>
+              { return nullptr; },
+              poolSettings(1));
+    EXPECT_FALSE(pool.acquire());
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_FALSE(pool.acquire(0));
+}
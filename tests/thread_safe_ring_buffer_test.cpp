@@ -0,0 +1,108 @@
+#include "thread_safe/ring_buffer.hpp"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace ThreadSafe;
+
+namespace
+{
+
+/**
+ * @brief Element whose copy throws on demand and whose move may throw, so growing copies it.
+ */
+struct Fragile
+{
+    static int live;
+    static int copies_left;
+    int value{0};
+
+    explicit Fragile(const int v)
+        : value{v}
+    {
+        ++live;
+    }
+
+    Fragile(const Fragile& other)
+        : value{other.value}
+    {
+        if (copies_left-- == 0)
+        {
+            throw std::runtime_error("copy failed");
+        }
+        ++live;
+    }
+
+    Fragile(Fragile&& other) noexcept(false)
+        : value{other.value}
+    {
+        ++live;
+    }
+
+    ~Fragile()
+    {
+        --live;
+    }
+};
+
+int Fragile::live{0};
+int Fragile::copies_left{-1};
+
+} // namespace
+
+/**
+ * @brief Test that elements keep their order across wrap-around and growth.
+ */
+TEST(RingBufferTest, WrapAndGrow)
+{
+    RingBuffer<int> buffer;
+    buffer.reserve(4);
+    for (int i = 0; i < 3; ++i)
+    {
+        buffer.push_back(i);
+    }
+    buffer.pop_front();
+    buffer.pop_front();
+    for (int i = 3; i < 10; ++i)
+    {
+        buffer.push_back(i); // Wraps, then grows.
+    }
+    ASSERT_EQ(buffer.size(), 8u);
+    EXPECT_GE(buffer.capacity(), 8u);
+    int expected = 2;
+    for (const int value : buffer)
+    {
+        EXPECT_EQ(value, expected++);
+    }
+    buffer.pop_back();
+    EXPECT_EQ(buffer.back(), 8);
+    EXPECT_EQ(buffer.front(), 2);
+}
+
+/**
+ * @brief Test that a copy throwing while growing leaves the buffer unchanged and leaks nothing.
+ */
+TEST(RingBufferTest, GrowIsExceptionSafe)
+{
+    {
+        RingBuffer<Fragile> buffer;
+        buffer.reserve(4);
+        for (int i = 0; i < 4; ++i)
+        {
+            buffer.push_back(Fragile{i});
+        }
+        Fragile::copies_left = 2; // The third element fails to copy into the larger storage.
+        EXPECT_THROW(buffer.push_back(Fragile{4}), std::runtime_error);
+        Fragile::copies_left = -1;
+        EXPECT_EQ(Fragile::live, 4);
+        ASSERT_EQ(buffer.size(), 4u);
+        EXPECT_EQ(buffer.capacity(), 4u);
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(buffer[i].value, i);
+        }
+        buffer.push_back(Fragile{4});
+        EXPECT_EQ(buffer.size(), 5u);
+    }
+    EXPECT_EQ(Fragile::live, 0);
+}
@@ -0,0 +1,152 @@
+#include "thread_safe/sampling_profiler.hpp"
+#include "thread_safe/thread.hpp"
+#include "thread_safe/thread_registry.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace ThreadSafe;
+
+// Not static, so that the exported symbol table names it.
+__attribute__((noinline)) uint64_t burnCpu(const uint64_t seed)
+{
+    volatile uint64_t value{seed};
+    for (int i = 0; i < 100000; ++i)
+    {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return value;
+}
+
+namespace
+{
+
+bool registered(const char* name)
+{
+    bool found = false;
+    ThreadRegistry::forEach([name, &found](const ThreadRegistry::Entry& entry)
+                            {
+                                if (std::strcmp(entry.name, name) == 0)
+                                {
+                                    found = true;
+                                } });
+    return found;
+}
+
+std::unique_ptr<Thread<bool>> startBusy(const std::string& name, std::atomic<bool>& running)
+{
+    auto thread = std::make_unique<Thread<bool>>(name);
+    thread->invoke([]() -> bool
+                   {
+        burnCpu(1);
+        return true; });
+    thread->setPredicate([&running]() -> bool
+                         { return running.load(); });
+    thread->start(RunMode::LOOP);
+    while (!registered(name.c_str()))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return thread;
+}
+
+uint64_t samplesOf(const std::string& folded, const std::string& name)
+{
+    uint64_t total = 0;
+    std::istringstream lines(folded);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.compare(0, name.size() + 1, name + ";") == 0)
+        {
+            total += std::stoull(line.substr(line.rfind(' ') + 1));
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+#ifdef __linux__
+
+/**
+ * @brief Test that a busy thread is sampled under its name, and an idle thread hardly at all.
+ */
+TEST(SamplingProfilerTest, SamplesBusyThreadByName)
+{
+    std::atomic<bool> running{true};
+    Thread<bool> idle("profiled-idle");
+    idle.invoke([]() -> bool
+                {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return true; });
+    idle.setPredicate([&running]() -> bool
+                      { return running.load(); });
+    idle.start(RunMode::LOOP);
+    while (!registered("profiled-idle"))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto busy = startBusy("profiled-spin", running);
+
+    SamplingProfiler::Settings settings;
+    settings.interval_us = 1000;
+    ASSERT_TRUE(SamplingProfiler::start(settings));
+    EXPECT_TRUE(SamplingProfiler::running());
+    EXPECT_FALSE(SamplingProfiler::start(settings));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    SamplingProfiler::stop();
+    EXPECT_FALSE(SamplingProfiler::running());
+    running = false;
+    busy->stop();
+    idle.stop();
+
+    const std::string folded = SamplingProfiler::folded();
+    const uint64_t busy_samples = samplesOf(folded, "profiled-spin");
+    EXPECT_GT(SamplingProfiler::samples(), 0u);
+    EXPECT_GT(busy_samples, 10u);
+    EXPECT_LT(samplesOf(folded, "profiled-idle"), busy_samples);
+    EXPECT_NE(folded.find("burnCpu"), std::string::npos) << folded;
+    EXPECT_EQ(SamplingProfiler::dropped(), 0u);
+}
+
+/**
+ * @brief Test that a full buffer drops samples, and that a restart discards the previous ones.
+ */
+TEST(SamplingProfilerTest, DropsWhenBufferIsFull)
+{
+    std::atomic<bool> running{true};
+    auto busy = startBusy("profiled-full", running);
+
+    SamplingProfiler::Settings settings;
+    settings.interval_us = 1000;
+    settings.samples_per_thread = 4;
+    ASSERT_TRUE(SamplingProfiler::start(settings));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    SamplingProfiler::stop();
+    running = false;
+    busy->stop();
+
+    EXPECT_EQ(samplesOf(SamplingProfiler::folded(), "profiled-full"), 4u);
+    EXPECT_GT(SamplingProfiler::dropped(), 0u);
+    EXPECT_EQ(samplesOf(SamplingProfiler::folded(), "profiled-spin"), 0u);
+}
+
+#else
+
+/**
+ * @brief Test that the profiler reports itself as unsupported.
+ */
+TEST(SamplingProfilerTest, Unsupported)
+{
+    EXPECT_FALSE(SamplingProfiler::start(SamplingProfiler::Settings{}));
+    EXPECT_TRUE(SamplingProfiler::folded().empty());
+}
+
+#endif
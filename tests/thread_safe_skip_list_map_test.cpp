@@ -0,0 +1,182 @@
+#include "thread_safe/skip_list_map.hpp"
+#include "thread_safe/variable.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+using Map = SkipListMap<int, int>;
+
+/**
+ * @brief Test for insert, find and erase of single entries.
+ */
+TEST(SkipListMapTest, InsertFindErase)
+{
+    Map map;
+    EXPECT_TRUE(map.empty());
+
+    EXPECT_TRUE(map.insert(1, 10));
+    EXPECT_TRUE(map.insert(2, 20));
+    EXPECT_FALSE(map.insert(1, 11)); // Duplicate keys are rejected.
+    EXPECT_EQ(map.size(), 2u);
+
+    EXPECT_EQ(map.find(1), std::optional<int>{10});
+    EXPECT_EQ(map.find(3), std::nullopt);
+    EXPECT_TRUE(map.contains(2));
+
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_FALSE(map.erase(1)); // Already erased.
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_EQ(map.size(), 1u);
+}
+
+/**
+ * @brief Test that iteration and range scans visit keys in order.
+ */
+TEST(SkipListMapTest, OrderedIteration)
+{
+    Map map;
+    for (int key : {5, 3, 9, 1, 7})
+    {
+        ASSERT_TRUE(map.insert(key, key * 10));
+    }
+
+    std::vector<int> keys;
+    map.forEach([&keys](const int& key, const int& value)
+                {
+        EXPECT_EQ(value, key * 10);
+        keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<int>{1, 3, 5, 7, 9}));
+
+    keys.clear();
+    map.forEachInRange(3, 9, [&keys](const int& key, const int&)
+                       { keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<int>{3, 5, 7}));
+}
+
+/**
+ * @brief Test for concurrent inserts and erases on disjoint and overlapping keys.
+ */
+TEST(SkipListMapTest, ConcurrentInsertErase)
+{
+    Map map;
+    constexpr int THREADS{4};
+    constexpr int KEYS_PER_THREAD{2000};
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        writers.emplace_back([&map, t]()
+                             {
+            for (int i = 0; i < KEYS_PER_THREAD; ++i) {
+                map.insert(t * KEYS_PER_THREAD + i, i);
+            }
+            // Erase the odd keys again while the other writers are still inserting.
+            for (int i = 1; i < KEYS_PER_THREAD; i += 2) {
+                EXPECT_TRUE(map.erase(t * KEYS_PER_THREAD + i));
+            } });
+    }
+    std::thread reader([&map]()
+                       {
+        for (int round = 0; round < 50; ++round) {
+            int previous{-1};
+            map.forEach([&previous](const int& key, const int&) {
+                EXPECT_LT(previous, key); // Scans stay ordered under concurrent writes.
+                previous = key;
+            });
+        } });
+
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+    reader.join();
+
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(THREADS * KEYS_PER_THREAD / 2));
+    for (int key = 0; key < THREADS * KEYS_PER_THREAD; ++key)
+    {
+        EXPECT_EQ(map.contains(key), key % 2 == 0);
+    }
+
+    Epoch::collect();
+}
+
+/**
+ * @brief Compare a mixed read/write workload against Variable<std::map>.
+ *
+ * Prints the elapsed time of both maps for several read ratios; the numbers are informative only.
+ */
+TEST(SkipListMapTest, MixedWorkloadVersusVariableMap)
+{
+    constexpr int THREADS{4};
+    constexpr int OPS_PER_THREAD{20000};
+    constexpr int KEY_RANGE{1024};
+
+    for (int read_percent : {50, 90, 99})
+    {
+        auto run = [&](auto&& read, auto&& write)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < THREADS; ++t)
+            {
+                threads.emplace_back([&, t]()
+                                     {
+                    uint32_t seed = 2654435761u * static_cast<uint32_t>(t + 1);
+                    for (int i = 0; i < OPS_PER_THREAD; ++i) {
+                        seed = seed * 1664525u + 1013904223u;
+                        int key = static_cast<int>(seed >> 8) % KEY_RANGE;
+                        if (static_cast<int>(seed % 100) < read_percent) {
+                            read(key);
+                        } else {
+                            write(key);
+                        }
+                    } });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        Map skip_list;
+        auto skip_list_us = run([&](int key)
+                                { skip_list.forEachInRange(key, key + 16, [](const int&, const int&) {}); },
+                                [&](int key)
+                                {
+                                    if (!skip_list.insert(key, key))
+                                    {
+                                        skip_list.erase(key);
+                                    }
+                                });
+
+        Variable<std::map<int, int>> locked_map;
+        auto locked_map_us = run([&](int key)
+                                 { locked_map.invoke([key](std::map<int, int>& map)
+                                                     {
+                                         for (auto it = map.lower_bound(key); it != map.end() && it->first < key + 16; ++it) {
+                                         } }); },
+                                 [&](int key)
+                                 { locked_map.invoke([key](std::map<int, int>& map)
+                                                     {
+                                         if (!map.emplace(key, key).second) {
+                                             map.erase(key);
+                                         } }); });
+
+        std::cout << "reads " << read_percent << "%: SkipListMap " << skip_list_us << " us, Variable<std::map> "
+                  << locked_map_us << " us" << std::endl;
+    }
+    Epoch::collect();
+    SUCCEED();
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include "thread_safe/spmc_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+/**
+ * @brief Test for non-blocking push and pop, including the full ring.
+ */
+TEST(SpmcQueueTest, TryPushTryPop)
+{
+    SpmcQueue<int> queue(3);
+    EXPECT_EQ(queue.capacity(), 4u); // Rounded up to a power of two.
+
+    int value{-1};
+    EXPECT_FALSE(queue.tryPop(value));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(4)); // Full.
+    EXPECT_EQ(queue.size(), 4u);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(queue.tryPush(5)); // Slots are reused after wrapping.
+}
+
+/**
+ * @brief Test for pop timeout on an empty ring and push timeout on a full ring.
+ */
+TEST(SpmcQueueTest, Timeouts)
+{
+    SpmcQueue<int> queue(1);
+    EXPECT_EQ(queue.capacity(), 2u);
+    int value{-1};
+    EXPECT_FALSE(queue.pop(value, 50));
+
+    EXPECT_TRUE(queue.push(1, 50));
+    EXPECT_TRUE(queue.push(2, 50));
+    EXPECT_FALSE(queue.push(3, 50));
+}
+
+/**
+ * @brief Test that a consumer blocked on empty is woken by the producer.
+ */
+TEST(SpmcQueueTest, BlockingPopWakesUp)
+{
+    SpmcQueue<int> queue(8);
+    std::thread producer([&queue]()
+                         {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_TRUE(queue.push(42)); });
+
+    int value{-1};
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 42);
+    producer.join();
+}
+
+/**
+ * @brief Test that close wakes blocked consumers while remaining elements are still delivered.
+ */
+TEST(SpmcQueueTest, CloseDrains)
+{
+    SpmcQueue<int> queue(8);
+    EXPECT_TRUE(queue.push(7));
+    queue.close();
+    EXPECT_FALSE(queue.push(8));
+
+    int value{-1};
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 7);
+    EXPECT_FALSE(queue.pop(value)); // Closed and drained, returns instead of blocking.
+}
+
+/**
+ * @brief Test one producer fanning out to several consumers: every element is delivered exactly once.
+ */
+TEST(SpmcQueueTest, FanOut)
+{
+    constexpr int CONSUMERS{4};
+    constexpr int ELEMENTS{100000};
+    SpmcQueue<int> queue(64);
+
+    std::atomic<long long> sum{0};
+    std::atomic<int> count{0};
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < CONSUMERS; ++c)
+    {
+        consumers.emplace_back([&]()
+                               {
+            int value;
+            while (queue.pop(value)) {
+                sum += value;
+                ++count;
+            } });
+    }
+
+    for (int i = 1; i <= ELEMENTS; ++i)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+    queue.close();
+    for (auto& consumer : consumers)
+    {
+        consumer.join();
+    }
+
+    EXPECT_EQ(count.load(), ELEMENTS);
+    EXPECT_EQ(sum.load(), static_cast<long long>(ELEMENTS) * (ELEMENTS + 1) / 2);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
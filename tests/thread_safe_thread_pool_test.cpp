@@ -0,0 +1,272 @@
+#include "thread_safe/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ThreadSafe;
+
+/**
+ * @brief Test for submitting tasks and collecting their results.
+ */
+TEST(ThreadPoolTest, SubmitAndGet)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 2;
+    ThreadPool pool(settings);
+
+    auto sum = pool.submit(ThreadPriority::NORMAL, [](int a, int b)
+                           { return a + b; },
+                           2,
+                           3);
+    auto done = pool.submit(ThreadPriority::LOWEST, []() {});
+    EXPECT_EQ(sum.get(), 5);
+    done.get();
+    EXPECT_EQ(pool.workers(), 2u);
+}
+
+/**
+ * @brief Test that higher levels are picked first when aging is disabled.
+ */
+TEST(ThreadPoolTest, HigherLevelsFirst)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 1;
+    settings.aging_ms = 0;
+    ThreadPool pool(settings);
+
+    // Keep the only worker busy while the other tasks are queued.
+    std::atomic<bool> release{false};
+    auto blocker = pool.submit(ThreadPriority::NORMAL, [&release]()
+                               {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } });
+
+    std::mutex lock;
+    std::vector<ThreadPriority> order;
+    std::vector<std::future<void>> futures;
+    for (auto priority : {ThreadPriority::LOWEST, ThreadPriority::NORMAL, ThreadPriority::TIME_CRITICAL, ThreadPriority::BELOW_NORMAL})
+    {
+        futures.push_back(pool.submit(priority, [&, priority]()
+                                      {
+            std::lock_guard<std::mutex> guard{lock};
+            order.push_back(priority); }));
+    }
+    release = true;
+    blocker.get();
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector<ThreadPriority>{ThreadPriority::TIME_CRITICAL, ThreadPriority::NORMAL, ThreadPriority::BELOW_NORMAL, ThreadPriority::LOWEST}));
+}
+
+/**
+ * @brief Test that an old low-priority task overtakes newer high-priority tasks through aging.
+ */
+TEST(ThreadPoolTest, AgingPreventsStarvation)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 1;
+    settings.aging_ms = 10;
+    ThreadPool pool(settings);
+
+    std::atomic<bool> release{false};
+    auto blocker = pool.submit(ThreadPriority::NORMAL, [&release]()
+                               {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } });
+
+    std::mutex lock;
+    std::vector<ThreadPriority> order;
+    auto record = [&](ThreadPriority priority)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        order.push_back(priority);
+    };
+    auto lowest = pool.submit(ThreadPriority::LOWEST, record, ThreadPriority::LOWEST);
+    // LOWEST is promoted by one level every 10 ms, so after 100 ms it ranks above HIGHEST.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto highest = pool.submit(ThreadPriority::HIGHEST, record, ThreadPriority::HIGHEST);
+
+    release = true;
+    blocker.get();
+    lowest.get();
+    highest.get();
+    EXPECT_EQ(order, (std::vector<ThreadPriority>{ThreadPriority::LOWEST, ThreadPriority::HIGHEST}));
+}
+
+/**
+ * @brief Test for dedicated workers and levels without any worker.
+ */
+TEST(ThreadPoolTest, DedicatedWorkers)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 0;
+    settings.dedicated = {{ThreadPriority::HIGHEST, 1}};
+    ThreadPool pool(settings);
+
+    auto served = pool.submit(ThreadPriority::HIGHEST, []()
+                              { return 7; });
+    EXPECT_EQ(served.get(), 7);
+
+    auto unserved = pool.submit(ThreadPriority::LOWEST, []()
+                                { return 0; });
+    EXPECT_FALSE(unserved.valid()); // No worker serves LOWEST.
+}
+
+/**
+ * @brief Test that shutdown runs the queued tasks and rejects new ones.
+ */
+TEST(ThreadPoolTest, ShutdownDrains)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 2;
+    ThreadPool pool(settings);
+
+    std::atomic<int> count{0};
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.submit(ThreadPriority::NORMAL, [&count]()
+                    { ++count; });
+    }
+    pool.shutdown();
+    EXPECT_EQ(count.load(), 100);
+    EXPECT_EQ(pool.pending(), 0u);
+    EXPECT_FALSE(pool.submit(ThreadPriority::NORMAL, []() {}).valid());
+}
+
+/**
+ * @brief Test that nested forks complete on a single worker, which runs the awaited tasks itself.
+ */
+TEST(ThreadPoolTest, ForkJoinOnSingleWorker)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 1;
+    ThreadPool pool(settings);
+
+    std::function<int(int)> fib = [&](int n) -> int
+    {
+        if (n < 2)
+        {
+            return n;
+        }
+        auto left = pool.fork(ThreadPriority::NORMAL, fib, n - 1);
+        auto right = pool.fork(ThreadPriority::NORMAL, fib, n - 2);
+        return left.get() + right.get();
+    };
+    auto result = pool.fork(ThreadPriority::NORMAL, fib, 15);
+    ASSERT_TRUE(result.valid());
+    EXPECT_TRUE(result.waitFor(10000));
+    EXPECT_EQ(result.get(), 610);
+    EXPECT_FALSE(result.valid());
+    EXPECT_EQ(pool.pending(), 0u);
+}
+
+/**
+ * @brief Test that a worker waiting on a running task runs other queued tasks meanwhile.
+ */
+TEST(ThreadPoolTest, HelpWhileWaiting)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 2;
+    ThreadPool pool(settings);
+
+    std::atomic<bool> child_started{false};
+    std::atomic<bool> released{false};
+    auto parent = pool.fork(ThreadPriority::NORMAL, [&]() -> bool
+                            {
+        // Taken by the other worker, then blocked on a task queued behind it.
+        auto child = pool.fork(ThreadPriority::NORMAL, [&]() -> bool
+                               {
+            child_started = true;
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!released && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return released.load(); });
+        while (!child_started)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // Only this worker is free to run the release task, while it waits on the child.
+        pool.submit(ThreadPriority::NORMAL, [&]()
+                    { released = true; });
+        return child.get(); });
+    EXPECT_TRUE(parent.get());
+}
+
+/**
+ * @brief Test that waiting outside the pool blocks and times out like std::future.
+ */
+TEST(ThreadPoolTest, TaskFutureOutsidePool)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 1;
+    ThreadPool pool(settings);
+
+    std::atomic<bool> release{false};
+    auto blocked = pool.fork(ThreadPriority::NORMAL, [&release]()
+                             {
+        while (!release)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } });
+    EXPECT_FALSE(blocked.waitFor(20));
+    release = true;
+    blocked.wait();
+    blocked.get();
+
+    pool.shutdown();
+    auto rejected = pool.fork(ThreadPriority::NORMAL, []() {});
+    EXPECT_FALSE(rejected.valid());
+    EXPECT_FALSE(rejected.waitFor(0));
+    rejected.wait(); // Returns at once instead of waiting on an invalid future.
+}
+
+/**
+ * @brief Test that concurrent shutdowns join once and that a worker cannot shut down its pool.
+ */
+TEST(ThreadPoolTest, ConcurrentAndWorkerShutdown)
+{
+    ThreadPool::Settings settings;
+    settings.workers = 2;
+    ThreadPool pool(settings);
+
+    auto from_worker = pool.submit(ThreadPriority::NORMAL, [&pool]()
+                                   { pool.shutdown(); });
+    EXPECT_EQ(from_worker.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(pool.workers(), 2u);
+
+    std::atomic<int> count{0};
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.submit(ThreadPriority::NORMAL, [&count]()
+                    { ++count; });
+    }
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i)
+    {
+        callers.emplace_back([&pool, &count]()
+                             {
+            pool.shutdown();
+            EXPECT_EQ(count.load(), 100); });
+    }
+    for (auto& caller : callers)
+    {
+        caller.join();
+    }
+    EXPECT_EQ(pool.workers(), 0u);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,8 +1,11 @@
+#include "thread_safe/queue.hpp"
 #include "thread_safe/thread.hpp"
+#include "thread_safe/thread_pool.hpp"
 #include <chrono>
 #include <functional>
 #include <gtest/gtest.h>
 #include <string>
+#include <vector>
 
 using namespace ThreadSafe;
 
@@ -236,6 +239,210 @@ TEST(ThreadTest, StartStopMultipleTimes) {
     SUCCEED(); // Ensure no errors occurred
 }
 
+// Results are delivered in order by the delivery thread, including those queued at stop
+TEST(ThreadTest, AsyncResultDelivery) {
+    constexpr int COUNT{500};
+    std::atomic<int> next{0};
+    std::atomic<bool> exited{false};
+    std::vector<int> delivered{};
+
+    Thread<int> thread("AsyncResultThread", ThreadPriority::NORMAL);
+    thread.invoke([&next]() -> int { return next++; });
+    thread.setPredicate([&next]() -> bool { return next < COUNT; });
+    thread.setExitCallback([&exited]() { exited = true; });
+
+    Thread<int>::ResultSettings settings{};
+    settings.delivery = ResultDelivery::ASYNC;
+    settings.queue_size = 16;
+    settings.discard = Queue<int>::Discard::NO_DISCARD;
+    EXPECT_TRUE(thread.setResultCallback([&delivered](const int &result) { delivered.push_back(result); }, settings));
+
+    EXPECT_TRUE(thread.start(RunMode::LOOP));
+    while (!exited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(thread.stop());
+
+    ASSERT_EQ(delivered.size(), static_cast<size_t>(COUNT));
+    for (int i = 0; i < COUNT; ++i) {
+        EXPECT_EQ(delivered[i], i);
+    }
+    EXPECT_EQ(thread.discardedResults(), 0u);
+}
+
+// A slow callback with a discard policy drops results instead of slowing the loop
+TEST(ThreadTest, AsyncResultDeliveryDiscard) {
+    constexpr int COUNT{200};
+    std::atomic<int> next{0};
+    std::atomic<int> delivered{0};
+
+    Thread<int> thread("AsyncDiscardThread", ThreadPriority::NORMAL);
+    thread.invoke([&next]() -> int { return next++; });
+    thread.setPredicate([&next]() -> bool { return next < COUNT; });
+
+    Thread<int>::ResultSettings settings{};
+    settings.delivery = ResultDelivery::ASYNC;
+    settings.queue_size = 4;
+    settings.discard = Queue<int>::Discard::DISCARD_OLDEST;
+    thread.setResultCallback(
+        [&delivered](const int &) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++delivered;
+        },
+        settings);
+
+    EXPECT_TRUE(thread.start(RunMode::LOOP));
+    while (next < COUNT) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(thread.stop());
+
+    EXPECT_GT(thread.discardedResults(), 0u);
+    EXPECT_EQ(delivered + static_cast<int>(thread.discardedResults()), COUNT);
+}
+
+// Results delivered through an executor arrive in order and never concurrently
+TEST(ThreadTest, AsyncResultDeliveryExecutor) {
+    constexpr int COUNT{300};
+    std::atomic<int> next{0};
+    std::atomic<bool> exited{false};
+    std::atomic<int> active{0};
+    std::atomic<bool> overlapped{false};
+    std::vector<int> delivered{};
+
+    ThreadPool::Settings pool_settings{};
+    pool_settings.workers = 2;
+    ThreadPool pool{pool_settings};
+
+    Thread<int> thread("AsyncExecutorThread", ThreadPriority::NORMAL);
+    thread.invoke([&next]() -> int { return next++; });
+    thread.setPredicate([&next]() -> bool { return next < COUNT; });
+    thread.setExitCallback([&exited]() { exited = true; });
+
+    Thread<int>::ResultSettings settings{};
+    settings.delivery = ResultDelivery::ASYNC;
+    settings.queue_size = 32;
+    settings.executor = [&pool](std::function<void()> task) { return pool.submit(ThreadPriority::NORMAL, std::move(task)).valid(); };
+    thread.setResultCallback(
+        [&](const int &result) {
+            if (active++ > 0) {
+                overlapped = true;
+            }
+            delivered.push_back(result);
+            --active;
+        },
+        settings);
+
+    EXPECT_TRUE(thread.start(RunMode::LOOP));
+    while (!exited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(thread.stop());
+
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(delivered.size(), static_cast<size_t>(COUNT));
+    for (int i = 0; i < COUNT; ++i) {
+        EXPECT_EQ(delivered[i], i);
+    }
+}
+
+// Results rejected by a shut down executor are delivered by the loop instead of hanging it
+TEST(ThreadTest, AsyncResultDeliveryRejected) {
+    constexpr int COUNT{50};
+    std::atomic<int> next{0};
+    std::atomic<bool> exited{false};
+    std::vector<int> delivered{};
+
+    ThreadPool::Settings pool_settings{};
+    pool_settings.workers = 1;
+    ThreadPool pool{pool_settings};
+    pool.shutdown();
+
+    Thread<int> thread("AsyncRejectedThread", ThreadPriority::NORMAL);
+    thread.invoke([&next]() -> int { return next++; });
+    thread.setPredicate([&next]() -> bool { return next < COUNT; });
+    thread.setExitCallback([&exited]() { exited = true; });
+
+    Thread<int>::ResultSettings settings{};
+    settings.delivery = ResultDelivery::ASYNC;
+    settings.queue_size = COUNT;
+    settings.executor = [&pool](std::function<void()> task) { return pool.submit(ThreadPriority::NORMAL, std::move(task)).valid(); };
+    thread.setResultCallback([&delivered](const int &result) { delivered.push_back(result); }, settings);
+
+    EXPECT_TRUE(thread.start(RunMode::LOOP));
+    while (!exited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(thread.stop());
+
+    ASSERT_EQ(delivered.size(), static_cast<size_t>(COUNT));
+    for (int i = 0; i < COUNT; ++i) {
+        EXPECT_EQ(delivered[i], i);
+    }
+}
+
+// A rejecting executor with a single slot neither blocks the loop on the full queue nor hangs stop
+TEST(ThreadTest, AsyncResultDeliveryRejectedFull) {
+    constexpr int COUNT{20};
+    std::atomic<int> next{0};
+    std::atomic<bool> exited{false};
+    std::vector<int> delivered{};
+
+    Thread<int> thread("AsyncRejectedFullThread", ThreadPriority::NORMAL);
+    thread.invoke([&next]() -> int { return next++; });
+    thread.setPredicate([&next]() -> bool { return next < COUNT; });
+    thread.setExitCallback([&exited]() { exited = true; });
+
+    Thread<int>::ResultSettings settings{};
+    settings.delivery = ResultDelivery::ASYNC;
+    settings.queue_size = 1;
+    settings.executor = [](std::function<void()>) { return false; };
+    thread.setResultCallback([&delivered](const int &result) { delivered.push_back(result); }, settings);
+
+    EXPECT_TRUE(thread.start(RunMode::LOOP));
+    while (!exited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(thread.stop());
+
+    ASSERT_EQ(delivered.size(), static_cast<size_t>(COUNT));
+    for (int i = 0; i < COUNT; ++i) {
+        EXPECT_EQ(delivered[i], i);
+    }
+    EXPECT_EQ(thread.discardedResults(), 0u);
+}
+
+// Loop throughput with a slow result callback, inline versus asynchronous delivery
+TEST(ThreadTest, AsyncResultDeliveryThroughput) {
+    constexpr auto RUN_TIME{std::chrono::milliseconds(200)};
+    auto measure = [&RUN_TIME](const ResultDelivery delivery) -> int {
+        std::atomic<int> iterations{0};
+        Thread<int> thread("ThroughputThread", ThreadPriority::NORMAL);
+        thread.invoke([&iterations]() -> int {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            return iterations++;
+        });
+
+        Thread<int>::ResultSettings settings{};
+        settings.delivery = delivery;
+        settings.queue_size = 64;
+        settings.discard = Queue<int>::Discard::DISCARD_OLDEST;
+        thread.setResultCallback([](const int &) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }, settings);
+
+        thread.start(RunMode::LOOP);
+        std::this_thread::sleep_for(RUN_TIME);
+        const int result{iterations};
+        thread.stop();
+        return result;
+    };
+
+    const int inline_iterations{measure(ResultDelivery::INLINE)};
+    const int async_iterations{measure(ResultDelivery::ASYNC)};
+    std::cout << "Loop iterations in " << RUN_TIME.count() << " ms, inline: " << inline_iterations
+              << ", async: " << async_iterations << std::endl;
+    EXPECT_GT(async_iterations, 2 * inline_iterations);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,266 @@
+#include "allocation_hooks.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+// Plain data with constant initialization, so touching it inside `operator new` cannot allocate.
+struct ThreadState
+{
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes;
+    uint64_t violations;
+    uint32_t forbidding; ///< Active `NoAllocationScope`s.
+    uint32_t aborting;   ///< Active `NoAllocationScope`s with `Policy::ABORT`.
+};
+
+thread_local ThreadState t_state{};
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_deallocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+void recordAllocation(const std::size_t size)
+{
+    ++t_state.allocations;
+    t_state.bytes += size;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (t_state.forbidding == 0)
+    {
+        return;
+    }
+    ++t_state.violations;
+    if (t_state.aborting > 0)
+    {
+        // No logger here, it may allocate itself.
+        t_state.aborting = 0;
+        t_state.forbidding = 0;
+        std::fputs("Allocation inside a NoAllocationScope\n", stderr);
+        std::abort();
+    }
+}
+
+void* allocate(const std::size_t size, const std::size_t alignment)
+{
+    recordAllocation(size);
+    // Zero-size allocations must still return a unique pointer.
+    const std::size_t bytes{size == 0 ? 1 : size};
+    if (alignment <= alignof(std::max_align_t))
+    {
+        return std::malloc(bytes);
+    }
+#ifdef _WIN32
+    return ::_aligned_malloc(bytes, alignment);
+#else
+    // `aligned_alloc` wants a multiple of the alignment.
+    return std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void deallocate(void* ptr, const std::size_t alignment)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    ++t_state.deallocations;
+    g_deallocations.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t))
+    {
+        ::_aligned_free(ptr);
+        return;
+    }
+#else
+    UNUSED_PARAMETER(alignment);
+#endif
+    std::free(ptr);
+}
+
+void* allocateOrThrow(const std::size_t size, const std::size_t alignment)
+{
+    void* ptr{allocate(size, alignment)};
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+} // namespace
+
+AllocationCounters AllocationCounters::operator-(const AllocationCounters& other) const
+{
+    return AllocationCounters{allocations - other.allocations, deallocations - other.deallocations, bytes - other.bytes};
+}
+
+AllocationCounters threadAllocations()
+{
+    return AllocationCounters{t_state.allocations, t_state.deallocations, t_state.bytes};
+}
+
+AllocationCounters processAllocations()
+{
+    return AllocationCounters{g_allocations.load(std::memory_order_relaxed), g_deallocations.load(std::memory_order_relaxed),
+                              g_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationScope::AllocationScope()
+    : m_start{threadAllocations()}
+{
+}
+
+AllocationCounters AllocationScope::counters() const
+{
+    return threadAllocations() - m_start;
+}
+
+double AllocationScope::perOperation(const uint64_t operations) const
+{
+    if (operations == 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(counters().allocations) / static_cast<double>(operations);
+}
+
+NoAllocationScope::NoAllocationScope(const Policy policy)
+    : m_policy{policy}
+    , m_start{t_state.violations}
+{
+    ++t_state.forbidding;
+    if (m_policy == Policy::ABORT)
+    {
+        ++t_state.aborting;
+    }
+}
+
+NoAllocationScope::~NoAllocationScope()
+{
+    --t_state.forbidding;
+    if (m_policy == Policy::ABORT)
+    {
+        --t_state.aborting;
+    }
+}
+
+uint64_t NoAllocationScope::violations() const
+{
+    return t_state.violations - m_start;
+}
+
+} // namespace ThreadSafe
+
+// Replacements of every global allocation function, see [new.delete].
+
+void* operator new(std::size_t size)
+{
+    return ThreadSafe::allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return ThreadSafe::allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ThreadSafe::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ThreadSafe::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return ThreadSafe::allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ThreadSafe::allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return ThreadSafe::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return ThreadSafe::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    ThreadSafe::deallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    ThreadSafe::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <cstdint>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Allocation counts kept by the allocation hooks.
+ *
+ * The hooks live in the separate `ThreadSafeAllocationHooks` library, which replaces the global
+ * `operator new` and `operator delete` of every binary that links it. The functions and classes
+ * declared here are defined in that library, so using them is what opts a test or benchmark in;
+ * the `ThreadSafe` library itself never references them.
+ */
+struct AllocationCounters
+{
+    uint64_t allocations{0};   ///< Calls of `operator new`.
+    uint64_t deallocations{0}; ///< Calls of `operator delete` with a non-null pointer.
+    uint64_t bytes{0};         ///< Bytes requested by the allocations.
+
+    AllocationCounters operator-(const AllocationCounters& other) const;
+};
+
+/**
+ * @brief Counters of the calling thread since it started.
+ * @return The counters.
+ */
+AllocationCounters threadAllocations();
+
+/**
+ * @brief Counters of every thread of the process since it started.
+ * @return The counters.
+ */
+AllocationCounters processAllocations();
+
+/**
+ * @brief Measures the allocations of the calling thread from construction on.
+ */
+class AllocationScope
+{
+public:
+    AllocationScope();
+
+    // Make this class uncopyable
+    UNCOPYABLE(AllocationScope);
+
+    /**
+     * @brief Allocations of the calling thread since construction.
+     * @return The counters.
+     */
+    AllocationCounters counters() const;
+
+    /**
+     * @brief Allocations per operation, for benchmark reports.
+     * @param operations The number of operations run in the scope.
+     * @return The average number of allocations, 0 without operations.
+     */
+    double perOperation(const uint64_t operations) const;
+
+private:
+    const AllocationCounters m_start;
+};
+
+/**
+ * @brief Forbids allocations on the calling thread while it exists.
+ *
+ * Every allocation in the scope is a violation: it is counted, and with `Policy::ABORT` the
+ * process prints a message and aborts inside `operator new`, so a debugger or core dump shows
+ * the allocating call stack. Scopes can be nested.
+ */
+class NoAllocationScope
+{
+public:
+    enum class Policy : uint32_t
+    {
+        COUNT = 0, ///< Count the violations, see `violations`.
+        ABORT = 1  ///< Abort on the first violation.
+    };
+
+    explicit NoAllocationScope(const Policy policy = Policy::COUNT);
+
+    ~NoAllocationScope();
+
+    // Make this class uncopyable
+    UNCOPYABLE(NoAllocationScope);
+
+    /**
+     * @brief Allocations of the calling thread since construction.
+     * @return The number of violations.
+     */
+    uint64_t violations() const;
+
+private:
+    const Policy m_policy;
+    const uint64_t m_start;
+};
+
+} // namespace ThreadSafe
@@ -0,0 +1,59 @@
+#include "batch_controller.hpp"
+
+#include <algorithm>
+
+namespace ThreadSafe
+{
+
+BatchController::BatchController(const Settings& settings)
+    : m_settings{settings}
+    , m_batch{std::clamp(settings.initial_batch, settings.min_batch, std::max(settings.min_batch, settings.max_batch))}
+{
+}
+
+std::size_t BatchController::batchSize() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return m_batch;
+}
+
+uint32_t BatchController::lingerUs() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return static_cast<uint32_t>(m_linger_us);
+}
+
+void BatchController::record(const std::size_t popped, const std::size_t backlog, const std::chrono::microseconds processing)
+{
+    if (popped == 0)
+    {
+        return;
+    }
+    const double budget_us{static_cast<double>(m_settings.latency_budget_us)};
+    const double processing_us{static_cast<double>(processing.count())};
+    const std::size_t max_batch{std::max(m_settings.min_batch, m_settings.max_batch)};
+
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (m_linger_us + processing_us > budget_us)
+    {
+        const auto decreased{static_cast<std::size_t>(static_cast<double>(m_batch) * m_settings.decrease_factor)};
+        m_batch = std::max(m_settings.min_batch, decreased);
+        m_linger_us *= m_settings.decrease_factor;
+        return;
+    }
+    // At least, another worker may have shrunk the size since this batch was popped.
+    if (popped >= m_batch || backlog > 0)
+    {
+        m_batch = std::min(max_batch, m_batch + m_settings.batch_step);
+        const double headroom_us{budget_us - processing_us};
+        m_linger_us = std::min({m_linger_us + m_settings.linger_step_us, static_cast<double>(m_settings.max_linger_us), headroom_us});
+        return;
+    }
+    m_linger_us *= m_settings.decrease_factor;
+    if (m_linger_us < 1.0)
+    {
+        m_linger_us = 0.0;
+    }
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,81 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Adapts the batch size and linger time of a consumer to its load, within a latency budget.
+ *
+ * A consumer asks for `batchSize` and `lingerUs` before each `Queue::popBatch` and reports the
+ * outcome with `record`. The controller adjusts both with AIMD, like TCP congestion control:
+ *
+ * - A batch whose linger plus processing time exceeded `latency_budget_us` cuts both values by
+ *   `decrease_factor`.
+ * - A full batch, or a backlog left behind, means the consumer falls behind. While within the
+ *   budget, the batch size grows by `batch_step` to amortize the per-batch cost, and the linger
+ *   time by `linger_step_us`, bounded by the budget left after processing.
+ * - A partial batch that emptied the queue means the consumer keeps up. The linger time is cut by
+ *   `decrease_factor`, so low load is served without waiting for batches that do not fill.
+ *
+ * Thread-safe, several workers of one queue may share a controller.
+ */
+class BatchController
+{
+public:
+    /**
+     * @brief Settings for the controller.
+     */
+    struct Settings
+    {
+        uint32_t latency_budget_us{10000}; ///< Target for linger plus processing time of a batch.
+        std::size_t min_batch{1};          ///< Smallest batch size.
+        std::size_t max_batch{1024};       ///< Largest batch size.
+        std::size_t initial_batch{16};     ///< Batch size at the start.
+        std::size_t batch_step{1};         ///< Additive increase of the batch size.
+        uint32_t max_linger_us{1000};      ///< Longest linger time.
+        uint32_t linger_step_us{50};       ///< Additive increase of the linger time.
+        double decrease_factor{0.5};       ///< Multiplicative decrease, in (0, 1).
+    };
+
+    /**
+     * @brief Constructor.
+     * @param settings Settings for the controller.
+     */
+    explicit BatchController(const Settings& settings);
+
+    // Make this class uncopyable
+    UNCOPYABLE(BatchController);
+
+    /**
+     * @brief Batch size for the next pop.
+     * @return The maximum number of elements.
+     */
+    std::size_t batchSize() const;
+
+    /**
+     * @brief Linger time for the next pop.
+     * @return The linger time in microseconds.
+     */
+    uint32_t lingerUs() const;
+
+    /**
+     * @brief Report the outcome of a batch.
+     * @param popped Elements in the batch, batches of 0 are ignored.
+     * @param backlog Elements left in the queue after the pop.
+     * @param processing Time spent processing the batch.
+     */
+    void record(const std::size_t popped, const std::size_t backlog, const std::chrono::microseconds processing);
+
+private:
+    const Settings m_settings;
+    mutable std::mutex m_lock{};
+    std::size_t m_batch;     ///< Current batch size.
+    double m_linger_us{0.0}; ///< Current linger time, fractional so that decreases converge to 0.
+};
+
+} // namespace ThreadSafe
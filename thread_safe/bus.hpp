@@ -0,0 +1,358 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "epoch.hpp"
+#include "queue.hpp"
+#include "skip_list_map.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief In-process publish/subscribe bus with topics.
+ *
+ * A message is published once as a `std::shared_ptr<const T>`, and every subscriber of the topic
+ * receives the same pointer, so the payload is never copied per subscriber. Each subscriber has
+ * its own bounded `Queue` with its own discard policy, so a slow subscriber loses its own messages
+ * (or, with `NO_DISCARD`, briefly holds up the publisher) without affecting the others.
+ *
+ * Topics are kept in a `SkipListMap` and the subscriber list of a topic is copy-on-write, read
+ * through a pointer protected by `Epoch`. `publish` thus takes no lock and touches no shared
+ * reference count besides those of the subscriber queues and the message. A publisher waiting for
+ * room in a `NO_DISCARD` queue delays the reclamation of replaced subscriber lists meanwhile.
+ *
+ * @tparam T Type of the message payload.
+ */
+template<typename T>
+class Bus
+{
+public:
+    using Message = std::shared_ptr<const T>;
+    using Discard = typename Queue<Message>::Discard;
+    static constexpr uint32_t WAIT_FOREVER = Queue<Message>::WAIT_FOREVER;
+
+    /**
+     * @brief Settings for one subscriber.
+     */
+    struct SubscriberSettings
+    {
+        std::size_t capacity{1024};               ///< Maximum number of queued messages.
+        Discard discard{Discard::DISCARD_OLDEST}; ///< Policy when the queue is full.
+        uint32_t publish_timeout_ms{0};           ///< With `NO_DISCARD`, how long a publisher waits for room.
+    };
+
+    /**
+     * @brief Receiving end of one subscriber. Unsubscribes when destroyed.
+     */
+    class Subscription
+    {
+    public:
+        ~Subscription();
+
+        // Make this class uncopyable
+        UNCOPYABLE(Subscription);
+
+        /**
+         * @brief Receive the oldest queued message.
+         * @param message Receives the message.
+         * @param timeout_ms The maximum time to wait in milliseconds. Defaults to `WAIT_FOREVER`.
+         * @return `true` if a message was received, `false` on timeout or after unsubscribing.
+         */
+        bool receive(Message& message, const uint32_t timeout_ms = WAIT_FOREVER);
+
+        /**
+         * @brief Receive up to `max_messages` queued messages with one wait.
+         * @param messages Receives the messages, appended in order.
+         * @param max_messages Maximum number of messages to receive.
+         * @param timeout_ms The maximum time to wait for the first message in milliseconds.
+         * @return The number of messages received.
+         */
+        std::size_t receiveBatch(std::vector<Message>& messages, const std::size_t max_messages,
+                                 const uint32_t timeout_ms = WAIT_FOREVER);
+
+        /**
+         * @brief Stop receiving new messages. Queued messages can still be received.
+         */
+        void unsubscribe();
+
+        /**
+         * @brief Number of messages waiting to be received.
+         * @return The number of messages.
+         */
+        std::size_t pending() const;
+
+        /**
+         * @brief Number of messages this subscriber lost to its discard policy.
+         * @return The number of messages.
+         */
+        uint64_t dropped() const;
+
+        /**
+         * @brief The subscribed topic.
+         * @return The topic.
+         */
+        const std::string& topic() const;
+
+    private:
+        friend class Bus;
+
+        struct Inbox
+        {
+            Queue<Message> queue;
+            const bool blocking;                ///< `NO_DISCARD`, a full queue times out instead of discarding.
+            const uint32_t publish_timeout_ms;  ///< Wait for room when blocking.
+            std::atomic<bool> subscribed{true}; ///< Cleared before the inbox leaves the topic.
+            std::atomic<uint64_t> dropped{0};   ///< Messages lost by this subscriber.
+
+            Inbox(const typename Queue<Message>::Settings& settings, const uint32_t timeout_ms)
+                : queue{settings}
+                , blocking{settings.discard == Discard::NO_DISCARD}
+                , publish_timeout_ms{timeout_ms}
+            {
+            }
+        };
+
+        Subscription(Bus& bus, const std::string& topic, const SubscriberSettings& settings);
+
+        Bus& m_bus;
+        const std::string m_topic;
+        std::shared_ptr<Inbox> m_inbox;
+        bool m_subscribed{true};
+    };
+
+    Bus() = default;
+
+    // Make this class uncopyable
+    UNCOPYABLE(Bus);
+
+    /**
+     * @brief Subscribe to a topic. The bus must outlive the subscription.
+     * @param topic The topic.
+     * @param settings Settings for the subscriber's queue.
+     * @return The subscription.
+     */
+    std::unique_ptr<Subscription> subscribe(const std::string& topic, const SubscriberSettings& settings);
+
+    /**
+     * @brief Publish a message to every current subscriber of a topic.
+     * @param topic The topic.
+     * @param message The message, shared by all subscribers.
+     * @return The number of subscribers that queued the message.
+     */
+    std::size_t publish(const std::string& topic, Message message);
+
+    /**
+     * @brief Construct a payload in place and publish it.
+     * @tparam Args Types of the constructor arguments.
+     * @param topic The topic.
+     * @param args Arguments for the constructor of `T`.
+     * @return The number of subscribers that queued the message.
+     */
+    template<typename... Args>
+    std::size_t emplace(const std::string& topic, Args&&... args);
+
+    /**
+     * @brief Number of current subscribers of a topic.
+     * @param topic The topic.
+     * @return The number of subscribers.
+     */
+    std::size_t subscribers(const std::string& topic) const;
+
+private:
+    using Inbox = typename Subscription::Inbox;
+    using Inboxes = std::vector<std::shared_ptr<Inbox>>;
+
+    /**
+     * @brief Subscribers of one topic. Topics are never removed, only emptied.
+     */
+    struct Topic
+    {
+        std::atomic<const Inboxes*> inboxes{new Inboxes{}}; ///< Replaced on update, the old list is retired to `Epoch`.
+
+        ~Topic()
+        {
+            delete inboxes.load();
+        }
+    };
+
+    SkipListMap<std::string, Topic*> m_topics{};
+    std::vector<std::unique_ptr<Topic>> m_topic_storage{}; ///< Owns the topics, protected by `m_lock`.
+    std::mutex m_lock{};                                   ///< Serializes subscriber list updates.
+
+    Topic* topicOf(const std::string& topic); ///< Find or create a topic, with the lock held.
+    void add(const std::string& topic, const std::shared_ptr<Inbox>& inbox);
+    void remove(const std::string& topic, const std::shared_ptr<Inbox>& inbox);
+};
+
+template<typename T>
+Bus<T>::Subscription::Subscription(Bus& bus, const std::string& topic, const SubscriberSettings& settings)
+    : m_bus{bus}
+    , m_topic{topic}
+{
+    typename Queue<Message>::Settings queue_settings{};
+    queue_settings.discard = settings.discard;
+    queue_settings.control = Queue<Message>::Control::PUSH;
+    queue_settings.size = std::max<std::size_t>(1, settings.capacity);
+    m_inbox = std::make_shared<Inbox>(queue_settings, settings.publish_timeout_ms);
+    m_inbox->queue.openPush();
+    Inbox* inbox{m_inbox.get()};
+    m_inbox->queue.setDiscardedCallback([inbox](const Message&)
+                                        { ++inbox->dropped; });
+}
+
+template<typename T>
+Bus<T>::Subscription::~Subscription()
+{
+    unsubscribe();
+}
+
+template<typename T>
+bool Bus<T>::Subscription::receive(Message& message, const uint32_t timeout_ms)
+{
+    return m_inbox->queue.pop(message, timeout_ms);
+}
+
+template<typename T>
+std::size_t Bus<T>::Subscription::receiveBatch(std::vector<Message>& messages, const std::size_t max_messages,
+                                               const uint32_t timeout_ms)
+{
+    return m_inbox->queue.popBatch(messages, max_messages, timeout_ms);
+}
+
+template<typename T>
+void Bus<T>::Subscription::unsubscribe()
+{
+    if (!m_subscribed)
+    {
+        return;
+    }
+    m_subscribed = false;
+    m_inbox->subscribed = false;
+    m_bus.remove(m_topic, m_inbox);
+    // Receivers blocked on an empty queue return once push is closed.
+    m_inbox->queue.closePush();
+}
+
+template<typename T>
+std::size_t Bus<T>::Subscription::pending() const
+{
+    return m_inbox->queue.size();
+}
+
+template<typename T>
+uint64_t Bus<T>::Subscription::dropped() const
+{
+    return m_inbox->dropped;
+}
+
+template<typename T>
+const std::string& Bus<T>::Subscription::topic() const
+{
+    return m_topic;
+}
+
+template<typename T>
+std::unique_ptr<typename Bus<T>::Subscription> Bus<T>::subscribe(const std::string& topic, const SubscriberSettings& settings)
+{
+    std::unique_ptr<Subscription> subscription{new Subscription(*this, topic, settings)};
+    add(topic, subscription->m_inbox);
+    return subscription;
+}
+
+template<typename T>
+std::size_t Bus<T>::publish(const std::string& topic, Message message)
+{
+    const std::optional<Topic*> entry{m_topics.find(topic)};
+    if (!entry || message == nullptr)
+    {
+        return 0;
+    }
+    Epoch::Guard guard{};
+    const Inboxes* inboxes{(*entry)->inboxes.load(std::memory_order_acquire)};
+    std::size_t delivered{0};
+    for (const std::shared_ptr<Inbox>& inbox : *inboxes)
+    {
+        // Only the reference count changes per subscriber, the payload is shared.
+        if (inbox->queue.push(message, inbox->publish_timeout_ms))
+        {
+            ++delivered;
+        }
+        else if (inbox->blocking && inbox->subscribed)
+        {
+            // A timed out NO_DISCARD push, discarding queues count their drops in the callback.
+            ++inbox->dropped;
+        }
+    }
+    return delivered;
+}
+
+template<typename T>
+template<typename... Args>
+std::size_t Bus<T>::emplace(const std::string& topic, Args&&... args)
+{
+    return publish(topic, std::make_shared<const T>(std::forward<Args>(args)...));
+}
+
+template<typename T>
+std::size_t Bus<T>::subscribers(const std::string& topic) const
+{
+    const std::optional<Topic*> entry{m_topics.find(topic)};
+    if (!entry)
+    {
+        return 0;
+    }
+    Epoch::Guard guard{};
+    return (*entry)->inboxes.load(std::memory_order_acquire)->size();
+}
+
+template<typename T>
+typename Bus<T>::Topic* Bus<T>::topicOf(const std::string& topic)
+{
+    std::optional<Topic*> entry{m_topics.find(topic)};
+    if (entry)
+    {
+        return *entry;
+    }
+    m_topic_storage.push_back(std::make_unique<Topic>());
+    Topic* created{m_topic_storage.back().get()};
+    m_topics.insert(topic, created);
+    return created;
+}
+
+template<typename T>
+void Bus<T>::add(const std::string& topic, const std::shared_ptr<Inbox>& inbox)
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    Topic* entry{topicOf(topic)};
+    const Inboxes* current{entry->inboxes.load()};
+    auto* inboxes{new Inboxes(*current)};
+    inboxes->push_back(inbox);
+    entry->inboxes.store(inboxes, std::memory_order_release);
+    // Publishers may still iterate the old list.
+    Epoch::retire(current);
+}
+
+template<typename T>
+void Bus<T>::remove(const std::string& topic, const std::shared_ptr<Inbox>& inbox)
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    Topic* entry{topicOf(topic)};
+    const Inboxes* current{entry->inboxes.load()};
+    auto* inboxes{new Inboxes(*current)};
+    inboxes->erase(std::remove(inboxes->begin(), inboxes->end(), inbox), inboxes->end());
+    entry->inboxes.store(inboxes, std::memory_order_release);
+    Epoch::retire(current);
+}
+
+} // namespace ThreadSafe
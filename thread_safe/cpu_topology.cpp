@@ -0,0 +1,300 @@
+#include "cpu_topology.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+#ifdef __linux__
+/**
+ * @brief Lowest CPU index in a sysfs cpu list such as "0-3,8-11".
+ */
+int32_t firstCpuOfList(const std::string& list)
+{
+    try
+    {
+        return static_cast<int32_t>(std::stol(list));
+    }
+    catch (const std::exception&)
+    {
+        return -1;
+    }
+}
+
+/**
+ * @brief Read the cache domain of one CPU from the highest cache level listed in sysfs.
+ */
+int32_t readCacheDomain(int32_t cpu)
+{
+    const std::string cache_dir{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index"};
+    int32_t best_level{-1};
+    int32_t domain{-1};
+    for (int32_t index{0};; ++index)
+    {
+        std::ifstream level_file{cache_dir + std::to_string(index) + "/level"};
+        std::ifstream shared_file{cache_dir + std::to_string(index) + "/shared_cpu_list"};
+        if (!level_file || !shared_file)
+        {
+            break;
+        }
+        int32_t level{-1};
+        std::string shared{};
+        level_file >> level;
+        shared_file >> shared;
+        if (level > best_level)
+        {
+            best_level = level;
+            domain = firstCpuOfList(shared);
+        }
+    }
+    return domain;
+}
+
+/**
+ * @brief Number of CPUs in a cpu list such as "0-3,8-11", 0 if empty or malformed.
+ */
+uint32_t countCpuList(const std::string& list)
+{
+    uint32_t count{0};
+    std::stringstream ranges{list};
+    std::string range{};
+    while (std::getline(ranges, range, ','))
+    {
+        try
+        {
+            const std::size_t dash{range.find('-')};
+            const long first{std::stol(range)};
+            const long last{dash == std::string::npos ? first : std::stol(range.substr(dash + 1))};
+            if (last < first)
+            {
+                return 0;
+            }
+            count += static_cast<uint32_t>(last - first + 1);
+        }
+        catch (const std::exception&)
+        {
+            return 0;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief CPU quota of a cgroup rounded up to whole CPUs, 0 if unlimited.
+ */
+uint32_t readCpuQuota(const std::string& dir)
+{
+    long long quota{-1};
+    long long period{0};
+    std::ifstream cpu_max{dir + "/cpu.max"};
+    if (cpu_max)
+    {
+        // cgroup v2: "<quota> <period>", the quota is "max" if unlimited.
+        std::string quota_text{};
+        cpu_max >> quota_text >> period;
+        if (quota_text != "max")
+        {
+            try
+            {
+                quota = std::stoll(quota_text);
+            }
+            catch (const std::exception&)
+            {
+                quota = -1;
+            }
+        }
+    }
+    else
+    {
+        std::ifstream quota_file{dir + "/cpu.cfs_quota_us"};
+        std::ifstream period_file{dir + "/cpu.cfs_period_us"};
+        if (!quota_file || !(quota_file >> quota) || !period_file || !(period_file >> period))
+        {
+            return 0;
+        }
+    }
+    if (quota <= 0 || period <= 0)
+    {
+        return 0;
+    }
+    return static_cast<uint32_t>((quota + period - 1) / period);
+}
+
+/**
+ * @brief Number of CPUs in the cpuset of a cgroup, 0 if not set.
+ */
+uint32_t readCpuset(const std::string& dir)
+{
+    for (const char* name : {"/cpuset.cpus.effective", "/cpuset.cpus"})
+    {
+        std::ifstream file{dir + name};
+        std::string list{};
+        if (file >> list)
+        {
+            return countCpuList(list);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Smallest limit of the process's cgroups and their ancestors, 0 if none is set.
+ *
+ * Each line of /proc/self/cgroup is "<id>:<controllers>:<path>", with empty controllers for cgroup
+ * v2. Inside a cgroup namespace the path is relative to the mounted hierarchy.
+ */
+uint32_t processCgroupCpuLimit()
+{
+    std::ifstream cgroups{"/proc/self/cgroup"};
+    uint32_t limit{0};
+    std::string line{};
+    while (std::getline(cgroups, line))
+    {
+        const std::size_t first{line.find(':')};
+        const std::size_t second{line.find(':', first + 1)};
+        if (first == std::string::npos || second == std::string::npos)
+        {
+            continue;
+        }
+        const std::string controllers{line.substr(first + 1, second - first - 1)};
+        std::string path{line.substr(second + 1)};
+        std::vector<std::string> mounts{};
+        if (controllers.empty())
+        {
+            mounts = {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"};
+        }
+        else
+        {
+            std::stringstream names{controllers};
+            std::string name{};
+            while (std::getline(names, name, ','))
+            {
+                if (name == "cpu" || name == "cpuset")
+                {
+                    mounts = {"/sys/fs/cgroup/" + controllers};
+                    if (name != controllers)
+                    {
+                        mounts.push_back("/sys/fs/cgroup/" + name);
+                    }
+                    break;
+                }
+            }
+        }
+        for (const std::string& mount : mounts)
+        {
+            // Parents limit their children, so every level up to the mount counts.
+            std::string current{path};
+            while (true)
+            {
+                const uint32_t level_limit{cgroupCpuLimit(current == "/" ? mount : mount + current)};
+                if (level_limit > 0)
+                {
+                    limit = limit == 0 ? level_limit : std::min(limit, level_limit);
+                }
+                const std::size_t slash{current.find_last_of('/')};
+                if (current.empty() || current == "/" || slash == std::string::npos)
+                {
+                    break;
+                }
+                current = slash == 0 ? "/" : current.substr(0, slash);
+            }
+        }
+    }
+    return limit;
+}
+#endif
+
+/**
+ * @brief Cache domain of every configured CPU, read once on first use.
+ */
+const std::vector<int32_t>& cacheDomains()
+{
+    static const std::vector<int32_t> domains{[]()
+                                              {
+                                                  std::vector<int32_t> result{};
+#ifdef __linux__
+                                                  const long cpus{::sysconf(_SC_NPROCESSORS_CONF)};
+                                                  for (int32_t cpu{0}; cpu < cpus; ++cpu)
+                                                  {
+                                                      result.push_back(readCacheDomain(cpu));
+                                                  }
+#endif
+                                                  return result;
+                                              }()};
+    return domains;
+}
+
+} // namespace
+
+int32_t currentCpu()
+{
+#ifdef __linux__
+    return static_cast<int32_t>(::sched_getcpu());
+#else
+    return -1;
+#endif
+}
+
+int32_t cacheDomainOf(int32_t cpu)
+{
+    const std::vector<int32_t>& domains{cacheDomains()};
+    if (cpu < 0 || static_cast<std::size_t>(cpu) >= domains.size())
+    {
+        return -1;
+    }
+    return domains[static_cast<std::size_t>(cpu)];
+}
+
+uint32_t cpuBudget()
+{
+    static const uint32_t budget{[]()
+                                 {
+                                     uint32_t cpus{std::max(1u, std::thread::hardware_concurrency())};
+#ifdef __linux__
+                                     cpu_set_t affinity;
+                                     CPU_ZERO(&affinity);
+                                     if (::sched_getaffinity(0, sizeof(affinity), &affinity) == 0 && CPU_COUNT(&affinity) > 0)
+                                     {
+                                         cpus = static_cast<uint32_t>(CPU_COUNT(&affinity));
+                                     }
+                                     const uint32_t limit{processCgroupCpuLimit()};
+                                     if (limit > 0)
+                                     {
+                                         cpus = std::min(cpus, limit);
+                                     }
+#endif
+                                     return cpus;
+                                 }()};
+    return budget;
+}
+
+uint32_t cgroupCpuLimit(const std::string& cgroup_dir)
+{
+#ifdef __linux__
+    const uint32_t quota{readCpuQuota(cgroup_dir)};
+    const uint32_t cpuset{readCpuset(cgroup_dir)};
+    if (quota == 0 || cpuset == 0)
+    {
+        return std::max(quota, cpuset);
+    }
+    return std::min(quota, cpuset);
+#else
+    UNUSED_PARAMETER(cgroup_dir);
+    return 0;
+#endif
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,48 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief CPU the calling thread is currently running on.
+ * @return The CPU index, or -1 if the platform cannot tell.
+ */
+int32_t currentCpu();
+
+/**
+ * @brief Identifier of the last-level cache shared by a CPU.
+ *
+ * CPUs with the same identifier share their last-level cache, so data written on one of them is
+ * cheap to read on the others. The identifier is the lowest CPU index sharing that cache.
+ *
+ * @param cpu The CPU index.
+ * @return The cache domain, or -1 if unknown.
+ */
+int32_t cacheDomainOf(int32_t cpu);
+
+/**
+ * @brief Number of CPUs the process can actually keep busy.
+ *
+ * `std::thread::hardware_concurrency` reports every CPU of the host, also inside a container that
+ * may only use a few of them. This is the smallest of the CPUs in the affinity mask, the CPU quota
+ * of the process's cgroup and of its ancestors (`cpu.max` for cgroup v2, `cpu.cfs_quota_us` for
+ * v1, rounded up to whole CPUs) and their `cpuset`. Read once on first use; pools and other
+ * parallel code size themselves from it by default.
+ *
+ * @return The number of CPUs, at least 1.
+ */
+uint32_t cpuBudget();
+
+/**
+ * @brief CPU limit configured in one cgroup directory.
+ * @param cgroup_dir The cgroup directory, e.g. `/sys/fs/cgroup/cpu,cpuacct/service`.
+ * @return The smaller of the CPU quota rounded up and the number of CPUs in the cpuset, 0 if
+ *         neither is set.
+ */
+uint32_t cgroupCpuLimit(const std::string& cgroup_dir);
+
+} // namespace ThreadSafe
@@ -0,0 +1,220 @@
+#include "epoch.hpp"
+
+#include <mutex>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+constexpr uint64_t ACTIVE_BIT{1};
+constexpr std::size_t COLLECT_THRESHOLD{64}; // Retired objects per thread before trying to reclaim
+constexpr uint64_t SAFE_DISTANCE{2};         // Epochs that must pass before a retired object is freed
+
+struct Retired
+{
+    uint64_t epoch;
+    Epoch::Deleter deleter;
+};
+
+/**
+ * @brief Per-thread announcement record. Records are never freed, only recycled between threads.
+ */
+struct Record
+{
+    std::atomic<uint64_t> state{0};   ///< (epoch << 1) | ACTIVE_BIT while inside a critical section
+    std::atomic<bool> in_use{false};  ///< Owned by a live thread
+    Record* next{nullptr};            ///< Immutable once the record is published
+    uint32_t nesting{0};              ///< Guard nesting depth, owner thread only
+    std::vector<Retired> retired{};   ///< Objects waiting for reclamation, owner thread only
+};
+
+struct Globals
+{
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<Record*> records{nullptr};
+    std::atomic<std::size_t> pending{0};
+    std::mutex orphan_lock{};
+    std::vector<Retired> orphans{}; ///< Objects left behind by exited threads
+};
+
+Globals& globals()
+{
+    // Intentionally leaked: retired objects may outlive static destruction of other translation units.
+    static Globals* instance{new Globals{}};
+    return *instance;
+}
+
+Record* acquireRecord()
+{
+    Globals& g{globals()};
+    for (Record* record{g.records.load()}; record != nullptr; record = record->next)
+    {
+        bool expected{false};
+        if (!record->in_use && record->in_use.compare_exchange_strong(expected, true))
+        {
+            return record;
+        }
+    }
+    Record* record{new Record{}};
+    record->in_use = true;
+    Record* head{g.records.load()};
+    do
+    {
+        record->next = head;
+    } while (!g.records.compare_exchange_weak(head, record));
+    return record;
+}
+
+/**
+ * @brief Reclaim every object in `retired` whose epoch is old enough, keep the rest.
+ */
+std::size_t reclaim(std::vector<Retired>& retired, uint64_t current)
+{
+    std::size_t freed{0};
+    auto keep{retired.begin()};
+    for (auto it{retired.begin()}; it != retired.end(); ++it)
+    {
+        if (it->epoch + SAFE_DISTANCE <= current)
+        {
+            it->deleter();
+            ++freed;
+        }
+        else
+        {
+            *keep++ = std::move(*it);
+        }
+    }
+    retired.erase(keep, retired.end());
+    return freed;
+}
+
+class LocalRecord
+{
+public:
+    LocalRecord()
+        : m_record{acquireRecord()}
+    {
+    }
+
+    ~LocalRecord()
+    {
+        Globals& g{globals()};
+        if (!m_record->retired.empty())
+        {
+            std::lock_guard<std::mutex> lock{g.orphan_lock};
+            for (auto& retired : m_record->retired)
+            {
+                g.orphans.push_back(std::move(retired));
+            }
+            m_record->retired.clear();
+        }
+        m_record->state = 0;
+        m_record->nesting = 0;
+        m_record->in_use = false;
+    }
+
+    Record* get() const
+    {
+        return m_record;
+    }
+
+private:
+    Record* m_record;
+};
+
+Record* localRecord()
+{
+    thread_local LocalRecord local{};
+    return local.get();
+}
+
+bool tryAdvance()
+{
+    Globals& g{globals()};
+    uint64_t current{g.epoch.load()};
+    for (Record* record{g.records.load()}; record != nullptr; record = record->next)
+    {
+        const uint64_t state{record->state.load()};
+        if ((state & ACTIVE_BIT) && (state >> 1) != current)
+        {
+            return false;
+        }
+    }
+    return g.epoch.compare_exchange_strong(current, current + 1);
+}
+
+} // namespace
+
+Epoch::Guard::Guard()
+{
+    Record* record{localRecord()};
+    if (record->nesting++ != 0)
+    {
+        return;
+    }
+    Globals& g{globals()};
+    uint64_t epoch{g.epoch.load()};
+    while (true)
+    {
+        // Re-announce until the announcement is not stale, so an advance cannot slip past us.
+        record->state.store((epoch << 1) | ACTIVE_BIT);
+        const uint64_t current{g.epoch.load()};
+        if (current == epoch)
+        {
+            break;
+        }
+        epoch = current;
+    }
+}
+
+Epoch::Guard::~Guard()
+{
+    Record* record{localRecord()};
+    if (--record->nesting == 0)
+    {
+        record->state.store(0, std::memory_order_release);
+    }
+}
+
+void Epoch::retire(Deleter deleter)
+{
+    Globals& g{globals()};
+    Record* record{localRecord()};
+    record->retired.push_back(Retired{g.epoch.load(), std::move(deleter)});
+    ++g.pending;
+    if (record->retired.size() >= COLLECT_THRESHOLD && record->nesting == 0)
+    {
+        collect();
+    }
+}
+
+void Epoch::collect()
+{
+    Globals& g{globals()};
+    Record* record{localRecord()};
+    if (record->nesting != 0)
+    {
+        return;
+    }
+    // Two advances are needed before anything retired in the current epoch becomes reclaimable.
+    tryAdvance();
+    tryAdvance();
+    const uint64_t current{g.epoch.load()};
+    g.pending -= reclaim(record->retired, current);
+
+    std::unique_lock<std::mutex> lock{g.orphan_lock, std::try_to_lock};
+    if (lock.owns_lock() && !g.orphans.empty())
+    {
+        g.pending -= reclaim(g.orphans, current);
+    }
+}
+
+std::size_t Epoch::pending()
+{
+    return globals().pending;
+}
+
+} // namespace ThreadSafe
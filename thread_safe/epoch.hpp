@@ -0,0 +1,72 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Epoch-based memory reclamation for lock-free data structures.
+ *
+ * Readers enter a critical section with `Epoch::Guard`; nodes unlinked by writers are handed to
+ * `Epoch::retire` and freed only once every thread that could still observe them has left its
+ * critical section. Entering and leaving a critical section costs two stores on the calling thread,
+ * so lookups stay lock-free and never touch a shared reference count.
+ */
+class Epoch
+{
+public:
+    using Deleter = std::function<void()>;
+
+    /**
+     * @brief RAII critical section. Pointers loaded while a guard is alive stay valid until it is destroyed.
+     *
+     * Guards may be nested on the same thread.
+     */
+    class Guard
+    {
+    public:
+        Guard();
+        ~Guard();
+
+        // Make this class uncopyable
+        UNCOPYABLE(Guard);
+    };
+
+    /**
+     * @brief Defer the destruction of an unlinked object until no guard can still reference it.
+     * @param deleter Callable that frees the object.
+     */
+    static void retire(Deleter deleter);
+
+    /**
+     * @brief Convenience overload that deletes `ptr` with `delete` once it is safe.
+     * @tparam T Type of the retired object.
+     * @param ptr Object already unlinked from every shared structure.
+     */
+    template<typename T>
+    static void retire(T* ptr)
+    {
+        retire([ptr]()
+               { delete ptr; });
+    }
+
+    /**
+     * @brief Try to advance the global epoch and free everything that became safe.
+     *
+     * Called periodically by `retire`; exposed so that owners can reclaim eagerly, e.g. in tests or
+     * before measuring memory usage. Must not be called while holding a `Guard`.
+     */
+    static void collect();
+
+    /**
+     * @brief Number of retired objects that have not been freed yet, across all threads.
+     * @return The pending object count.
+     */
+    static std::size_t pending();
+};
+
+} // namespace ThreadSafe
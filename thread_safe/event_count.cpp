@@ -0,0 +1,142 @@
+#include "event_count.hpp"
+
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+#ifdef __linux__
+/**
+ * @brief Address of the epoch half of the state word, used as the futex.
+ */
+uint32_t* epochAddress(std::atomic<uint64_t>& state)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    constexpr std::size_t EPOCH_INDEX{1};
+#else
+    constexpr std::size_t EPOCH_INDEX{0};
+#endif
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Unexpected atomic layout");
+    return reinterpret_cast<uint32_t*>(&state) + EPOCH_INDEX;
+}
+
+void futexWait(uint32_t* addr, uint32_t expected, const ::timespec* timeout)
+{
+    ::syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+void futexWake(uint32_t* addr, int count)
+{
+    ::syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+EventCount::Key EventCount::epoch() const
+{
+    return static_cast<Key>(m_state.load(std::memory_order_acquire) >> EPOCH_SHIFT);
+}
+
+EventCount::Key EventCount::prepareWait()
+{
+    const uint64_t prev{m_state.fetch_add(1, std::memory_order_seq_cst)};
+    return static_cast<Key>(prev >> EPOCH_SHIFT);
+}
+
+void EventCount::cancelWait()
+{
+    m_state.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void EventCount::wait(Key key)
+{
+#ifdef __linux__
+    while (epoch() == key)
+    {
+        futexWait(epochAddress(m_state), key, nullptr);
+    }
+#else
+    std::unique_lock<std::mutex> lock{m_lock};
+    m_condition.wait(lock, [this, key]() -> bool
+                     { return epoch() != key; });
+#endif
+    m_state.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+bool EventCount::waitUntil(Key key, Clock::time_point deadline)
+{
+#ifdef __linux__
+    while (epoch() == key)
+    {
+        const auto now{Clock::now()};
+        if (now >= deadline)
+        {
+            break;
+        }
+        const auto remaining{std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count()};
+        constexpr int64_t NANOS_PER_SECOND{1000000000};
+        ::timespec timeout{};
+        timeout.tv_sec = static_cast<time_t>(remaining / NANOS_PER_SECOND);
+        timeout.tv_nsec = static_cast<long>(remaining % NANOS_PER_SECOND);
+        futexWait(epochAddress(m_state), key, &timeout);
+    }
+#else
+    {
+        std::unique_lock<std::mutex> lock{m_lock};
+        m_condition.wait_until(lock, deadline, [this, key]() -> bool
+                               { return epoch() != key; });
+    }
+#endif
+    const bool notified{epoch() != key};
+    m_state.fetch_sub(1, std::memory_order_seq_cst);
+    return notified;
+}
+
+void EventCount::notify()
+{
+    doNotify(false);
+}
+
+void EventCount::notifyAll()
+{
+    doNotify(true);
+}
+
+void EventCount::doNotify(bool all)
+{
+    // Pairs with the fetch_add in prepareWait: either the waiter sees the new condition on its
+    // re-check, or we see the waiter here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ((m_state.load(std::memory_order_relaxed) & WAITER_MASK) == 0)
+    {
+        return;
+    }
+    m_state.fetch_add(EPOCH_INC, std::memory_order_seq_cst);
+#ifdef __linux__
+    futexWake(epochAddress(m_state), all ? INT_MAX : 1);
+#else
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+    }
+    if (all)
+    {
+        m_condition.notify_all();
+    }
+    else
+    {
+        m_condition.notify_one();
+    }
+#endif
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,95 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Condition-variable replacement for lock-free data structures.
+ *
+ * An event count lets a thread block until a lock-free condition becomes true without the
+ * signalling side ever taking a lock while nobody is waiting. Waiters follow a two-phase protocol:
+ *
+ * @code
+ * while (!tryConsume()) {
+ *     auto key = event_count.prepareWait();
+ *     if (tryConsume()) { event_count.cancelWait(); break; }
+ *     event_count.wait(key);
+ * }
+ * @endcode
+ *
+ * The signalling side makes the condition true and then calls `notify`, which costs a single
+ * atomic load when there are no waiters. On Linux waiters block on a futex; elsewhere a mutex and
+ * condition variable are used for the slow path only.
+ */
+class EventCount
+{
+public:
+    using Key = uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Default constructor.
+     */
+    EventCount() = default;
+
+    // Make this class uncopyable
+    UNCOPYABLE(EventCount);
+
+    /**
+     * @brief Register the calling thread as a waiter. Must be followed by `cancelWait`, `wait` or `waitUntil`.
+     * @return Key identifying the current generation of notifications.
+     */
+    Key prepareWait();
+
+    /**
+     * @brief Unregister after `prepareWait` when the condition turned out to be true.
+     */
+    void cancelWait();
+
+    /**
+     * @brief Block until a notification newer than `key` arrives.
+     * @param key Key returned by `prepareWait`.
+     */
+    void wait(Key key);
+
+    /**
+     * @brief Block until a notification newer than `key` arrives or the deadline passes.
+     * @param key Key returned by `prepareWait`.
+     * @param deadline Absolute time after which the wait gives up.
+     * @return `true` if notified, `false` on timeout.
+     */
+    bool waitUntil(Key key, Clock::time_point deadline);
+
+    /**
+     * @brief Wake one waiter, if any.
+     */
+    void notify();
+
+    /**
+     * @brief Wake every waiter, if any.
+     */
+    void notifyAll();
+
+private:
+    static constexpr uint64_t WAITER_MASK{0xFFFFFFFFull};
+    static constexpr uint32_t EPOCH_SHIFT{32};
+    static constexpr uint64_t EPOCH_INC{uint64_t{1} << EPOCH_SHIFT};
+
+    std::atomic<uint64_t> m_state{0}; ///< (epoch << 32) | number of waiters
+#if !defined(__linux__)
+    std::mutex m_lock{};
+    std::condition_variable m_condition{};
+#endif
+
+    void doNotify(bool all);
+    Key epoch() const;
+};
+
+} // namespace ThreadSafe
@@ -0,0 +1,191 @@
+#include "event_loop.hpp"
+
+#include <algorithm>
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+template<typename Timer>
+bool later(const Timer& left, const Timer& right)
+{
+    return left.time != right.time ? left.time > right.time : left.sequence > right.sequence;
+}
+
+} // namespace
+
+EventLoop::EventLoop(const std::string& name, const ThreadPriority priority)
+    : m_thread{name, priority}
+{
+    m_thread.invoke([this]() -> bool
+                    { return iterate(); });
+    m_thread.setPredicate([this]() -> bool
+                          { return !m_stopping; });
+    m_thread.setStartCallback([this]()
+                              { m_loop_id = std::this_thread::get_id(); });
+    m_thread.setExitCallback([this]()
+                             {
+                                 finish();
+                                 m_loop_id = std::thread::id{}; });
+}
+
+EventLoop::~EventLoop()
+{
+    stop();
+}
+
+bool EventLoop::start()
+{
+    if (isLoopThread())
+    {
+        return false;
+    }
+    m_stopping = false;
+    return m_thread.start(RunMode::LOOP);
+}
+
+bool EventLoop::stop()
+{
+    if (isLoopThread())
+    {
+        LOG_ERROR("Cannot stop the event loop from its own thread");
+        return false;
+    }
+    m_stopping = true;
+    m_event.notifyAll();
+    const bool stopped{m_thread.stop()};
+    // Timers that were not due, and tasks posted while the loop was finishing.
+    clear();
+    return stopped;
+}
+
+bool EventLoop::post(Task task)
+{
+    return push(std::move(task), Clock::time_point::min());
+}
+
+bool EventLoop::postDelayed(Task task, const uint32_t delay_ms)
+{
+    return push(std::move(task), Clock::now() + std::chrono::milliseconds(delay_ms));
+}
+
+bool EventLoop::postAt(Task task, const Clock::time_point time)
+{
+    return push(std::move(task), time);
+}
+
+bool EventLoop::isLoopThread() const
+{
+    return m_loop_id.load() == std::this_thread::get_id();
+}
+
+std::string EventLoop::name() const
+{
+    return m_thread.name();
+}
+
+bool EventLoop::push(Task task, const Clock::time_point time)
+{
+    if (!task)
+    {
+        LOG_ERROR("Cannot post an empty task");
+        return false;
+    }
+    auto* node{new Node{std::move(task), time}};
+    Node* head{m_inbox.load(std::memory_order_relaxed)};
+    do
+    {
+        node->next = head;
+    } while (!m_inbox.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    // A non-empty inbox was already signalled by whoever pushed its first node.
+    if (head == nullptr)
+    {
+        m_event.notify();
+    }
+    return true;
+}
+
+bool EventLoop::iterate()
+{
+    takeInbox();
+    runDueTimers();
+    if (m_stopping)
+    {
+        return false;
+    }
+    const EventCount::Key key{m_event.prepareWait()};
+    if (m_inbox.load(std::memory_order_acquire) != nullptr || m_stopping)
+    {
+        m_event.cancelWait();
+    }
+    else if (m_timers.empty())
+    {
+        m_event.wait(key);
+    }
+    else
+    {
+        m_event.waitUntil(key, m_timers.front().time);
+    }
+    return true;
+}
+
+void EventLoop::takeInbox()
+{
+    Node* node{m_inbox.exchange(nullptr, std::memory_order_acquire)};
+    m_ready.clear();
+    for (; node != nullptr; node = node->next)
+    {
+        m_ready.push_back(node);
+    }
+    // The inbox is newest first.
+    for (auto it{m_ready.rbegin()}; it != m_ready.rend(); ++it)
+    {
+        Node* ready{*it};
+        if (ready->time == Clock::time_point::min())
+        {
+            ready->task();
+        }
+        else
+        {
+            m_timers.push_back(Timer{ready->time, m_sequence++, std::move(ready->task)});
+            std::push_heap(m_timers.begin(), m_timers.end(), later<Timer>);
+        }
+        delete ready;
+    }
+    m_ready.clear();
+}
+
+void EventLoop::runDueTimers()
+{
+    // Timers posted by the callbacks go through the inbox, so this ends even if they are due at once.
+    const Clock::time_point now{Clock::now()};
+    while (!m_timers.empty() && m_timers.front().time <= now)
+    {
+        std::pop_heap(m_timers.begin(), m_timers.end(), later<Timer>);
+        Timer timer{std::move(m_timers.back())};
+        m_timers.pop_back();
+        timer.task();
+    }
+}
+
+void EventLoop::finish()
+{
+    takeInbox();
+    runDueTimers();
+}
+
+void EventLoop::clear()
+{
+    Node* node{m_inbox.exchange(nullptr, std::memory_order_acquire)};
+    while (node != nullptr)
+    {
+        Node* next{node->next};
+        delete node;
+        node = next;
+    }
+    m_timers.clear();
+}
+
+} // namespace ThreadSafe
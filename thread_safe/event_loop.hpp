@@ -0,0 +1,138 @@
+#pragma once
+#include "common/common.hpp"
+
+#include "event_count.hpp"
+#include "thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief A thread that runs posted tasks and timer callbacks one at a time.
+ *
+ * Any thread can post. Posting pushes onto a lock-free inbox with one compare-and-swap and wakes
+ * the loop only if it sleeps. The loop thread moves the posted tasks out of the inbox in one
+ * exchange, runs the immediate ones in the order they were posted, keeps the delayed ones in a
+ * timer heap that only it touches, and then sleeps until the earliest timer or the next post.
+ *
+ * Timers run in order of their time, timers with the same time in the order they were posted.
+ */
+class EventLoop
+{
+public:
+    using Task = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Constructor.
+     * @param name The name of the loop thread.
+     * @param priority The priority of the loop thread.
+     */
+    explicit EventLoop(const std::string& name, const ThreadPriority priority = ThreadPriority::NORMAL);
+
+    /**
+     * @brief Destructor that stops the loop and drops the tasks that did not run.
+     */
+    ~EventLoop();
+
+    // Make this class uncopyable
+    UNCOPYABLE(EventLoop);
+
+    /**
+     * @brief Start the loop thread. Tasks posted before are run once it starts.
+     * @return `true` if started, `false` if already running.
+     */
+    bool start();
+
+    /**
+     * @brief Stop the loop thread.
+     *
+     * Tasks posted before this call and timers already due are run first, timers not due yet are
+     * dropped. Must not be called from the loop thread.
+     *
+     * @return `true` if stopped, `false` if not running.
+     */
+    bool stop();
+
+    /**
+     * @brief Run a task on the loop thread as soon as possible.
+     * @param task The task.
+     * @return `true` if posted, `false` if the task is empty.
+     */
+    bool post(Task task);
+
+    /**
+     * @brief Run a task on the loop thread after a delay.
+     * @param task The task.
+     * @param delay_ms The delay in milliseconds.
+     * @return `true` if posted, `false` if the task is empty.
+     */
+    bool postDelayed(Task task, const uint32_t delay_ms);
+
+    /**
+     * @brief Run a task on the loop thread at a point in time.
+     * @param task The task.
+     * @param time When to run the task, a time in the past runs it as soon as possible.
+     * @return `true` if posted, `false` if the task is empty.
+     */
+    bool postAt(Task task, const Clock::time_point time);
+
+    /**
+     * @brief Check whether the calling thread is the loop thread.
+     * @return `true` if called from a task or timer of this loop, `false` otherwise.
+     */
+    bool isLoopThread() const;
+
+    /**
+     * @brief Returns the name of the loop thread.
+     * @return The name of the loop thread.
+     */
+    std::string name() const;
+
+private:
+    /**
+     * @brief A posted task, linked in the inbox until the loop takes it.
+     */
+    struct Node
+    {
+        Task task;
+        Clock::time_point time; ///< When to run, `Clock::time_point::min()` for immediate tasks.
+        Node* next{nullptr};
+    };
+
+    /**
+     * @brief A delayed task in the timer heap.
+     */
+    struct Timer
+    {
+        Clock::time_point time;
+        uint64_t sequence; ///< Post order, breaks ties between equal times.
+        Task task;
+    };
+
+    Thread<bool> m_thread;
+    std::atomic<Node*> m_inbox{nullptr};      ///< Posted tasks, newest first.
+    EventCount m_event{};                     ///< The loop sleeps here.
+    std::atomic<bool> m_stopping{false};      ///< The loop must return.
+    std::atomic<std::thread::id> m_loop_id{}; ///< Id of the loop thread while it runs.
+    std::vector<Timer> m_timers{};            ///< Min-heap by time, loop thread only.
+    uint64_t m_sequence{0};                   ///< Next timer sequence, loop thread only.
+    std::vector<Node*> m_ready{};             ///< Reused by `takeInbox`, loop thread only.
+
+    bool push(Task task, const Clock::time_point time); ///< Push onto the inbox and wake the loop.
+    bool iterate();                                     ///< One iteration of the loop thread.
+    void takeInbox();                                   ///< Run immediate tasks, move delayed ones to the heap.
+    void runDueTimers();                                ///< Run every timer whose time has come.
+    void finish();                                      ///< Run what is due before the thread exits.
+    void clear();                                       ///< Drop every task that did not run.
+};
+
+} // namespace ThreadSafe
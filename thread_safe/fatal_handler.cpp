@@ -0,0 +1,218 @@
+#include "fatal_handler.hpp"
+
+#include "thread_registry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+
+#ifdef __linux__
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+#ifdef __linux__
+constexpr int FATAL_SIGNALS[]{SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+constexpr std::size_t NUM_OF_SIGNALS{sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0])};
+
+FatalHandler::Settings g_settings{};
+struct sigaction g_previous[NUM_OF_SIGNALS]{};
+std::atomic<bool> g_installed{false};
+std::atomic<bool> g_reporting{false};
+alignas(16) char g_alternate_stack[64 * 1024];
+#endif
+
+/**
+ * @brief Line formatter on a fixed buffer, writing with plain `write` calls.
+ */
+class SignalWriter
+{
+public:
+    explicit SignalWriter(const int fd)
+        : m_fd{fd}
+    {
+    }
+
+    ~SignalWriter()
+    {
+        flush();
+    }
+
+    SignalWriter& operator<<(const char* text)
+    {
+        while (*text != '\0')
+        {
+            if (m_length == sizeof(m_buffer))
+            {
+                flush();
+            }
+            m_buffer[m_length++] = *text++;
+        }
+        return *this;
+    }
+
+    SignalWriter& operator<<(const int64_t value)
+    {
+        char digits[24];
+        const auto result{std::to_chars(digits, digits + sizeof(digits) - 1, value)};
+        *result.ptr = '\0';
+        return *this << digits;
+    }
+
+    void flush()
+    {
+#ifdef __linux__
+        std::size_t written{0};
+        while (written < m_length)
+        {
+            const ssize_t result{::write(m_fd, m_buffer + written, m_length - written)};
+            if (result <= 0)
+            {
+                break;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+#endif
+        m_length = 0;
+    }
+
+private:
+    const int m_fd;
+    char m_buffer[512];
+    std::size_t m_length{0};
+};
+
+const char* signalName(const int signal)
+{
+    switch (signal)
+    {
+    case SIGSEGV:
+        return "SIGSEGV";
+    case SIGFPE:
+        return "SIGFPE";
+    case SIGILL:
+        return "SIGILL";
+    case SIGABRT:
+        return "SIGABRT";
+#ifdef SIGBUS
+    case SIGBUS:
+        return "SIGBUS";
+#endif
+    default:
+        return "unknown signal";
+    }
+}
+
+#ifdef __linux__
+void onFatalSignal(const int signal)
+{
+    // A second thread crashing at the same time waits for the first report to end the process.
+    if (g_reporting.exchange(true))
+    {
+        while (true)
+        {
+            ::pause();
+        }
+    }
+    FatalHandler::report(g_settings.fd, signal);
+    if (g_settings.backtrace)
+    {
+        void* frames[256];
+        const int max_frames{static_cast<int>(std::min<uint32_t>(g_settings.max_frames, 256))};
+        const int count{::backtrace(frames, max_frames)};
+        SignalWriter{g_settings.fd} << "Backtrace:\n";
+        ::backtrace_symbols_fd(frames, count, g_settings.fd);
+    }
+    Logger::Sink* sink{Logger::sink()};
+    if (sink != nullptr)
+    {
+        sink->flushFromSignal();
+    }
+    // SA_RESETHAND restored the default action, deliver the signal again once we return.
+    ::raise(signal);
+}
+#endif
+
+} // namespace
+
+bool FatalHandler::install(const Settings& settings)
+{
+#ifdef __linux__
+    if (g_installed.exchange(true))
+    {
+        LOG_WARNING("The fatal handler has already been installed!")
+        return false;
+    }
+    g_settings = settings;
+    // The first backtrace call loads libgcc, which must not happen inside the handler.
+    void* frame{nullptr};
+    ::backtrace(&frame, 1);
+
+    stack_t stack{};
+    stack.ss_sp = g_alternate_stack;
+    stack.ss_size = sizeof(g_alternate_stack);
+    ::sigaltstack(&stack, nullptr);
+
+    struct sigaction action
+    {
+    };
+    action.sa_handler = onFatalSignal;
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    ::sigemptyset(&action.sa_mask);
+    for (std::size_t i{0}; i < NUM_OF_SIGNALS; ++i)
+    {
+        ::sigaction(FATAL_SIGNALS[i], &action, &g_previous[i]);
+    }
+    return true;
+#else
+    UNUSED_PARAMETER(settings);
+    LOG_WARNING("The fatal handler is not supported on this platform.")
+    return false;
+#endif
+}
+
+void FatalHandler::uninstall()
+{
+#ifdef __linux__
+    if (!g_installed.exchange(false))
+    {
+        return;
+    }
+    for (std::size_t i{0}; i < NUM_OF_SIGNALS; ++i)
+    {
+        ::sigaction(FATAL_SIGNALS[i], &g_previous[i], nullptr);
+    }
+#endif
+}
+
+void FatalHandler::report(const int fd, const int signal)
+{
+    const int64_t tid{ThreadRegistry::currentTid()};
+    const int64_t now{ThreadRegistry::now()};
+    const char* name{"unregistered"};
+    ThreadRegistry::forEach([tid, &name](const ThreadRegistry::Entry& entry)
+                            {
+                                if (entry.tid == tid)
+                                {
+                                    name = entry.name;
+                                } });
+
+    SignalWriter writer{fd};
+    writer << "*** Fatal signal " << static_cast<int64_t>(signal) << " (" << signalName(signal) << ") in thread "
+           << tid << " \"" << name << "\" ***\n";
+    writer << "Threads:\n";
+    ThreadRegistry::forEach([&writer, now](const ThreadRegistry::Entry& entry)
+                            {
+                                const int64_t age_ms{(now - entry.heartbeat_ns.load(std::memory_order_relaxed)) / 1000000};
+                                writer << "  " << entry.tid << " \"" << entry.name << "\" last heartbeat " << age_ms << " ms ago\n"; });
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,55 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <cstdint>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Handler for fatal signals that leaves a report behind before the process dies.
+ *
+ * On SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT the handler writes which signal hit which thread,
+ * every thread in the `ThreadRegistry` with the age of its last heartbeat, and a backtrace of the
+ * crashing thread. It then flushes the installed `Logger::Sink` and re-raises the signal with
+ * the default action, so core dumps and exit statuses stay the same. Everything done in the
+ * handler is async-signal-safe: fixed buffers, `write`, `clock_gettime` and `backtrace_symbols_fd`.
+ */
+class FatalHandler
+{
+public:
+    /**
+     * @brief Settings for the handler.
+     */
+    struct Settings
+    {
+        int fd{2};               ///< File descriptor the report is written to.
+        bool backtrace{true};    ///< Include a backtrace of the crashing thread.
+        uint32_t max_frames{64}; ///< Maximum frames in the backtrace.
+    };
+
+    /**
+     * @brief Install the handler for every fatal signal.
+     *
+     * Also gives the calling thread an alternate signal stack, so a stack overflow in that thread
+     * can still be reported.
+     *
+     * @param settings Settings for the handler.
+     * @return `true` if installed, `false` if already installed or unsupported on this platform.
+     */
+    static bool install(const Settings& settings);
+
+    /**
+     * @brief Restore the previous handlers.
+     */
+    static void uninstall();
+
+    /**
+     * @brief Write the report for a signal, as the handler does. Async-signal-safe.
+     * @param fd File descriptor to write to.
+     * @param signal The signal number to report.
+     */
+    static void report(const int fd, const int signal);
+};
+
+} // namespace ThreadSafe
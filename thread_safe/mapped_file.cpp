@@ -0,0 +1,184 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        LOG_ERROR("Failed to open file: " << path);
+        return false;
+    }
+    m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to open file: " << path);
+        return false;
+    }
+    struct stat info
+    {
+    };
+    if (::fstat(fd, &info) != 0)
+    {
+        LOG_ERROR("Failed to stat file: " << path);
+        ::close(fd);
+        return false;
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size > 0)
+    {
+#ifdef MAP_POPULATE
+        const int flags{MAP_PRIVATE | MAP_POPULATE};
+#else
+        const int flags{MAP_PRIVATE};
+#endif
+        void* addr{::mmap(nullptr, m_size, PROT_READ, flags, fd, 0)};
+        if (addr == MAP_FAILED)
+        {
+            LOG_ERROR("Failed to map file: " << path);
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        ::madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const uint8_t*>(addr);
+    }
+    ::close(fd);
+#endif
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_buffer.empty() && m_data != nullptr)
+    {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+#endif
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_open;
+}
+
+const uint8_t* MappedFile::data() const
+{
+    return m_data;
+}
+
+std::size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+bool replaceFile(const std::string& path, const std::vector<uint8_t>& contents)
+{
+    const std::string tmp_path{path + ".tmp"};
+#ifdef _WIN32
+    HANDLE file{::CreateFileA(tmp_path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Failed to create file: " << tmp_path);
+        return false;
+    }
+    DWORD written{0};
+    bool synced{contents.empty() || (::WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, nullptr) && written == contents.size())};
+    synced = synced && ::FlushFileBuffers(file);
+    ::CloseHandle(file);
+    if (!synced)
+    {
+        LOG_ERROR("Failed to write file: " << tmp_path);
+        ::DeleteFileA(tmp_path.c_str());
+        return false;
+    }
+    if (!::MoveFileExA(tmp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        LOG_ERROR("Failed to rename file: " << tmp_path);
+        ::DeleteFileA(tmp_path.c_str());
+        return false;
+    }
+    return true;
+#else
+    const int fd{::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to create file: " << tmp_path);
+        return false;
+    }
+    bool synced{true};
+    std::size_t offset{0};
+    while (synced && offset < contents.size())
+    {
+        const ssize_t written{::write(fd, contents.data() + offset, contents.size() - offset)};
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        synced = written > 0;
+        offset += synced ? static_cast<std::size_t>(written) : 0;
+    }
+    // Otherwise the rename may reach the disk before the data and leave an empty file after a crash.
+    synced = synced && ::fsync(fd) == 0;
+    synced = ::close(fd) == 0 && synced;
+    if (!synced)
+    {
+        LOG_ERROR("Failed to write file: " << tmp_path);
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        LOG_ERROR("Failed to rename file: " << tmp_path);
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    const std::size_t slash{path.find_last_of('/')};
+    const std::string directory{slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash))};
+    const int directory_fd{::open(directory.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (directory_fd < 0 || ::fsync(directory_fd) != 0)
+    {
+        // The new file is in place, only a crash could still bring the old one back.
+        LOG_WARNING("Failed to sync directory: " << directory);
+    }
+    if (directory_fd >= 0)
+    {
+        ::close(directory_fd);
+    }
+    return true;
+#endif
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,83 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Read-only view of a whole file, memory-mapped where the platform supports it.
+ *
+ * Mapping lets large files be parsed straight from the page cache without copying them into a
+ * user-space buffer first. POSIX platforms use `mmap`, Windows reads the file into memory instead.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Default constructor, creates a closed file.
+     */
+    MappedFile() = default;
+
+    /**
+     * @brief Destructor that unmaps the file.
+     */
+    ~MappedFile();
+
+    // Make this class uncopyable
+    UNCOPYABLE(MappedFile);
+
+    /**
+     * @brief Map a file for reading.
+     * @param path Path of the file.
+     * @return `true` if the file was mapped, `false` otherwise.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file. Pointers returned by `data` become invalid.
+     */
+    void close();
+
+    /**
+     * @brief Check whether a file is mapped.
+     * @return `true` if open, `false` otherwise.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Start of the mapped contents.
+     * @return Pointer to the first byte, `nullptr` if the file is closed or empty.
+     */
+    const uint8_t* data() const;
+
+    /**
+     * @brief Size of the mapped contents.
+     * @return The size in bytes.
+     */
+    std::size_t size() const;
+
+private:
+    const uint8_t* m_data{nullptr};
+    std::size_t m_size{0};
+    bool m_open{false};
+    std::vector<uint8_t> m_buffer{}; ///< Fallback storage where mmap is unavailable
+};
+
+/**
+ * @brief Replace a file with new contents, durably and without exposing a partial file.
+ *
+ * The contents are written to `path` with a `.tmp` suffix, flushed to the disk and renamed over
+ * `path`, then the directory is synced so the rename survives a crash as well. Readers see either
+ * the old or the new file, never an empty or truncated one.
+ *
+ * @param path Path of the file to replace.
+ * @param contents The new contents.
+ * @return `true` if the file was replaced, `false` otherwise.
+ */
+bool replaceFile(const std::string& path, const std::vector<uint8_t>& contents);
+
+} // namespace ThreadSafe
@@ -0,0 +1,209 @@
+#include "mapped_log_sink.hpp"
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+char levelLetter(const Logger::Level level)
+{
+    switch (level)
+    {
+    case Logger::Level::DEBUG:
+        return 'D';
+    case Logger::Level::INFO:
+        return 'I';
+    case Logger::Level::WARNING:
+        return 'W';
+    case Logger::Level::ERROR:
+        return 'E';
+    }
+    return '?';
+}
+
+} // namespace
+
+MappedLogSink::~MappedLogSink()
+{
+    close();
+}
+
+bool MappedLogSink::open(const std::string& path, const std::size_t capacity)
+{
+    close();
+    if (capacity == 0)
+    {
+        LOG_ERROR("Log file capacity must not be zero: " << path);
+        return false;
+    }
+#ifdef __linux__
+    const int fd{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)};
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to open log file: " << path);
+        return false;
+    }
+    const std::size_t map_size{HEADER_SIZE + capacity};
+    struct stat info
+    {
+    };
+    const bool reuse{::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) == map_size};
+    if (!reuse && ::ftruncate(fd, 0) != 0)
+    {
+        LOG_ERROR("Failed to truncate log file: " << path);
+        ::close(fd);
+        return false;
+    }
+    // Allocate the blocks up front, writing into a hole of a sparse file could fail with SIGBUS.
+    if (!reuse && ::posix_fallocate(fd, 0, static_cast<off_t>(map_size)) != 0)
+    {
+        LOG_ERROR("Failed to allocate log file: " << path);
+        ::close(fd);
+        return false;
+    }
+    void* addr{::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0)};
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        LOG_ERROR("Failed to map log file: " << path);
+        return false;
+    }
+    auto* header{static_cast<Header*>(addr)};
+    if (!reuse || header->magic != MAGIC || header->version != VERSION || header->capacity != capacity)
+    {
+        header = new (addr) Header{MAGIC, VERSION, capacity, {0}};
+    }
+    m_header = header;
+    m_data = static_cast<char*>(addr) + HEADER_SIZE;
+    m_capacity = capacity;
+    m_map_size = map_size;
+    return true;
+#else
+    LOG_ERROR("Memory-mapped log files are not supported on this platform: " << path);
+    return false;
+#endif
+}
+
+void MappedLogSink::close()
+{
+#ifdef __linux__
+    if (m_header != nullptr)
+    {
+        ::munmap(m_header, m_map_size);
+    }
+#endif
+    m_header = nullptr;
+    m_data = nullptr;
+    m_capacity = 0;
+    m_map_size = 0;
+}
+
+bool MappedLogSink::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+void MappedLogSink::write(const Logger::Level level, const char* text, const std::size_t length)
+{
+    if (m_header == nullptr)
+    {
+        return;
+    }
+    // "<level> <epoch ms> "
+    char prefix[32];
+    prefix[0] = levelLetter(level);
+    prefix[1] = ' ';
+    const auto now{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+    char* end{std::to_chars(prefix + 2, prefix + sizeof(prefix) - 1, now).ptr};
+    *end++ = ' ';
+    const std::size_t prefix_length{std::min(static_cast<std::size_t>(end - prefix), m_capacity)};
+    const std::size_t room{m_capacity - prefix_length};
+    const std::size_t newline{room > 0 ? 1u : 0u};
+    const std::size_t text_length{std::min(length, room - newline)};
+    const std::size_t record_length{prefix_length + text_length + newline};
+
+    const uint64_t position{m_header->position.fetch_add(record_length, std::memory_order_relaxed)};
+    copy(position, prefix, prefix_length);
+    copy(position + prefix_length, text, text_length);
+    if (newline > 0)
+    {
+        copy(position + prefix_length + text_length, "\n", 1);
+    }
+}
+
+void MappedLogSink::copy(uint64_t position, const char* bytes, std::size_t length)
+{
+    const std::size_t offset{static_cast<std::size_t>(position % m_capacity)};
+    const std::size_t first{std::min(length, m_capacity - offset)};
+    std::memcpy(m_data + offset, bytes, first);
+    std::memcpy(m_data, bytes + first, length - first);
+}
+
+void MappedLogSink::flush()
+{
+#ifdef __linux__
+    if (m_header != nullptr)
+    {
+        ::msync(m_header, m_map_size, MS_ASYNC);
+    }
+#endif
+}
+
+void MappedLogSink::flushFromSignal()
+{
+#ifdef __linux__
+    if (m_header != nullptr)
+    {
+        ::msync(m_header, m_map_size, MS_SYNC);
+    }
+#endif
+}
+
+std::string MappedLogSink::read(const std::string& path)
+{
+    MappedFile file{};
+    if (!file.open(path) || file.size() < HEADER_SIZE)
+    {
+        return std::string{};
+    }
+    const auto* header{reinterpret_cast<const Header*>(file.data())};
+    if (header->magic != MAGIC || header->version != VERSION || file.size() != HEADER_SIZE + header->capacity)
+    {
+        LOG_ERROR("Invalid log file: " << path);
+        return std::string{};
+    }
+    const auto* data{reinterpret_cast<const char*>(file.data()) + HEADER_SIZE};
+    const std::size_t capacity{static_cast<std::size_t>(header->capacity)};
+    const uint64_t position{header->position.load(std::memory_order_relaxed)};
+    if (position <= capacity)
+    {
+        return std::string(data, static_cast<std::size_t>(position));
+    }
+    // Wrapped: the oldest byte follows the newest one. The first line may be partly overwritten.
+    const std::size_t start{static_cast<std::size_t>(position % capacity)};
+    std::string log{};
+    log.reserve(capacity);
+    log.append(data + start, capacity - start);
+    log.append(data, start);
+    const std::size_t first_line_end{log.find('\n')};
+    log.erase(0, first_line_end == std::string::npos ? log.size() : first_line_end + 1);
+    return log;
+}
+
+} // namespace ThreadSafe
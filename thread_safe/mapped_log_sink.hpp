@@ -0,0 +1,110 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Log sink writing into a pre-sized, memory-mapped circular file.
+ *
+ * Every message is formatted in the calling thread's line buffer, then a writer reserves its
+ * bytes with one `fetch_add` on the write position in the file header and copies them into the
+ * shared mapping. No lock and no write syscall is involved, and the bytes are in the page cache as
+ * soon as they are copied, so they survive the process being killed or crashing. Once the file is
+ * full, the oldest messages are overwritten.
+ *
+ * Install it with `Logger::setSink`. `read` recovers the messages in order, also from the file of
+ * a process that died.
+ */
+class MappedLogSink : public Logger::Sink
+{
+public:
+    static constexpr uint32_t MAGIC = 0x4D4C4F47; ///< "MLOG"
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief Default constructor, creates a closed sink.
+     */
+    MappedLogSink() = default;
+
+    /**
+     * @brief Destructor that unmaps the file. Uninstall the sink first.
+     */
+    ~MappedLogSink() override;
+
+    // Make this class uncopyable
+    UNCOPYABLE(MappedLogSink);
+
+    /**
+     * @brief Create or reopen a log file and map it.
+     *
+     * An existing file with the same capacity is continued after its last message, anything else
+     * is replaced by an empty log.
+     *
+     * @param path Path of the file.
+     * @param capacity Size of the circular message area in bytes.
+     * @return `true` if the file was mapped, `false` otherwise.
+     */
+    bool open(const std::string& path, const std::size_t capacity);
+
+    /**
+     * @brief Unmap the file. The sink must not be installed any more.
+     */
+    void close();
+
+    /**
+     * @brief Check whether a file is mapped.
+     * @return `true` if open, `false` otherwise.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Write one message as a line prefixed with its level and the wall-clock time in ms.
+     *
+     * Messages longer than the capacity are truncated. Does nothing if the sink is closed.
+     */
+    void write(const Logger::Level level, const char* text, const std::size_t length) override;
+
+    /**
+     * @brief Ask the kernel to write the mapped pages back to disk.
+     *
+     * Not needed to survive a process crash, only to survive a machine crash.
+     */
+    void flush();
+
+    /**
+     * @brief Synchronous `flush`, only a syscall so it is async-signal-safe.
+     */
+    void flushFromSignal() override;
+
+    /**
+     * @brief Read the messages of a log file in the order they were written.
+     * @param path Path of the file.
+     * @return The messages separated by line breaks, empty if the file is missing or invalid.
+     */
+    static std::string read(const std::string& path);
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+        std::atomic<uint64_t> position; ///< Total bytes ever reserved.
+    };
+
+    static constexpr std::size_t HEADER_SIZE = 64; ///< Header padded to its own cache line.
+
+    Header* m_header{nullptr};
+    char* m_data{nullptr};
+    std::size_t m_capacity{0};
+    std::size_t m_map_size{0};
+
+    void copy(uint64_t position, const char* bytes, std::size_t length); ///< Copy with wrap-around.
+};
+
+} // namespace ThreadSafe
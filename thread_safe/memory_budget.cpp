@@ -0,0 +1,56 @@
+#include "memory_budget.hpp"
+
+namespace ThreadSafe
+{
+
+MemoryBudget::MemoryBudget(const std::size_t capacity)
+    : m_capacity{capacity}
+{
+}
+
+bool MemoryBudget::tryAcquire(const std::size_t bytes)
+{
+    std::size_t used{m_used.load(std::memory_order_relaxed)};
+    do
+    {
+        if (used + bytes > m_capacity && used != 0)
+        {
+            return false;
+        }
+    } while (!m_used.compare_exchange_weak(used, used + bytes, std::memory_order_seq_cst, std::memory_order_relaxed));
+    return true;
+}
+
+void MemoryBudget::release(const std::size_t bytes)
+{
+    m_used.fetch_sub(bytes, std::memory_order_seq_cst);
+    // Pairs with the increment in waitFor: either the waiter sees the released bytes in its
+    // predicate or this sees the waiter.
+    if (m_waiters.load(std::memory_order_seq_cst) > 0)
+    {
+        m_wait.notify();
+    }
+}
+
+bool MemoryBudget::available(const std::size_t bytes) const
+{
+    const std::size_t used{m_used.load(std::memory_order_seq_cst)};
+    return used + bytes <= m_capacity || used == 0;
+}
+
+void MemoryBudget::notify()
+{
+    m_wait.notify();
+}
+
+std::size_t MemoryBudget::used() const
+{
+    return m_used;
+}
+
+std::size_t MemoryBudget::capacity() const
+{
+    return m_capacity;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,99 @@
+#pragma once
+#include "common/common.hpp"
+
+#include "wait.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Number of bytes that several queues may hold together.
+ *
+ * Byte-bounded queues configured with the same budget acquire the bytes of an element when it is
+ * pushed and release them when it leaves the queue. When the budget is exhausted, each queue
+ * applies its own discard policy: discarding queues make room by dropping their own oldest
+ * elements or the new element, `NO_DISCARD` queues block until any of the queues releases bytes.
+ *
+ * An element larger than the whole budget is admitted while the budget is otherwise unused, so it
+ * cannot block forever.
+ */
+class MemoryBudget
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param capacity The number of bytes in the budget.
+     */
+    explicit MemoryBudget(const std::size_t capacity);
+
+    // Make this class uncopyable
+    UNCOPYABLE(MemoryBudget);
+
+    /**
+     * @brief Acquire bytes if they are available.
+     * @param bytes The number of bytes.
+     * @return `true` if acquired, `false` if the budget has not enough bytes left.
+     */
+    bool tryAcquire(const std::size_t bytes);
+
+    /**
+     * @brief Return bytes to the budget and wake threads waiting for them.
+     * @param bytes The number of bytes, acquired before.
+     */
+    void release(const std::size_t bytes);
+
+    /**
+     * @brief Check whether `tryAcquire` would currently succeed.
+     * @param bytes The number of bytes.
+     * @return `true` if available, `false` otherwise.
+     */
+    bool available(const std::size_t bytes) const;
+
+    /**
+     * @brief Block until the predicate is true, re-checking it whenever bytes are released.
+     * @tparam Pr The predicate type.
+     * @param timeout_ms The maximum time to wait in milliseconds.
+     * @param pred Predicate checked under the lock of the internal `Wait`, must not block.
+     * @return `true` if the predicate became true, `false` on timeout.
+     */
+    template<typename Pr>
+    bool waitFor(const uint32_t timeout_ms, Pr pred);
+
+    /**
+     * @brief Wake every waiter to re-check its predicate, e.g. after a queue closed.
+     */
+    void notify();
+
+    /**
+     * @brief Number of acquired bytes.
+     * @return The number of bytes.
+     */
+    std::size_t used() const;
+
+    /**
+     * @brief Number of bytes in the budget.
+     * @return The number of bytes.
+     */
+    std::size_t capacity() const;
+
+private:
+    const std::size_t m_capacity;
+    std::atomic<std::size_t> m_used{0};
+    std::atomic<uint32_t> m_waiters{0}; ///< Threads in `waitFor`, `release` only notifies if any.
+    Wait m_wait{};
+};
+
+template<typename Pr>
+bool MemoryBudget::waitFor(const uint32_t timeout_ms, Pr pred)
+{
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    const Wait::Status status{m_wait.waitFor(std::chrono::milliseconds(timeout_ms), pred)};
+    m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return status == Wait::Status::SUCCESS;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,126 @@
+#include "parking_lot.hpp"
+
+#include "cpu_topology.hpp"
+
+namespace ThreadSafe
+{
+
+ParkingLot::ParkingLot(const Policy policy)
+    : m_policy{policy}
+{
+}
+
+void ParkingLot::initSlot(Slot& slot) const
+{
+    if (m_policy == Policy::AFFINITY)
+    {
+        slot.cpu = currentCpu();
+        slot.domain = cacheDomainOf(slot.cpu);
+    }
+}
+
+void ParkingLot::link(Slot* slot)
+{
+    slot->prev = m_tail;
+    slot->next = nullptr;
+    if (m_tail != nullptr)
+    {
+        m_tail->next = slot;
+    }
+    else
+    {
+        m_head = slot;
+    }
+    m_tail = slot;
+}
+
+void ParkingLot::unlink(Slot* slot)
+{
+    if (slot->prev != nullptr)
+    {
+        slot->prev->next = slot->next;
+    }
+    else
+    {
+        m_head = slot->next;
+    }
+    if (slot->next != nullptr)
+    {
+        slot->next->prev = slot->prev;
+    }
+    else
+    {
+        m_tail = slot->prev;
+    }
+    slot->prev = nullptr;
+    slot->next = nullptr;
+}
+
+ParkingLot::Slot* ParkingLot::select() const
+{
+    if (m_policy == Policy::FIFO)
+    {
+        return m_head;
+    }
+    if (m_policy == Policy::LIFO)
+    {
+        return m_tail;
+    }
+    const int32_t cpu{currentCpu()};
+    const int32_t domain{cacheDomainOf(cpu)};
+    Slot* same_domain{nullptr};
+    for (Slot* slot{m_tail}; slot != nullptr; slot = slot->prev)
+    {
+        if (cpu >= 0 && slot->cpu == cpu)
+        {
+            return slot;
+        }
+        if (same_domain == nullptr && domain >= 0 && slot->domain == domain)
+        {
+            same_domain = slot;
+        }
+    }
+    return same_domain != nullptr ? same_domain : m_tail;
+}
+
+bool ParkingLot::unparkOne()
+{
+    if (m_parked == 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock{m_lock};
+    Slot* slot{select()};
+    if (slot == nullptr)
+    {
+        return false;
+    }
+    unlink(slot);
+    slot->signaled = true;
+    // Notify under the lock: the slot lives on the waiter's stack and vanishes once it returns.
+    slot->condition.notify_one();
+    return true;
+}
+
+void ParkingLot::unparkAll()
+{
+    if (m_parked == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{m_lock};
+    while (m_head != nullptr)
+    {
+        Slot* slot{m_head};
+        unlink(slot);
+        slot->signaled = true;
+        slot->condition.notify_one();
+    }
+}
+
+std::size_t ParkingLot::parked() const
+{
+    return m_parked;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,132 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Waiter list where every parked thread sleeps on its own slot.
+ *
+ * Unlike a shared condition variable, a notification wakes exactly one chosen waiter. The
+ * policy decides which one: the oldest, the most recent (warmest stack and caches), or the one
+ * whose last CPU shares a cache with the notifying thread, so the woken thread finds the data the
+ * notifier just wrote in its cache.
+ */
+class ParkingLot
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Which parked thread `unparkOne` wakes.
+     */
+    enum class Policy : uint32_t
+    {
+        FIFO = 0,    ///< The longest parked thread.
+        LIFO = 1,    ///< The most recently parked thread.
+        AFFINITY = 2 ///< A thread parked on the notifier's CPU, then one sharing its cache, then LIFO.
+    };
+
+    /**
+     * @brief Constructor.
+     * @param policy Selection policy for `unparkOne`.
+     */
+    explicit ParkingLot(const Policy policy = Policy::FIFO);
+
+    // Make this class uncopyable
+    UNCOPYABLE(ParkingLot);
+
+    /**
+     * @brief Park the calling thread until it is unparked, `ready` returns true, or the deadline passes.
+     *
+     * `ready` is evaluated under the lot's lock before parking. Notifiers must make the condition
+     * true before calling `unparkOne`/`unparkAll` so that the wake-up cannot be lost.
+     *
+     * @tparam Pr The predicate type.
+     * @param ready Predicate that returns true when there is no need to park.
+     * @param deadline Absolute time after which the thread gives up, `Clock::time_point::max()` for none.
+     * @return `true` if unparked or ready, `false` on timeout.
+     */
+    template<typename Pr>
+    bool park(Pr ready, const Clock::time_point deadline);
+
+    /**
+     * @brief Wake one parked thread chosen by the policy.
+     * @return `true` if a thread was woken, `false` if none was parked.
+     */
+    bool unparkOne();
+
+    /**
+     * @brief Wake every parked thread.
+     */
+    void unparkAll();
+
+    /**
+     * @brief Number of threads currently parked or about to park.
+     * @return The number of threads.
+     */
+    std::size_t parked() const;
+
+private:
+    struct Slot
+    {
+        std::condition_variable condition{};
+        bool signaled{false};
+        int32_t cpu{-1};
+        int32_t domain{-1};
+        Slot* prev{nullptr};
+        Slot* next{nullptr};
+    };
+
+    const Policy m_policy;
+    std::mutex m_lock{};
+    Slot* m_head{nullptr};                ///< Longest parked
+    Slot* m_tail{nullptr};                ///< Most recently parked
+    std::atomic<std::size_t> m_parked{0}; ///< Lets notifiers skip the lock when nobody is parked
+
+    void initSlot(Slot& slot) const;
+    void link(Slot* slot);
+    void unlink(Slot* slot);
+    Slot* select() const;
+};
+
+template<typename Pr>
+bool ParkingLot::park(Pr ready, const Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock{m_lock};
+    // Announce before checking, so a notifier either sees us or we see its condition.
+    ++m_parked;
+    if (ready())
+    {
+        --m_parked;
+        return true;
+    }
+    Slot slot{};
+    initSlot(slot);
+    link(&slot);
+    while (!slot.signaled)
+    {
+        if (deadline == Clock::time_point::max())
+        {
+            slot.condition.wait(lock);
+        }
+        else if (slot.condition.wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            break;
+        }
+    }
+    if (!slot.signaled)
+    {
+        unlink(&slot);
+    }
+    --m_parked;
+    return slot.signaled || ready();
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,132 @@
+#include "pi_mutex.hpp"
+
+#include <ctime>
+
+namespace ThreadSafe
+{
+
+PiMutex::PiMutex(const bool inherit)
+{
+#ifdef __linux__
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    if (inherit && pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT) == 0)
+    {
+        m_inherit = true;
+    }
+    pthread_mutex_init(&m_mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+#else
+    UNUSED_PARAMETER(inherit);
+#endif
+}
+
+PiMutex::~PiMutex()
+{
+#ifdef __linux__
+    pthread_mutex_destroy(&m_mutex);
+#endif
+}
+
+void PiMutex::lock()
+{
+#ifdef __linux__
+    // Only fails on misuse (deadlock detection is off), no logging on this path.
+    (void)pthread_mutex_lock(&m_mutex);
+#else
+    m_mutex.lock();
+#endif
+}
+
+bool PiMutex::try_lock()
+{
+#ifdef __linux__
+    return pthread_mutex_trylock(&m_mutex) == 0;
+#else
+    return m_mutex.try_lock();
+#endif
+}
+
+void PiMutex::unlock()
+{
+#ifdef __linux__
+    (void)pthread_mutex_unlock(&m_mutex);
+#else
+    m_mutex.unlock();
+#endif
+}
+
+bool PiMutex::inheritsPriority() const
+{
+    return m_inherit;
+}
+
+PiConditionVariable::PiConditionVariable()
+{
+#ifdef __linux__
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    // Match `steady_clock`, so changing the system time does not shift timeouts.
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_condition, &attributes);
+    pthread_condattr_destroy(&attributes);
+#endif
+}
+
+PiConditionVariable::~PiConditionVariable()
+{
+#ifdef __linux__
+    pthread_cond_destroy(&m_condition);
+#endif
+}
+
+void PiConditionVariable::notify_one()
+{
+#ifdef __linux__
+    pthread_cond_signal(&m_condition);
+#else
+    m_condition.notify_one();
+#endif
+}
+
+void PiConditionVariable::notify_all()
+{
+#ifdef __linux__
+    pthread_cond_broadcast(&m_condition);
+#else
+    m_condition.notify_all();
+#endif
+}
+
+void PiConditionVariable::wait(std::unique_lock<PiMutex>& lock)
+{
+#ifdef __linux__
+    pthread_cond_wait(&m_condition, &lock.mutex()->m_mutex);
+#else
+    m_condition.wait(lock);
+#endif
+}
+
+std::cv_status PiConditionVariable::wait_until(std::unique_lock<PiMutex>& lock, const Clock::time_point deadline)
+{
+    if (deadline == Clock::time_point::max())
+    {
+        wait(lock);
+        return std::cv_status::no_timeout;
+    }
+#ifdef __linux__
+    // `steady_clock` is `CLOCK_MONOTONIC` on Linux.
+    const auto since_epoch{deadline.time_since_epoch()};
+    const auto seconds{std::chrono::duration_cast<std::chrono::seconds>(since_epoch)};
+    timespec time{};
+    time.tv_sec = static_cast<time_t>(seconds.count());
+    time.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count());
+    const int result{pthread_cond_timedwait(&m_condition, &lock.mutex()->m_mutex, &time)};
+    // `EINVAL` for a deadline out of range counts as a timeout rather than a spurious wake-up.
+    return result != 0 ? std::cv_status::timeout : std::cv_status::no_timeout;
+#else
+    return m_condition.wait_until(lock, deadline);
+#endif
+}
+
+} // namespace ThreadSafe
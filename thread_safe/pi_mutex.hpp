@@ -0,0 +1,139 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Mutex that can lend the priority of a waiting thread to its owner.
+ *
+ * With priority inheritance, a low-priority thread holding the mutex runs at the priority of the
+ * highest-priority thread blocked on it until it unlocks. A medium-priority thread can then no
+ * longer keep the owner off the CPU while a `SCHED_FIFO` thread waits (priority inversion).
+ *
+ * Without priority inheritance it behaves like `std::mutex`. Meets the Lockable requirements, so it
+ * works with `std::lock_guard` and `std::unique_lock`. Priority inheritance is only available on
+ * Linux, elsewhere the flag is ignored.
+ */
+class PiMutex
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param inherit Use `PTHREAD_PRIO_INHERIT`.
+     */
+    explicit PiMutex(const bool inherit = true);
+
+    ~PiMutex();
+
+    // Make this class uncopyable
+    UNCOPYABLE(PiMutex);
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    /**
+     * @brief Check whether the owner inherits the priority of waiters.
+     * @return `true` if it does, `false` otherwise.
+     */
+    bool inheritsPriority() const;
+
+private:
+    friend class PiConditionVariable;
+
+#ifdef __linux__
+    pthread_mutex_t m_mutex;
+#else
+    std::mutex m_mutex{};
+#endif
+    bool m_inherit{false};
+};
+
+/**
+ * @brief Condition variable for `PiMutex`.
+ *
+ * Re-acquiring the mutex after a wake-up goes through the mutex itself, so it keeps priority
+ * inheritance, unlike `std::condition_variable_any`, which adds a plain internal mutex. Timeouts
+ * use the steady clock.
+ */
+class PiConditionVariable
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PiConditionVariable();
+
+    ~PiConditionVariable();
+
+    // Make this class uncopyable
+    UNCOPYABLE(PiConditionVariable);
+
+    void notify_one();
+    void notify_all();
+
+    void wait(std::unique_lock<PiMutex>& lock);
+
+    template<typename Pr>
+    void wait(std::unique_lock<PiMutex>& lock, Pr pred);
+
+    std::cv_status wait_until(std::unique_lock<PiMutex>& lock, const Clock::time_point deadline);
+
+    template<typename Pr>
+    bool wait_until(std::unique_lock<PiMutex>& lock, const Clock::time_point deadline, Pr pred);
+
+    template<class Repr, class Period, typename Pr>
+    bool wait_for(std::unique_lock<PiMutex>& lock, const std::chrono::duration<Repr, Period>& timeout, Pr pred);
+
+private:
+#ifdef __linux__
+    pthread_cond_t m_condition;
+#else
+    std::condition_variable_any m_condition{};
+#endif
+};
+
+template<typename Pr>
+void PiConditionVariable::wait(std::unique_lock<PiMutex>& lock, Pr pred)
+{
+    while (!pred())
+    {
+        wait(lock);
+    }
+}
+
+template<typename Pr>
+bool PiConditionVariable::wait_until(std::unique_lock<PiMutex>& lock, const Clock::time_point deadline, Pr pred)
+{
+    while (!pred())
+    {
+        if (wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            return pred();
+        }
+    }
+    return true;
+}
+
+template<class Repr, class Period, typename Pr>
+bool PiConditionVariable::wait_for(std::unique_lock<PiMutex>& lock, const std::chrono::duration<Repr, Period>& timeout, Pr pred)
+{
+    // Compare in the caller's unit, so that very long timeouts cannot overflow the deadline.
+    const auto now{Clock::now()};
+    const auto limit{std::chrono::duration_cast<std::chrono::duration<Repr, Period>>(Clock::time_point::max() - now)};
+    if (timeout >= limit)
+    {
+        return wait_until(lock, Clock::time_point::max(), pred);
+    }
+    return wait_until(lock, now + std::chrono::duration_cast<Clock::duration>(timeout), pred);
+}
+
+} // namespace ThreadSafe
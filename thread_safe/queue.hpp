@@ -2,15 +2,24 @@
 
 #include "common/common.hpp"
 
+#include "epoch.hpp"
+#include "memory_budget.hpp"
+#include "parking_lot.hpp"
+#include "pi_mutex.hpp"
+#include "queue_discard.hpp"
+#include "queue_storage.hpp"
 #include "wait.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <deque>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 namespace ThreadSafe
 {
@@ -27,6 +36,9 @@ class Queue
 {
 public:
     using DiscardedCallback = std::function<void(const T&)>;
+    using ReadyCallback = std::function<void()>;
+    using ArrivalCallback = std::function<void(const T&, const std::chrono::steady_clock::time_point, const bool)>;
+    using SizeOf = std::function<std::size_t(const T&)>;
     static constexpr uint32_t WAIT_FOREVER = std::numeric_limits<uint32_t>::max();
 
     /**
@@ -42,12 +54,7 @@ public:
     /**
      * @brief Discard policy for the queue.
      */
-    enum class Discard : uint32_t
-    {
-        DISCARD_OLDEST = 0, ///< Discard the oldest element when full.
-        DISCARD_NEWEST = 1, ///< Discard the newest element when full.
-        NO_DISCARD = 2      ///< Do not discard any elements.
-    };
+    using Discard = QueueDiscard;
 
     /**
      * @brief Control policy for the queue operations.
@@ -60,14 +67,62 @@ public:
         NO_CONTROL = 4    ///< No control for push and pop operations.
     };
 
+    /**
+     * @brief Wake policy for consumers blocked in `pop`.
+     */
+    enum class Wake : uint32_t
+    {
+        BROADCAST = 0, ///< Every state change wakes all blocked threads through one condition variable.
+        AFFINITY = 1   ///< Each push wakes one consumer, preferring one whose last CPU shares a cache with the producer.
+    };
+
+    /**
+     * @brief Settings for the `CODEL` discard policy.
+     *
+     * Every element is timestamped on push. Consumers track the shortest time an element spent in
+     * the queue during each interval. If even the shortest one exceeded `target_ms`, the queue has a
+     * standing backlog rather than a burst, and until an interval passes where it does not, every
+     * element older than twice the target is discarded when a consumer reaches it. With
+     * `adaptive_lifo`, consumers also take the newest element first during such an overload, so
+     * fresh requests are served quickly while the stale ones age out. A full queue discards its
+     * oldest element.
+     */
+    struct Codel
+    {
+        uint32_t target_ms{5};     ///< Acceptable time in the queue.
+        uint32_t interval_ms{100}; ///< Time the target must be exceeded continuously.
+        bool adaptive_lifo{false}; ///< Serve the newest element first while overloaded.
+    };
+
     /**
      * @brief Settings for the queue, such as discard policy, control, and size.
+     *
+     * With `size_of` set, the queue also counts the bytes of its elements. It is full when either
+     * `size` elements or `max_bytes` bytes are queued, or when `budget` has not enough bytes left
+     * for the next element, and applies the discard policy in each case. An evicting policy only
+     * evicts for the budget if the bytes of this queue can cover the shortfall; when the other
+     * queues hold too much, just the new element is discarded. `size_of` must return the same
+     * value for an element as long as it is queued.
+     *
+     * With `real_time`, the queue lock and its `Wait` inherit the priority of blocked threads, so
+     * a `ThreadPriority::TIME_CRITICAL` thread sharing the queue with low-priority threads is not
+     * held up by medium-priority threads while a low-priority thread holds the lock. A finite
+     * `size` is then allocated up front in a `RingBuffer`, so push and pop do not allocate while the
+     * queue stays within it. Other queues keep a `std::deque`, which frees memory again after a
+     * spike. Push and pop never log, in either mode. `Wake::AFFINITY` parks consumers outside
+     * the queue lock and is not covered by the priority inheritance.
      */
     struct Settings
     {
-        Discard discard{Discard::NO_DISCARD};                 ///< Discard policy.
-        Control control{Control::NO_CONTROL};                 ///< Control policy.
-        std::size_t size{std::numeric_limits<size_t>::max()}; ///< Maximum size of the queue.
+        Discard discard{Discard::NO_DISCARD};                      ///< Discard policy.
+        Control control{Control::NO_CONTROL};                      ///< Control policy.
+        std::size_t size{std::numeric_limits<size_t>::max()};      ///< Maximum size of the queue.
+        Wake wake{Wake::BROADCAST};                                ///< Wake policy for blocked consumers.
+        Codel codel{};                                             ///< Settings for `Discard::CODEL`.
+        SizeOf size_of{};                                          ///< Bytes of an element, enables the byte bounds.
+        std::size_t max_bytes{std::numeric_limits<size_t>::max()}; ///< Maximum bytes of the queued elements.
+        std::shared_ptr<MemoryBudget> budget{};                    ///< Budget shared with other queues, optional.
+        bool real_time{false};                                     ///< Priority-inheritance locking and preallocated storage.
     };
 
     /**
@@ -76,6 +131,11 @@ public:
      */
     explicit Queue(const Settings& settings);
 
+    /**
+     * @brief Destructor that returns the bytes of the remaining elements to the shared budget.
+     */
+    ~Queue();
+
     // Make this class uncopyable
     UNCOPYABLE(Queue);
 
@@ -85,6 +145,32 @@ public:
      */
     void setDiscardedCallback(DiscardedCallback discarded_callback);
 
+    /**
+     * @brief Set the callback for the queue becoming non-empty.
+     *
+     * Called by the pushing thread, outside the queue lock, whenever an element is added to an
+     * empty queue. Lets an event loop wait for the queue together with other event sources instead
+     * of blocking in `pop`. Set it while no thread is pushing.
+     *
+     * @param ready_callback Function to be called when the queue becomes non-empty.
+     */
+    void setReadyCallback(ReadyCallback ready_callback);
+
+    /**
+     * @brief Set the callback for every call to `push`, whether the element was admitted or not.
+     *
+     * Called by the pushing thread once `push` is decided, outside the queue lock, with the element,
+     * the time `push` was entered and whether the element was added. A push that blocked on a full
+     * queue thus still reports when it arrived, and pushes rejected by the discard policy, a
+     * timeout, the byte bounds or a closed queue are reported too. Elements added by `bulkLoad` are
+     * not reported. Used by `QueueCapture` to record the arrival process. May be replaced, or
+     * removed with an empty function, while threads are pushing. A replaced callback is destroyed
+     * through `Epoch` once no push can still be calling it.
+     *
+     * @param arrival_callback Function to be called for each push, empty to remove it.
+     */
+    void setArrivalCallback(ArrivalCallback arrival_callback);
+
     /**
      * @brief Open the queue for push operations.
      */
@@ -138,6 +224,23 @@ public:
      */
     bool pop(T& elem, const uint32_t timeout_ms = WAIT_FOREVER);
 
+    /**
+     * @brief Pops up to `max_elems` elements with a single wait.
+     *
+     * Blocks like `pop` until at least one element is available, then moves every further element
+     * that is already queued, up to `max_elems` in total, under one lock acquisition. With a
+     * `linger_us`, a batch that is not full yet waits up to that long after the first element for
+     * the rest to arrive, trading latency for larger batches, see `BatchController`.
+     *
+     * @param elems Vector the popped elements are appended to, from oldest to newest.
+     * @param max_elems The maximum number of elements to pop.
+     * @param timeout_ms The maximum time to wait for the first element in milliseconds.
+     * @param linger_us The maximum time to wait for a full batch in microseconds.
+     * @return The number of elements popped, 0 on timeout or if the queue is closed for pop operations.
+     */
+    std::size_t popBatch(std::vector<T>& elems, const std::size_t max_elems, const uint32_t timeout_ms = WAIT_FOREVER,
+                         const uint32_t linger_us = 0);
+
     /**
      * @brief Waits until the queue is open for pushing or until the specified timeout expires.
      *
@@ -166,31 +269,109 @@ public:
      */
     bool waitPopOpen(const uint32_t timeout_ms = WAIT_FOREVER);
 
+    /**
+     * @brief Current number of elements in the queue.
+     * @return The number of elements.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Current bytes of the queued elements, as counted by `Settings::size_of`.
+     * @return The number of bytes, 0 without `size_of`.
+     */
+    std::size_t bytes() const;
+
+    /**
+     * @brief Take a consistent copy of the queue contents without removing them.
+     *
+     * The copy is made under the queue lock, so it reflects the queue at a single point in time.
+     *
+     * @return The elements from oldest to newest.
+     */
+    std::vector<T> snapshot() const;
+
+    /**
+     * @brief Remove and return every element currently in the queue.
+     *
+     * Combined with `closePush` this hands over the complete queue contents, e.g. before a restart.
+     *
+     * @return The elements from oldest to newest.
+     */
+    std::vector<T> drain();
+
+    /**
+     * @brief Append many elements at once, e.g. when restoring a snapshot on startup.
+     *
+     * The elements are appended under a single lock acquisition and bypass the push control,
+     * so a queue can be filled before it is opened. Elements beyond `Settings::size` are handled
+     * by the discard policy: `DISCARD_OLDEST` and `CODEL` drop the oldest elements, otherwise the
+     * excess elements are discarded. The byte bounds apply the same way.
+     *
+     * @param elems The elements to append, from oldest to newest.
+     * @return The number of these elements still queued, so elements evicted again by a later one
+     *         of the same call are not counted.
+     */
+    std::size_t bulkLoad(std::vector<T>&& elems);
+
 private:
-    const Settings m_settings;                   ///< Queue settings.
-    std::deque<T> m_queue{};                     ///< Underlying queue storage.
-    std::atomic<std::size_t> m_size{0};          ///< Current size of the queue.
-    std::atomic<Status> m_status{Status::EMPTY}; ///< Status of the queue.
-    std::mutex m_lock{};                         ///< Mutex to protect the queue operations.
-    std::atomic<bool> m_open_push{false};        ///< Flag indicating whether push is open.
-    std::atomic<bool> m_open_pop{false};         ///< Flag indicating whether pop is open.
-    Wait m_wait{};                               ///< Wait mechanism for blocking operations.
-    DiscardedCallback m_discarded_callback{};    ///< Callback for discarded elements.
-
-    void onDiscarded(const T& elem);            ///< Handle discarded elements.
-    bool pushControllable() const;              ///< Check if push is controllable.
-    bool popControllable() const;               ///< Check if pop is controllable.
-    bool waitToPush(const uint32_t timeout_ms); ///< Wait for push availability.
-    bool waitToPop(const uint32_t timeout_ms);  ///< Wait for pop availability.
-    void pushWithLock(const T& elem);           ///< Internal push method.
-    const T& popWithLock();                     ///< Internal pop method.
-    void updateStatus();                        ///< Update the status of the queue.
+    using Clock = std::chrono::steady_clock;
+
+    const Settings m_settings;                          ///< Queue settings.
+    QueueStorage<T> m_queue;                            ///< Underlying queue storage.
+    QueueStorage<Clock::time_point> m_enqueued;         ///< Push time per element, `CODEL` only.
+    Clock::duration m_codel_min_delay;                  ///< Shortest wait in the current interval.
+    Clock::time_point m_codel_interval_end{};           ///< End of the current interval.
+    bool m_codel_overloaded{false};                     ///< The last interval never met the target.
+    std::atomic<std::size_t> m_size{0};                 ///< Current size of the queue.
+    std::atomic<std::size_t> m_bytes{0};                ///< Current bytes of the queue, with `size_of`.
+    std::atomic<Status> m_status{Status::EMPTY};        ///< Status of the queue.
+    mutable PiMutex m_lock;                             ///< Mutex to protect the queue operations.
+    std::atomic<bool> m_open_push{false};               ///< Flag indicating whether push is open.
+    std::atomic<bool> m_open_pop{false};                ///< Flag indicating whether pop is open.
+    Wait m_wait;                                        ///< Wait mechanism for blocking operations.
+    ParkingLot m_parking{ParkingLot::Policy::AFFINITY}; ///< Per-consumer parking slots for `Wake::AFFINITY`.
+    DiscardedCallback m_discarded_callback{};           ///< Callback for discarded elements.
+    ReadyCallback m_ready_callback{};                   ///< Callback for the queue becoming non-empty.
+    std::atomic<ArrivalCallback*> m_arrival_callback{}; ///< Callback for every push, optional.
+
+    void onDiscarded(const T& elem);                                      ///< Handle discarded elements.
+    bool pushControllable() const;                                        ///< Check if push is controllable.
+    bool popControllable() const;                                         ///< Check if pop is controllable.
+    bool waitToPush(const uint32_t timeout_ms);                           ///< Wait for push availability.
+    bool waitToPop(const uint32_t timeout_ms);                            ///< Wait for pop availability.
+    bool pushElement(const T& elem, const uint32_t timeout_ms);           ///< `push` without reporting the arrival.
+    void pushWithLock(const T& elem);                                     ///< Internal push method.
+    bool popWithLock(T& elem);                                            ///< Internal pop method, false if the queue is empty.
+    bool popOldestWithLock(T& elem);                                      ///< Pop the oldest element regardless of the policy.
+    bool takeLocked(T& elem, std::vector<T>& dropped);                    ///< Take the next element, with the lock held.
+    bool takeCodel(T& elem, std::vector<T>& dropped);                     ///< `takeLocked` for `CODEL`.
+    bool pushBytes(const T& elem, const uint32_t timeout_ms);             ///< `push` for byte-bounded queues.
+    bool admitLocked(const std::size_t bytes, std::vector<T>& discarded); ///< Make room for an element, evicting if allowed.
+    bool hasRoom(const std::size_t bytes) const;                          ///< Lock-free estimate for waiting pushers.
+    void releaseLocked(const T& elem);                                    ///< Return the bytes of a removed element.
+    bool evicts() const;                                                  ///< Full queues make room by dropping the oldest.
+    void notifyPushed(const bool was_empty);                              ///< Wake a consumer of the pushed element.
+    void notifyArrival(const T& elem, const Clock::time_point arrived, const bool admitted); ///< Report a push to the arrival callback.
+    void updateStatus();                                                  ///< Update the status of the queue.
 };
 
 template<typename T>
 Queue<T>::Queue(const Settings& settings)
     : m_settings{settings}
+    , m_queue{settings.real_time}
+    , m_enqueued{settings.real_time}
+    , m_codel_min_delay{Clock::duration::max()}
+    , m_lock{settings.real_time}
+    , m_wait{settings.real_time}
 {
+    if (m_settings.real_time && m_settings.size != std::numeric_limits<size_t>::max())
+    {
+        m_queue.reserve(m_settings.size);
+        if (m_settings.discard == Discard::CODEL)
+        {
+            m_enqueued.reserve(m_settings.size);
+        }
+    }
     if (!pushControllable())
     {
         m_open_push = true;
@@ -201,12 +382,41 @@ Queue<T>::Queue(const Settings& settings)
     }
 }
 
+template<typename T>
+Queue<T>::~Queue()
+{
+    // Otherwise the budget keeps them acquired for good and starves the other queues sharing it.
+    if (m_settings.size_of && m_settings.budget && m_bytes > 0)
+    {
+        m_settings.budget->release(m_bytes);
+    }
+    delete m_arrival_callback.load();
+}
+
 template<typename T>
 void Queue<T>::setDiscardedCallback(DiscardedCallback discarded_callback)
 {
     m_discarded_callback = discarded_callback;
 }
 
+template<typename T>
+void Queue<T>::setReadyCallback(ReadyCallback ready_callback)
+{
+    m_ready_callback = ready_callback;
+}
+
+template<typename T>
+void Queue<T>::setArrivalCallback(ArrivalCallback arrival_callback)
+{
+    ArrivalCallback* installed{arrival_callback ? new ArrivalCallback(std::move(arrival_callback)) : nullptr};
+    ArrivalCallback* replaced{m_arrival_callback.exchange(installed)};
+    if (replaced != nullptr)
+    {
+        // A pusher may still be calling it.
+        Epoch::retire(replaced);
+    }
+}
+
 template<typename T>
 void Queue<T>::onDiscarded(const T& elem)
 {
@@ -219,6 +429,24 @@ void Queue<T>::onDiscarded(const T& elem)
 template<typename T>
 bool Queue<T>::push(const T& elem, const uint32_t timeout_ms)
 {
+    if (m_arrival_callback.load(std::memory_order_relaxed) == nullptr)
+    {
+        return pushElement(elem, timeout_ms);
+    }
+    const auto arrived{Clock::now()};
+    const bool admitted{pushElement(elem, timeout_ms)};
+    notifyArrival(elem, arrived, admitted);
+    return admitted;
+}
+
+template<typename T>
+bool Queue<T>::pushElement(const T& elem, const uint32_t timeout_ms)
+{
+    if (m_settings.size_of)
+    {
+        return pushBytes(elem, timeout_ms);
+    }
+
     if (!waitToPush(timeout_ms))
     {
         return false;
@@ -236,10 +464,14 @@ bool Queue<T>::push(const T& elem, const uint32_t timeout_ms)
         return false;
     }
 
-    if (m_settings.discard == Discard::DISCARD_OLDEST)
+    if (m_settings.discard == Discard::DISCARD_OLDEST || m_settings.discard == Discard::CODEL)
     {
-        auto discarded_elem = std::move(popWithLock());
-        onDiscarded(discarded_elem);
+        T discarded_elem{};
+        if (popOldestWithLock(discarded_elem))
+        {
+            onDiscarded(discarded_elem);
+        }
+        pushWithLock(elem);
         return true;
     }
     return false;
@@ -248,12 +480,67 @@ bool Queue<T>::push(const T& elem, const uint32_t timeout_ms)
 template<typename T>
 bool Queue<T>::pop(T& elem, const uint32_t timeout_ms)
 {
-    if (!waitToPop(timeout_ms))
+    const auto deadline{std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms)};
+    uint32_t remaining_ms{timeout_ms};
+    while (waitToPop(remaining_ms))
     {
-        return false;
+        if (popWithLock(elem))
+        {
+            return true;
+        }
+        // Another consumer took the element, or push is closed and the queue is drained.
+        if (!m_open_push)
+        {
+            return false;
+        }
+        if (timeout_ms != WAIT_FOREVER)
+        {
+            const auto now{std::chrono::steady_clock::now()};
+            if (now >= deadline)
+            {
+                return false;
+            }
+            remaining_ms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        }
     }
-    elem = popWithLock();
-    return true;
+    return false;
+}
+
+template<typename T>
+std::size_t Queue<T>::popBatch(std::vector<T>& elems, const std::size_t max_elems, const uint32_t timeout_ms, const uint32_t linger_us)
+{
+    T elem{};
+    if (max_elems == 0 || !pop(elem, timeout_ms))
+    {
+        return 0;
+    }
+    elems.push_back(std::move(elem));
+    std::size_t count{1};
+    if (linger_us > 0 && max_elems > 1)
+    {
+        // Every push notifies `m_wait` through `updateStatus`, whatever the wake policy.
+        const std::size_t missing{max_elems - 1};
+        m_wait.waitFor(std::chrono::microseconds(linger_us), [this, missing]() -> bool
+                       { return !m_open_push || !m_open_pop || m_size >= missing; });
+    }
+    std::vector<T> dropped{};
+    {
+        std::lock_guard<PiMutex> lock{m_lock};
+        while (count < max_elems && takeLocked(elem, dropped))
+        {
+            elems.push_back(std::move(elem));
+            ++count;
+        }
+        if (count > 1 || !dropped.empty())
+        {
+            updateStatus();
+        }
+    }
+    for (const auto& discarded : dropped)
+    {
+        onDiscarded(discarded);
+    }
+    return count;
 }
 
 template<typename T>
@@ -285,6 +572,7 @@ void Queue<T>::openPush()
     }
     m_open_push = true;
     m_wait.notify();
+    m_parking.unparkAll();
 }
 
 template<typename T>
@@ -296,6 +584,11 @@ void Queue<T>::closePush()
     }
     m_open_push = false;
     m_wait.notify();
+    m_parking.unparkAll();
+    if (m_settings.budget)
+    {
+        m_settings.budget->notify();
+    }
 }
 
 template<typename T>
@@ -307,6 +600,7 @@ void Queue<T>::openPop()
     }
     m_open_pop = true;
     m_wait.notify();
+    m_parking.unparkAll();
 }
 
 template<typename T>
@@ -318,6 +612,7 @@ void Queue<T>::closePop()
     }
     m_open_pop = false;
     m_wait.notify();
+    m_parking.unparkAll();
 }
 
 template<typename T>
@@ -328,7 +623,7 @@ bool Queue<T>::waitToPush(const uint32_t timeout_ms)
         return false;
     }
 
-    static auto closed_or_not_full_pred = [this]() -> bool
+    auto closed_or_not_full_pred = [this]() -> bool
     {
         if (!m_open_push || m_status != Status::FULL)
         {
@@ -355,7 +650,7 @@ bool Queue<T>::waitToPop(const uint32_t timeout_ms)
         return false;
     }
 
-    static auto closed_or_not_empty_pred = [this]() -> bool
+    auto closed_or_not_empty_pred = [this]() -> bool
     {
         if (!m_open_push || m_status != Status::EMPTY)
         {
@@ -364,6 +659,20 @@ bool Queue<T>::waitToPop(const uint32_t timeout_ms)
         return false;
     };
 
+    if (m_status == Status::EMPTY && m_settings.wake == Wake::AFFINITY)
+    {
+        auto ready_pred = [this, &closed_or_not_empty_pred]() -> bool
+        {
+            return !m_open_pop || closed_or_not_empty_pred();
+        };
+        auto deadline{ParkingLot::Clock::time_point::max()};
+        if (timeout_ms != WAIT_FOREVER)
+        {
+            deadline = ParkingLot::Clock::now() + std::chrono::milliseconds(timeout_ms);
+        }
+        return m_parking.park(ready_pred, deadline) && m_open_pop;
+    }
+
     if (m_status == Status::EMPTY)
     {
         Wait::Status result{m_wait.waitFor(std::chrono::milliseconds(timeout_ms), closed_or_not_empty_pred)};
@@ -378,19 +687,269 @@ bool Queue<T>::waitToPop(const uint32_t timeout_ms)
 template<typename T>
 void Queue<T>::pushWithLock(const T& elem)
 {
-    std::lock_guard<std::mutex> lock{m_lock};
-    m_queue.push_back(elem);
-    updateStatus();
+    bool was_empty{false};
+    {
+        std::lock_guard<PiMutex> lock{m_lock};
+        was_empty = m_queue.empty();
+        m_queue.push_back(elem);
+        if (m_settings.discard == Discard::CODEL)
+        {
+            m_enqueued.push_back(Clock::now());
+        }
+        updateStatus();
+    }
+    notifyPushed(was_empty);
+}
+
+template<typename T>
+void Queue<T>::notifyPushed(const bool was_empty)
+{
+    if (m_settings.wake == Wake::AFFINITY)
+    {
+        m_parking.unparkOne();
+    }
+    if (was_empty && m_ready_callback)
+    {
+        m_ready_callback();
+    }
+}
+
+template<typename T>
+void Queue<T>::notifyArrival(const T& elem, const Clock::time_point arrived, const bool admitted)
+{
+    Epoch::Guard guard{};
+    const ArrivalCallback* arrival_callback{m_arrival_callback.load()};
+    if (arrival_callback != nullptr)
+    {
+        (*arrival_callback)(elem, arrived, admitted);
+    }
+}
+
+template<typename T>
+bool Queue<T>::pushBytes(const T& elem, const uint32_t timeout_ms)
+{
+    const std::size_t bytes{m_settings.size_of(elem)};
+    const auto deadline{Clock::now() + std::chrono::milliseconds(timeout_ms)};
+    while (m_open_push)
+    {
+        std::vector<T> discarded{};
+        bool admitted{false};
+        bool was_empty{false};
+        {
+            std::lock_guard<PiMutex> lock{m_lock};
+            admitted = admitLocked(bytes, discarded);
+            if (admitted)
+            {
+                was_empty = m_queue.empty();
+                m_queue.push_back(elem);
+                m_bytes += bytes;
+                if (m_settings.discard == Discard::CODEL)
+                {
+                    m_enqueued.push_back(Clock::now());
+                }
+            }
+            if (admitted || !discarded.empty())
+            {
+                updateStatus();
+            }
+        }
+        for (const auto& discarded_elem : discarded)
+        {
+            onDiscarded(discarded_elem);
+        }
+        if (admitted)
+        {
+            notifyPushed(was_empty);
+            return true;
+        }
+        if (m_settings.discard != Discard::NO_DISCARD)
+        {
+            onDiscarded(elem);
+            return false;
+        }
+
+        uint32_t remaining_ms{timeout_ms};
+        if (timeout_ms != WAIT_FOREVER)
+        {
+            const auto now{Clock::now()};
+            remaining_ms = now >= deadline ? 0 : static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        }
+        auto closed_or_room_pred = [this, bytes]() -> bool
+        {
+            return !m_open_push || hasRoom(bytes);
+        };
+        // Bytes released by any queue of the budget wake the budget's waiters, our own pops included.
+        const bool ready{m_settings.budget ? m_settings.budget->waitFor(remaining_ms, closed_or_room_pred)
+                                           : m_wait.waitFor(std::chrono::milliseconds(remaining_ms), closed_or_room_pred) == Wait::Status::SUCCESS};
+        if (!ready)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+bool Queue<T>::admitLocked(const std::size_t bytes, std::vector<T>& discarded)
+{
+    MemoryBudget* budget{m_settings.size_of ? m_settings.budget.get() : nullptr};
+    while (true)
+    {
+        // An element larger than `max_bytes` still fits into an empty queue, it never would otherwise.
+        const bool fits{m_queue.size() < m_settings.size && (m_queue.empty() || m_bytes + bytes <= m_settings.max_bytes)};
+        if (fits && (budget == nullptr || budget->tryAcquire(bytes)))
+        {
+            return true;
+        }
+        if (!evicts() || m_queue.empty())
+        {
+            return false;
+        }
+        // Bytes held by the other queues of the budget cannot be freed here, so evicting all of
+        // ours would still not make room for the element.
+        if (budget != nullptr && budget->used() - m_bytes + bytes > budget->capacity())
+        {
+            return false;
+        }
+        discarded.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+        if (!m_enqueued.empty())
+        {
+            m_enqueued.pop_front();
+        }
+        releaseLocked(discarded.back());
+    }
 }
 
 template<typename T>
-const T& Queue<T>::popWithLock()
+bool Queue<T>::hasRoom(const std::size_t bytes) const
 {
-    std::lock_guard<std::mutex> lock{m_lock};
-    const T& elem{m_queue.front()};
+    const std::size_t size{m_size};
+    if (size >= m_settings.size || (size > 0 && m_bytes + bytes > m_settings.max_bytes))
+    {
+        return false;
+    }
+    return !m_settings.budget || m_settings.budget->available(bytes);
+}
+
+template<typename T>
+void Queue<T>::releaseLocked(const T& elem)
+{
+    if (!m_settings.size_of)
+    {
+        return;
+    }
+    const std::size_t bytes{m_settings.size_of(elem)};
+    m_bytes -= bytes;
+    if (m_settings.budget)
+    {
+        m_settings.budget->release(bytes);
+    }
+}
+
+template<typename T>
+bool Queue<T>::evicts() const
+{
+    return m_settings.discard == Discard::DISCARD_OLDEST || m_settings.discard == Discard::CODEL;
+}
+
+template<typename T>
+bool Queue<T>::popWithLock(T& elem)
+{
+    std::vector<T> dropped{};
+    bool popped{false};
+    {
+        std::lock_guard<PiMutex> lock{m_lock};
+        popped = takeLocked(elem, dropped);
+        if (popped || !dropped.empty())
+        {
+            updateStatus();
+        }
+    }
+    for (const auto& discarded : dropped)
+    {
+        onDiscarded(discarded);
+    }
+    return popped;
+}
+
+template<typename T>
+bool Queue<T>::popOldestWithLock(T& elem)
+{
+    std::lock_guard<PiMutex> lock{m_lock};
+    if (m_queue.empty())
+    {
+        return false;
+    }
+    releaseLocked(m_queue.front());
+    elem = std::move(m_queue.front());
     m_queue.pop_front();
+    if (!m_enqueued.empty())
+    {
+        m_enqueued.pop_front();
+    }
     updateStatus();
-    return std::move(elem);
+    return true;
+}
+
+template<typename T>
+bool Queue<T>::takeLocked(T& elem, std::vector<T>& dropped)
+{
+    if (m_settings.discard == Discard::CODEL)
+    {
+        return takeCodel(elem, dropped);
+    }
+    if (m_queue.empty())
+    {
+        return false;
+    }
+    releaseLocked(m_queue.front());
+    elem = std::move(m_queue.front());
+    m_queue.pop_front();
+    return true;
+}
+
+template<typename T>
+bool Queue<T>::takeCodel(T& elem, std::vector<T>& dropped)
+{
+    const auto now{Clock::now()};
+    const auto target{std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(m_settings.codel.target_ms))};
+    if (now >= m_codel_interval_end)
+    {
+        // An interval without any pop says nothing about the backlog.
+        m_codel_overloaded = m_codel_min_delay != Clock::duration::max() && m_codel_min_delay > target;
+        m_codel_min_delay = Clock::duration::max();
+        m_codel_interval_end = now + std::chrono::milliseconds(m_settings.codel.interval_ms);
+    }
+    if (m_codel_overloaded)
+    {
+        while (!m_queue.empty() && now - m_enqueued.front() > 2 * target)
+        {
+            dropped.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+            m_enqueued.pop_front();
+            releaseLocked(dropped.back());
+        }
+    }
+    if (m_queue.empty())
+    {
+        return false;
+    }
+    // The wait of the head measures the standing backlog, also while serving the newest in LIFO mode.
+    m_codel_min_delay = std::min(m_codel_min_delay, now - m_enqueued.front());
+    if (m_codel_overloaded && m_settings.codel.adaptive_lifo)
+    {
+        releaseLocked(m_queue.back());
+        elem = std::move(m_queue.back());
+        m_queue.pop_back();
+        m_enqueued.pop_back();
+        return true;
+    }
+    releaseLocked(m_queue.front());
+    elem = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_enqueued.pop_front();
+    return true;
 }
 
 template<typename T>
@@ -402,7 +961,7 @@ void Queue<T>::updateStatus()
     {
         m_status = Status::EMPTY;
     }
-    else if (m_size >= m_settings.size)
+    else if (m_size >= m_settings.size || (m_settings.size_of && m_bytes >= m_settings.max_bytes))
     {
         m_status = Status::FULL;
     }
@@ -439,4 +998,85 @@ bool Queue<T>::waitPopOpen(const uint32_t timeout_ms)
     return true;
 }
 
+template<typename T>
+std::size_t Queue<T>::size() const
+{
+    return m_size;
+}
+
+template<typename T>
+std::size_t Queue<T>::bytes() const
+{
+    return m_bytes;
+}
+
+template<typename T>
+std::vector<T> Queue<T>::snapshot() const
+{
+    std::vector<T> elems{};
+    std::lock_guard<PiMutex> lock{m_lock};
+    elems.reserve(m_queue.size());
+    m_queue.forEach([&elems](const T& elem)
+                    { elems.push_back(elem); });
+    return elems;
+}
+
+template<typename T>
+std::vector<T> Queue<T>::drain()
+{
+    std::vector<T> elems{};
+    std::lock_guard<PiMutex> lock{m_lock};
+    elems.reserve(m_queue.size());
+    m_queue.forEach([this, &elems](T& elem)
+                    {
+                        releaseLocked(elem);
+                        elems.push_back(std::move(elem)); });
+    m_queue.clear();
+    m_enqueued.clear();
+    updateStatus();
+    return elems;
+}
+
+template<typename T>
+std::size_t Queue<T>::bulkLoad(std::vector<T>&& elems)
+{
+    std::vector<T> discarded{};
+    std::size_t loaded{0};
+    bool was_empty{false};
+    {
+        std::lock_guard<PiMutex> lock{m_lock};
+        was_empty = m_queue.empty();
+        for (auto& elem : elems)
+        {
+            const std::size_t bytes{m_settings.size_of ? m_settings.size_of(elem) : 0};
+            if (!admitLocked(bytes, discarded))
+            {
+                discarded.push_back(std::move(elem));
+                continue;
+            }
+            m_queue.push_back(std::move(elem));
+            m_bytes += bytes;
+            if (m_settings.discard == Discard::CODEL)
+            {
+                m_enqueued.push_back(Clock::now());
+            }
+            ++loaded;
+        }
+        // Evictions take the front and the new elements sit at the back, so those evicted again are
+        // exactly the ones beyond the current size.
+        loaded = std::min(loaded, m_queue.size());
+        updateStatus();
+    }
+    m_parking.unparkAll();
+    if (was_empty && loaded > 0 && m_ready_callback)
+    {
+        m_ready_callback();
+    }
+    for (const auto& elem : discarded)
+    {
+        onDiscarded(elem);
+    }
+    return loaded;
+}
+
 } // namespace ThreadSafe
\ No newline at end of file
@@ -0,0 +1,453 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "mapped_file.hpp"
+#include "queue.hpp"
+#include "queue_snapshot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief One push recorded by `QueueCapture`.
+ */
+struct CaptureRecord
+{
+    uint64_t offset_ns{0};          ///< Time the push was entered, since the capture started.
+    uint32_t size{0};               ///< Size of the element in bytes.
+    bool admitted{true};            ///< Whether the queue added the element.
+    std::vector<uint8_t> payload{}; ///< Serialized element, empty unless captured with payloads.
+};
+
+/**
+ * @brief Records the arrival process of a `Queue` to a compact binary file.
+ *
+ * Every call to `Queue::push` is written with the time it was entered, the element size, whether
+ * the queue admitted the element, and optionally the serialized element, so that `QueueReplay`
+ * can reproduce the production traffic against another queue or pool configuration. Pushes
+ * rejected or blocked during overload are thus recorded when they arrived, not left out or
+ * stamped when finally admitted.
+ *
+ * File layout, in native byte order: a header of magic (u32), version (u32) and flags (u32),
+ * followed by one record per push made of the time since the start in nanoseconds (u64), the
+ * element size (u32), the payload size (u32), the outcome (u8, 1 if admitted) and the payload
+ * bytes. Records are written once the push is decided, so concurrent pushes may appear out of
+ * arrival order; `load` sorts them. Records are appended through a buffer, so a capture cut short
+ * by a crash loses at most the buffered tail.
+ *
+ * @tparam T Type of elements stored in the queue.
+ * @tparam S Serializer for T, see `Serializer`. Only used with `Settings::payload`.
+ */
+template<typename T, typename S = Serializer<T>>
+class QueueCapture
+{
+public:
+    static constexpr uint32_t MAGIC = 0x43515354; ///< "TSQC"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t FLAG_PAYLOAD = 1;
+
+    using SizeOf = std::function<std::size_t(const T&)>;
+
+    /**
+     * @brief Settings for the capture.
+     */
+    struct Settings
+    {
+        bool payload{false};              ///< Also record the serialized element.
+        SizeOf size_of{};                 ///< Size of an element, `sizeof(T)` or the payload size if unset.
+        std::size_t flush_bytes{1 << 16}; ///< Buffered bytes that trigger a write to the file.
+    };
+
+    QueueCapture() = default;
+
+    /**
+     * @brief Destructor that stops the capture.
+     */
+    ~QueueCapture();
+
+    // Make this class uncopyable
+    UNCOPYABLE(QueueCapture);
+
+    /**
+     * @brief Start recording the pushes of a queue.
+     *
+     * Installs the arrival callback of the queue, replacing any callback set before, and `stop`
+     * removes it again. The queue must outlive the running capture.
+     *
+     * @param queue The queue to record.
+     * @param path Destination file, replaced if it exists.
+     * @param settings Settings for the capture.
+     * @param serializer Serializer used for the payloads.
+     * @return `true` if the capture started, `false` if it is already running or the file cannot be created.
+     */
+    bool start(Queue<T>& queue, const std::string& path, const Settings& settings, const S& serializer = S{});
+
+    /**
+     * @brief Stop recording, remove the arrival callback and write the buffered records.
+     *
+     * Safe while threads are pushing.
+     *
+     * @return `true` if every record was written, `false` on a write error.
+     */
+    bool stop();
+
+    /**
+     * @brief Number of records since `start`.
+     * @return The number of records.
+     */
+    uint64_t records() const;
+
+    /**
+     * @brief Read a capture file.
+     * @param path File written by a capture.
+     * @param records Vector the records are appended to, in arrival order.
+     * @return `true` if the file was read, `false` if it is missing or malformed. A truncated last
+     *         record is dropped with a warning.
+     */
+    static bool load(const std::string& path, std::vector<CaptureRecord>& records);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief State shared with the callback installed on the queue, which a push in progress may
+     *        still be calling after `stop`.
+     */
+    struct State
+    {
+        std::mutex lock{};
+        bool active{false};
+        Settings settings{};
+        S serializer{};
+        Clock::time_point start{};
+        std::ofstream file{};
+        std::vector<uint8_t> buffer{};
+        std::vector<uint8_t> payload{};
+        uint64_t records{0};
+        bool failed{false};
+
+        void record(const T& elem, const Clock::time_point arrived, const bool admitted); ///< Append a record, with the lock held.
+        void flush();                                                                     ///< Write the buffer to the file, with the lock held.
+    };
+
+    std::shared_ptr<State> m_state{};
+    Queue<T>* m_queue{nullptr}; ///< Queue the callback is installed on, while running.
+
+    template<typename U>
+    static void append(std::vector<uint8_t>& out, const U value)
+    {
+        const auto* bytes{reinterpret_cast<const uint8_t*>(&value)};
+        out.insert(out.end(), bytes, bytes + sizeof(U));
+    }
+
+    template<typename U>
+    static bool read(const uint8_t*& cursor, const uint8_t* end, U& value)
+    {
+        if (static_cast<std::size_t>(end - cursor) < sizeof(U))
+        {
+            return false;
+        }
+        std::memcpy(&value, cursor, sizeof(U));
+        cursor += sizeof(U);
+        return true;
+    }
+};
+
+template<typename T, typename S>
+QueueCapture<T, S>::~QueueCapture()
+{
+    stop();
+}
+
+template<typename T, typename S>
+bool QueueCapture<T, S>::start(Queue<T>& queue, const std::string& path, const Settings& settings, const S& serializer)
+{
+    if (m_state)
+    {
+        std::lock_guard<std::mutex> lock{m_state->lock};
+        if (m_state->active)
+        {
+            LOG_WARNING("The capture is already running: " << path);
+            return false;
+        }
+    }
+    auto state{std::make_shared<State>()};
+    state->file.open(path, std::ios::binary | std::ios::trunc);
+    if (!state->file)
+    {
+        LOG_ERROR("Failed to create capture file: " << path);
+        return false;
+    }
+    state->settings = settings;
+    state->serializer = serializer;
+    state->buffer.reserve(settings.flush_bytes + sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(uint8_t));
+    append(state->buffer, MAGIC);
+    append(state->buffer, VERSION);
+    append(state->buffer, settings.payload ? FLAG_PAYLOAD : uint32_t{0});
+    state->start = Clock::now();
+    state->active = true;
+    m_state = state;
+    m_queue = &queue;
+    // The callback keeps the state alive, so a push racing with `stop` or the destructor is harmless.
+    queue.setArrivalCallback([state](const T& elem, const Clock::time_point arrived, const bool admitted)
+                             {
+                                 std::lock_guard<std::mutex> lock{state->lock};
+                                 if (state->active)
+                                 {
+                                     state->record(elem, arrived, admitted);
+                                 } });
+    return true;
+}
+
+template<typename T, typename S>
+void QueueCapture<T, S>::State::record(const T& elem, const Clock::time_point arrived, const bool admitted)
+{
+    // A push entered just before `start` may still reach the callback.
+    const auto offset{std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(arrived, start) - start).count()};
+    payload.clear();
+    if (settings.payload)
+    {
+        serializer.serialize(elem, payload);
+    }
+    std::size_t size{settings.payload ? payload.size() : sizeof(T)};
+    if (settings.size_of)
+    {
+        size = settings.size_of(elem);
+    }
+    append(buffer, static_cast<uint64_t>(offset));
+    append(buffer, static_cast<uint32_t>(size));
+    append(buffer, static_cast<uint32_t>(payload.size()));
+    append(buffer, static_cast<uint8_t>(admitted ? 1 : 0));
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+    ++records;
+    if (buffer.size() >= settings.flush_bytes)
+    {
+        flush();
+    }
+}
+
+template<typename T, typename S>
+void QueueCapture<T, S>::State::flush()
+{
+    if (buffer.empty())
+    {
+        return;
+    }
+    if (!file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+    {
+        failed = true;
+    }
+    buffer.clear();
+}
+
+template<typename T, typename S>
+bool QueueCapture<T, S>::stop()
+{
+    if (!m_state)
+    {
+        return true;
+    }
+    if (m_queue != nullptr)
+    {
+        m_queue->setArrivalCallback(nullptr);
+        m_queue = nullptr;
+    }
+    std::lock_guard<std::mutex> lock{m_state->lock};
+    if (!m_state->active)
+    {
+        return !m_state->failed;
+    }
+    m_state->active = false;
+    m_state->flush();
+    m_state->file.close();
+    if (m_state->failed || m_state->file.fail())
+    {
+        m_state->failed = true;
+        LOG_ERROR("Failed to write the capture file");
+        return false;
+    }
+    return true;
+}
+
+template<typename T, typename S>
+uint64_t QueueCapture<T, S>::records() const
+{
+    if (!m_state)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock{m_state->lock};
+    return m_state->records;
+}
+
+template<typename T, typename S>
+bool QueueCapture<T, S>::load(const std::string& path, std::vector<CaptureRecord>& records)
+{
+    MappedFile file{};
+    if (!file.open(path))
+    {
+        return false;
+    }
+    const uint8_t* cursor{file.data()};
+    const uint8_t* end{cursor + file.size()};
+
+    uint32_t magic{0};
+    uint32_t version{0};
+    uint32_t flags{0};
+    if (!read(cursor, end, magic) || !read(cursor, end, version) || !read(cursor, end, flags) || magic != MAGIC || version != VERSION)
+    {
+        LOG_ERROR("Invalid capture header: " << path);
+        return false;
+    }
+
+    const std::size_t first{records.size()};
+    while (cursor != end)
+    {
+        CaptureRecord record{};
+        uint32_t payload_size{0};
+        uint8_t admitted{0};
+        if (!read(cursor, end, record.offset_ns) || !read(cursor, end, record.size) || !read(cursor, end, payload_size)
+            || !read(cursor, end, admitted) || static_cast<std::size_t>(end - cursor) < payload_size)
+        {
+            LOG_WARNING("Dropped the truncated last record of capture: " << path);
+            break;
+        }
+        record.admitted = admitted != 0;
+        record.payload.assign(cursor, cursor + payload_size);
+        cursor += payload_size;
+        records.push_back(std::move(record));
+    }
+    // Written in the order the pushes were decided, a blocked push after those that arrived later.
+    std::stable_sort(records.begin() + static_cast<std::ptrdiff_t>(first), records.end(),
+                     [](const CaptureRecord& lhs, const CaptureRecord& rhs) -> bool
+                     { return lhs.offset_ns < rhs.offset_ns; });
+    return true;
+}
+
+/**
+ * @brief Reproduces a captured arrival process, for comparing queue and pool configurations.
+ *
+ * `run` submits one element per record at the record's time, measured from the start of the
+ * replay and scaled by `Settings::speed`. Elements are built before the clock starts, from the
+ * payload where one was captured and from `Settings::factory` otherwise, so building them does
+ * not disturb the timing.
+ *
+ * The submit function receives the scheduled arrival time of each element. Measuring latency from
+ * that time rather than from the actual submission keeps a stalled consumer from hiding its own
+ * delay when it also blocks the replay, e.g. through a full queue. Pacing relies on
+ * `std::this_thread::sleep_until`, so arrivals closer together than the scheduler resolution are
+ * submitted in bursts; `Result::max_lag` shows how far the replay fell behind.
+ *
+ * @tparam T Type of the replayed elements.
+ * @tparam S Serializer for T, see `Serializer`.
+ */
+template<typename T, typename S = Serializer<T>>
+class QueueReplay
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Submit = std::function<bool(const T&, const Clock::time_point)>;
+    using Factory = std::function<T(const CaptureRecord&)>;
+
+    /**
+     * @brief Settings for the replay.
+     */
+    struct Settings
+    {
+        double speed{1.0}; ///< Time scale, 2 replays twice as fast, 0 submits without pacing.
+        Factory factory{}; ///< Builds elements of records without payload, `T{}` if unset.
+    };
+
+    /**
+     * @brief Outcome of a replay.
+     */
+    struct Result
+    {
+        uint64_t offered{0};        ///< Elements submitted.
+        uint64_t accepted{0};       ///< Submissions that returned `true`.
+        Clock::duration duration{}; ///< Time from the start to the last submission.
+        Clock::duration max_lag{};  ///< Largest delay of a submission behind its schedule, 0 without pacing.
+
+        /**
+         * @brief Accepted elements per second.
+         * @return The throughput, 0 for an empty replay.
+         */
+        double throughput() const
+        {
+            const double seconds{std::chrono::duration<double>(duration).count()};
+            return seconds > 0.0 ? static_cast<double>(accepted) / seconds : 0.0;
+        }
+    };
+
+    /**
+     * @brief Submit the recorded arrivals on the calling thread.
+     * @param records The records, in arrival order, e.g. from `QueueCapture::load`.
+     * @param submit Called for each element, e.g. pushing to a queue or submitting to a pool.
+     * @param settings Settings for the replay.
+     * @param serializer Serializer used for the payloads.
+     * @return The outcome of the replay.
+     */
+    static Result run(const std::vector<CaptureRecord>& records, const Submit& submit, const Settings& settings = Settings{},
+                      const S& serializer = S{});
+};
+
+template<typename T, typename S>
+typename QueueReplay<T, S>::Result QueueReplay<T, S>::run(const std::vector<CaptureRecord>& records, const Submit& submit,
+                                                          const Settings& settings, const S& serializer)
+{
+    std::vector<T> elems{};
+    elems.reserve(records.size());
+    for (const auto& record : records)
+    {
+        T elem{};
+        if (!record.payload.empty())
+        {
+            if (!serializer.deserialize(record.payload.data(), record.payload.size(), elem))
+            {
+                LOG_WARNING("Replaying an undecodable payload as a default element");
+            }
+        }
+        else if (settings.factory)
+        {
+            elem = settings.factory(record);
+        }
+        elems.push_back(std::move(elem));
+    }
+
+    Result result{};
+    const auto start{Clock::now()};
+    for (std::size_t i{0}; i < records.size(); ++i)
+    {
+        auto scheduled{Clock::now()};
+        if (settings.speed > 0.0)
+        {
+            scheduled = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(
+                                    static_cast<double>(records[i].offset_ns) / settings.speed));
+            std::this_thread::sleep_until(scheduled);
+            result.max_lag = std::max(result.max_lag, Clock::now() - scheduled);
+        }
+        ++result.offered;
+        if (submit(elems[i], scheduled))
+        {
+            ++result.accepted;
+        }
+    }
+    result.duration = Clock::now() - start;
+    return result;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Discard policy for a full queue, also named `Queue<T>::Discard`.
+ *
+ * Declared outside `Queue` so that a policy can be named without including the queue.
+ */
+enum class QueueDiscard : uint32_t
+{
+    DISCARD_OLDEST = 0, ///< Discard the oldest element when full.
+    DISCARD_NEWEST = 1, ///< Discard the newest element when full.
+    NO_DISCARD = 2,     ///< Do not discard any elements.
+    CODEL = 3           ///< Discard elements that waited too long under a standing backlog, see `Queue::Codel`.
+};
+
+} // namespace ThreadSafe
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "mapped_file.hpp"
+#include "queue.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Converts queue elements to and from bytes for `QueueSnapshot`.
+ *
+ * Trivially copyable types and `std::string` are supported out of the box. Other types plug in
+ * by specializing this template, or by passing a serializer with the same two member functions
+ * to `QueueSnapshot`.
+ *
+ * @tparam T Type of the serialized elements.
+ */
+template<typename T, typename Enable = void>
+struct Serializer;
+
+template<typename T>
+struct Serializer<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+    /**
+     * @brief Append the bytes of `elem` to `out`.
+     */
+    void serialize(const T& elem, std::vector<uint8_t>& out) const
+    {
+        const auto* bytes{reinterpret_cast<const uint8_t*>(&elem)};
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * @brief Rebuild `elem` from `size` bytes at `data`.
+     * @return `true` on success, `false` if the bytes do not form a valid element.
+     */
+    bool deserialize(const uint8_t* data, std::size_t size, T& elem) const
+    {
+        if (size != sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&elem, data, sizeof(T));
+        return true;
+    }
+};
+
+template<>
+struct Serializer<std::string>
+{
+    void serialize(const std::string& elem, std::vector<uint8_t>& out) const
+    {
+        out.insert(out.end(), elem.begin(), elem.end());
+    }
+
+    bool deserialize(const uint8_t* data, std::size_t size, std::string& elem) const
+    {
+        elem.assign(reinterpret_cast<const char*>(data), size);
+        return true;
+    }
+};
+
+/**
+ * @brief Saves queue contents to a compact binary file and restores them, for warm restarts.
+ *
+ * File layout, in native byte order: a header of magic (u32), version (u32) and element count (u64),
+ * followed by one record per element made of its size (u32) and its serialized bytes.
+ * Files are written to a temporary path and renamed into place, so a crash while saving never
+ * leaves a truncated snapshot behind. Restoring maps the file and bulk-loads the queue under a
+ * single lock acquisition.
+ *
+ * @tparam T Type of elements stored in the queue.
+ * @tparam S Serializer for T, see `Serializer`.
+ */
+template<typename T, typename S = Serializer<T>>
+class QueueSnapshot
+{
+public:
+    static constexpr uint32_t MAGIC = 0x53515354; ///< "TSQS"
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief How the contents are taken from the queue.
+     */
+    enum class Mode : uint32_t
+    {
+        COPY = 0, ///< Consistent copy, the queue keeps its elements and keeps running.
+        DRAIN = 1 ///< Close push, then remove every element. Use when shutting down.
+    };
+
+    /**
+     * @brief Save the queue contents to a file.
+     * @param queue The queue to save.
+     * @param path Destination file, replaced durably through `replaceFile`.
+     * @param mode Whether the elements are copied or drained.
+     * @param serializer Serializer used for each element.
+     * @return `true` if the snapshot was written, `false` otherwise.
+     */
+    static bool save(Queue<T>& queue, const std::string& path, const Mode mode = Mode::COPY, const S& serializer = S{});
+
+    /**
+     * @brief Restore a snapshot into a queue, appending to any elements already present.
+     * @param queue The queue to fill.
+     * @param path Snapshot file written by `save`.
+     * @param serializer Serializer used for each element.
+     * @return `true` if every element was restored, `false` if the file is missing or malformed, or
+     *         if the queue discarded elements for lack of room.
+     */
+    static bool load(Queue<T>& queue, const std::string& path, const S& serializer = S{});
+
+private:
+    template<typename U>
+    static void append(std::vector<uint8_t>& out, const U value)
+    {
+        const auto* bytes{reinterpret_cast<const uint8_t*>(&value)};
+        out.insert(out.end(), bytes, bytes + sizeof(U));
+    }
+
+    template<typename U>
+    static bool read(const uint8_t*& cursor, const uint8_t* end, U& value)
+    {
+        if (static_cast<std::size_t>(end - cursor) < sizeof(U))
+        {
+            return false;
+        }
+        std::memcpy(&value, cursor, sizeof(U));
+        cursor += sizeof(U);
+        return true;
+    }
+};
+
+template<typename T, typename S>
+bool QueueSnapshot<T, S>::save(Queue<T>& queue, const std::string& path, const Mode mode, const S& serializer)
+{
+    std::vector<T> elems{};
+    if (mode == Mode::DRAIN)
+    {
+        queue.closePush();
+        elems = queue.drain();
+    }
+    else
+    {
+        elems = queue.snapshot();
+    }
+
+    std::vector<uint8_t> buffer{};
+    append(buffer, MAGIC);
+    append(buffer, VERSION);
+    append(buffer, static_cast<uint64_t>(elems.size()));
+    for (const auto& elem : elems)
+    {
+        const std::size_t size_offset{buffer.size()};
+        append(buffer, uint32_t{0});
+        serializer.serialize(elem, buffer);
+        const auto elem_size{static_cast<uint32_t>(buffer.size() - size_offset - sizeof(uint32_t))};
+        std::memcpy(buffer.data() + size_offset, &elem_size, sizeof(elem_size));
+    }
+
+    if (!replaceFile(path, buffer))
+    {
+        LOG_ERROR("Failed to save snapshot: " << path);
+        return false;
+    }
+    return true;
+}
+
+template<typename T, typename S>
+bool QueueSnapshot<T, S>::load(Queue<T>& queue, const std::string& path, const S& serializer)
+{
+    MappedFile file{};
+    if (!file.open(path))
+    {
+        return false;
+    }
+    const uint8_t* cursor{file.data()};
+    const uint8_t* end{cursor + file.size()};
+
+    uint32_t magic{0};
+    uint32_t version{0};
+    uint64_t count{0};
+    if (!read(cursor, end, magic) || !read(cursor, end, version) || !read(cursor, end, count) || magic != MAGIC || version != VERSION)
+    {
+        LOG_ERROR("Invalid snapshot header: " << path);
+        return false;
+    }
+
+    // Every record has at least its size field, so a corrupted count cannot exceed the file.
+    const uint64_t max_count{static_cast<uint64_t>(end - cursor) / sizeof(uint32_t)};
+    if (count > max_count)
+    {
+        LOG_ERROR("Invalid snapshot element count " << count << ": " << path);
+        return false;
+    }
+    std::vector<T> elems{};
+    elems.reserve(static_cast<std::size_t>(count));
+    for (uint64_t i{0}; i < count; ++i)
+    {
+        uint32_t elem_size{0};
+        T elem{};
+        if (!read(cursor, end, elem_size) || static_cast<std::size_t>(end - cursor) < elem_size || !serializer.deserialize(cursor, elem_size, elem))
+        {
+            LOG_ERROR("Corrupted snapshot record " << i << ": " << path);
+            return false;
+        }
+        cursor += elem_size;
+        elems.push_back(std::move(elem));
+    }
+    const std::size_t loaded{queue.bulkLoad(std::move(elems))};
+    if (loaded != count)
+    {
+        LOG_WARNING("Restored " << loaded << " of " << count << " snapshot elements: " << path);
+        return false;
+    }
+    return true;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "ring_buffer.hpp"
+
+#include <deque>
+#include <utility>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Element storage of a `Queue`, not thread-safe.
+ *
+ * Real-time queues use a `RingBuffer`, which does not touch the heap once reserved but keeps its
+ * largest allocation until destroyed. Every other queue uses a `std::deque`, whose blocks are
+ * freed again as a spike drains.
+ *
+ * @tparam T Type of elements stored.
+ */
+template<typename T>
+class QueueStorage
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param contiguous Whether to use the ring buffer instead of the deque.
+     */
+    explicit QueueStorage(const bool contiguous)
+        : m_contiguous{contiguous}
+    {
+    }
+
+    // Make this class uncopyable
+    UNCOPYABLE(QueueStorage);
+
+    /**
+     * @brief Allocate the ring buffer for at least `capacity` elements, ignored by the deque.
+     * @param capacity The number of elements.
+     */
+    void reserve(const std::size_t capacity)
+    {
+        if (m_contiguous)
+        {
+            m_ring.reserve(capacity);
+        }
+    }
+
+    void push_back(const T& elem)
+    {
+        m_contiguous ? m_ring.push_back(elem) : m_deque.push_back(elem);
+    }
+
+    void push_back(T&& elem)
+    {
+        m_contiguous ? m_ring.push_back(std::move(elem)) : m_deque.push_back(std::move(elem));
+    }
+
+    void pop_front()
+    {
+        m_contiguous ? m_ring.pop_front() : m_deque.pop_front();
+    }
+
+    void pop_back()
+    {
+        m_contiguous ? m_ring.pop_back() : m_deque.pop_back();
+    }
+
+    T& front()
+    {
+        return m_contiguous ? m_ring.front() : m_deque.front();
+    }
+
+    T& back()
+    {
+        return m_contiguous ? m_ring.back() : m_deque.back();
+    }
+
+    const T& front() const
+    {
+        return m_contiguous ? m_ring.front() : m_deque.front();
+    }
+
+    const T& back() const
+    {
+        return m_contiguous ? m_ring.back() : m_deque.back();
+    }
+
+    bool empty() const
+    {
+        return m_contiguous ? m_ring.empty() : m_deque.empty();
+    }
+
+    std::size_t size() const
+    {
+        return m_contiguous ? m_ring.size() : m_deque.size();
+    }
+
+    void clear()
+    {
+        m_contiguous ? m_ring.clear() : m_deque.clear();
+    }
+
+    /**
+     * @brief Call `func` for every element, from the front.
+     * @tparam F Callable taking `T&`.
+     * @param func The callable.
+     */
+    template<typename F>
+    void forEach(F&& func)
+    {
+        m_contiguous ? visit(m_ring, func) : visit(m_deque, func);
+    }
+
+    /**
+     * @brief Call `func` for every element, from the front.
+     * @tparam F Callable taking `const T&`.
+     * @param func The callable.
+     */
+    template<typename F>
+    void forEach(F&& func) const
+    {
+        m_contiguous ? visit(m_ring, func) : visit(m_deque, func);
+    }
+
+private:
+    const bool m_contiguous;
+    RingBuffer<T> m_ring{};
+    std::deque<T> m_deque{};
+
+    template<typename C, typename F>
+    static void visit(C& container, F& func)
+    {
+        for (auto& elem : container)
+        {
+            func(elem);
+        }
+    }
+};
+
+} // namespace ThreadSafe
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "batch_controller.hpp"
+#include "queue.hpp"
+#include "thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Consumer threads that pop a `Queue` in batches and hand each batch to a handler.
+ *
+ * Replaces the usual `Thread` in LOOP mode that pops with a timeout and processes one element.
+ * Every worker thread pops up to `batch_size` elements with one wait, passes them to the
+ * handler and records throughput and backlog metrics. `stop` can drain the queue first:
+ * push is closed (for push-controlled queues), the workers keep going until the queue is empty,
+ * and only then are the threads stopped.
+ *
+ * With a `BatchController`, the batch size and linger time of every pop come from the controller
+ * instead of `batch_size`, and each batch is reported back to it.
+ *
+ * @tparam T Type of elements stored in the queue.
+ */
+template<typename T>
+class QueueWorker
+{
+public:
+    using Handler = std::function<void(std::vector<T>&)>;
+
+    /**
+     * @brief Settings for the worker threads.
+     */
+    struct Settings
+    {
+        std::string name{"queue-worker"};                ///< Base name of the threads.
+        std::size_t threads{1};                          ///< Number of consumer threads.
+        std::size_t batch_size{64};                      ///< Maximum elements per handler call.
+        uint32_t poll_timeout_ms{100};                   ///< Longest wait for the first element of a batch.
+        ThreadPriority priority{ThreadPriority::NORMAL}; ///< Priority of the threads.
+        std::shared_ptr<BatchController> controller{};   ///< Adapts batch size and linger time, optional.
+    };
+
+    /**
+     * @brief Processing metrics, all counted since `start`.
+     */
+    struct Metrics
+    {
+        uint64_t processed{0};                    ///< Elements handed to the handler.
+        uint64_t batches{0};                      ///< Handler calls.
+        double throughput{0.0};                   ///< Elements per second.
+        std::size_t backlog{0};                   ///< Elements waiting in the queue.
+        std::chrono::milliseconds lag{0};         ///< Time needed to clear the backlog at the current throughput.
+        std::chrono::microseconds batch_time{0};  ///< Average handler time per batch.
+    };
+
+    /**
+     * @brief Constructor.
+     * @param queue The queue to consume, must outlive the worker.
+     * @param handler Callable processing one batch. Elements may be moved out of the vector.
+     * @param settings Settings for the worker threads.
+     */
+    QueueWorker(Queue<T>& queue, Handler handler, const Settings& settings);
+
+    /**
+     * @brief Destructor that stops the threads without draining.
+     */
+    ~QueueWorker();
+
+    // Make this class uncopyable
+    UNCOPYABLE(QueueWorker);
+
+    /**
+     * @brief Start the consumer threads.
+     * @return `true` if started, `false` if already running.
+     */
+    bool start();
+
+    /**
+     * @brief Stop the consumer threads.
+     *
+     * Push is closed first if the queue is push-controlled, so no new work arrives.
+     *
+     * @param drain If `true`, wait until every queued element has been processed before stopping.
+     * @return `true` if stopped, `false` if not running.
+     */
+    bool stop(const bool drain = true);
+
+    /**
+     * @brief Snapshot of the processing metrics.
+     * @return The metrics.
+     */
+    Metrics metrics() const;
+
+private:
+    using Worker = Thread<bool>;
+    using Clock = std::chrono::steady_clock;
+
+    Queue<T>& m_queue;
+    const Handler m_handler;
+    const Settings m_settings;
+    std::vector<std::unique_ptr<Worker>> m_workers{};
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_processed{0};
+    std::atomic<uint64_t> m_batches{0};
+    std::atomic<uint64_t> m_busy_us{0};
+    std::atomic<std::size_t> m_in_flight{0}; ///< Batches popped and being handled right now.
+    Clock::time_point m_start_time{};
+    std::mutex m_idle_lock{};
+    std::condition_variable m_idle_condition{};
+
+    bool processBatch(); ///< One iteration of a worker thread.
+};
+
+template<typename T>
+QueueWorker<T>::QueueWorker(Queue<T>& queue, Handler handler, const Settings& settings)
+    : m_queue{queue}
+    , m_handler{std::move(handler)}
+    , m_settings{settings}
+{
+}
+
+template<typename T>
+QueueWorker<T>::~QueueWorker()
+{
+    stop(false);
+}
+
+template<typename T>
+bool QueueWorker<T>::start()
+{
+    if (m_running)
+    {
+        LOG_WARNING("The queue worker has already started!")
+        return false;
+    }
+    m_running = true;
+    m_start_time = Clock::now();
+    for (std::size_t i{0}; i < m_settings.threads; ++i)
+    {
+        auto worker{std::make_unique<Worker>(m_settings.name + "-" + std::to_string(i), m_settings.priority)};
+        worker->invoke([this]() -> bool
+                       { return processBatch(); });
+        worker->setPredicate([this]() -> bool
+                             { return m_running; });
+        worker->start(RunMode::LOOP);
+        m_workers.push_back(std::move(worker));
+    }
+    return true;
+}
+
+template<typename T>
+bool QueueWorker<T>::stop(const bool drain)
+{
+    if (!m_running)
+    {
+        return false;
+    }
+    m_queue.closePush();
+    if (drain)
+    {
+        // A batch popped but not counted yet is finished by the join below.
+        std::unique_lock<std::mutex> lock{m_idle_lock};
+        m_idle_condition.wait(lock, [this]() -> bool
+                              { return m_queue.size() == 0 && m_in_flight == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_idle_lock};
+        m_running = false;
+    }
+    m_idle_condition.notify_all();
+    // Destroying a worker stops and joins it.
+    m_workers.clear();
+    return true;
+}
+
+template<typename T>
+bool QueueWorker<T>::processBatch()
+{
+    BatchController* controller{m_settings.controller.get()};
+    const std::size_t batch_size{controller != nullptr ? controller->batchSize() : m_settings.batch_size};
+    const uint32_t linger_us{controller != nullptr ? controller->lingerUs() : 0};
+    std::vector<T> batch{};
+    batch.reserve(batch_size);
+    const auto pop_start{Clock::now()};
+    const std::size_t count{m_queue.popBatch(batch, batch_size, m_settings.poll_timeout_ms, linger_us)};
+    if (count > 0)
+    {
+        // Only a worker holding a batch counts, one blocked in the pop must not hold up a drain.
+        ++m_in_flight;
+        const std::size_t backlog{m_queue.size()};
+        const auto start{Clock::now()};
+        m_handler(batch);
+        const auto busy{std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start)};
+        m_busy_us += static_cast<uint64_t>(busy.count());
+        m_processed += count;
+        ++m_batches;
+        if (controller != nullptr)
+        {
+            controller->record(count, backlog, busy);
+        }
+        bool idle{false};
+        {
+            std::lock_guard<std::mutex> lock{m_idle_lock};
+            idle = --m_in_flight == 0;
+        }
+        if (idle)
+        {
+            m_idle_condition.notify_all();
+        }
+    }
+
+    const auto poll_timeout{std::chrono::milliseconds(m_settings.poll_timeout_ms)};
+    if (count == 0 && Clock::now() - pop_start < poll_timeout)
+    {
+        // The queue is closed and returns immediately, idle here instead of spinning until stop.
+        std::unique_lock<std::mutex> lock{m_idle_lock};
+        m_idle_condition.wait_for(lock, poll_timeout, [this]() -> bool
+                                  { return !m_running; });
+    }
+    return count > 0;
+}
+
+template<typename T>
+typename QueueWorker<T>::Metrics QueueWorker<T>::metrics() const
+{
+    Metrics metrics{};
+    metrics.processed = m_processed;
+    metrics.batches = m_batches;
+    metrics.backlog = m_queue.size();
+    const auto elapsed{std::chrono::duration<double>(Clock::now() - m_start_time).count()};
+    if (m_start_time != Clock::time_point{} && elapsed > 0.0)
+    {
+        metrics.throughput = static_cast<double>(metrics.processed) / elapsed;
+    }
+    if (metrics.throughput > 0.0)
+    {
+        metrics.lag = std::chrono::milliseconds(static_cast<int64_t>(1000.0 * static_cast<double>(metrics.backlog) / metrics.throughput));
+    }
+    if (metrics.batches > 0)
+    {
+        metrics.batch_time = std::chrono::microseconds(m_busy_us / metrics.batches);
+    }
+    return metrics;
+}
+
+} // namespace ThreadSafe
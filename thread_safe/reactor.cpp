@@ -0,0 +1,342 @@
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+struct Reactor::Events
+{
+#ifdef __linux__
+    std::vector<epoll_event> buffer{};
+#endif
+};
+
+namespace
+{
+
+#ifdef __linux__
+uint32_t toEpoll(const uint32_t events)
+{
+    uint32_t native{EPOLLET};
+    if ((events & Reactor::READABLE) != 0)
+    {
+        native |= EPOLLIN | EPOLLRDHUP;
+    }
+    if ((events & Reactor::WRITABLE) != 0)
+    {
+        native |= EPOLLOUT;
+    }
+    return native;
+}
+
+uint32_t fromEpoll(const uint32_t native)
+{
+    uint32_t events{0};
+    if ((native & EPOLLIN) != 0)
+    {
+        events |= Reactor::READABLE;
+    }
+    if ((native & EPOLLOUT) != 0)
+    {
+        events |= Reactor::WRITABLE;
+    }
+    if ((native & (EPOLLHUP | EPOLLRDHUP)) != 0)
+    {
+        events |= Reactor::HANGUP;
+    }
+    if ((native & EPOLLERR) != 0)
+    {
+        events |= Reactor::ERROR;
+    }
+    return events;
+}
+#endif
+
+} // namespace
+
+Reactor::Signal::~Signal()
+{
+#ifdef __linux__
+    ::close(fd);
+#endif
+}
+
+void Reactor::Signal::raise() const
+{
+#ifdef __linux__
+    const uint64_t one{1};
+    // Only fails when the counter would overflow, then the eventfd is readable anyway.
+    (void)::write(fd, &one, sizeof(one));
+#endif
+}
+
+void Reactor::Signal::clear() const
+{
+#ifdef __linux__
+    uint64_t value{0};
+    (void)::read(fd, &value, sizeof(value));
+#endif
+}
+
+Reactor::Reactor(const std::string& name, const ThreadPriority priority, const Settings& settings)
+    : m_settings{settings}
+    , m_thread{name, priority}
+    , m_events{std::make_unique<Events>()}
+{
+#ifdef __linux__
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        LOG_ERROR("Failed to create epoll instance for reactor: " << name);
+    }
+    m_wake = createSignal();
+    if (m_epoll >= 0 && m_wake)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.fd = m_wake->fd;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake->fd, &event);
+    }
+#else
+    LOG_ERROR("The reactor is not supported on this platform: " << name);
+#endif
+    m_thread.invoke([this]() -> bool
+                    { return iterate(); });
+    m_thread.setPredicate([this]() -> bool
+                          { return !m_stopping; });
+    m_thread.setStartCallback([this]()
+                              { m_thread_id = std::this_thread::get_id(); });
+    m_thread.setExitCallback([this]()
+                             { m_thread_id = std::thread::id{}; });
+}
+
+Reactor::Reactor(const std::string& name, const ThreadPriority priority)
+    : Reactor(name, priority, Settings{})
+{
+}
+
+Reactor::~Reactor()
+{
+    stop();
+#ifdef __linux__
+    if (m_epoll >= 0)
+    {
+        ::close(m_epoll);
+    }
+#endif
+}
+
+bool Reactor::start()
+{
+    if (m_epoll < 0 || !m_wake)
+    {
+        LOG_ERROR("Cannot start the reactor without epoll");
+        return false;
+    }
+    if (isReactorThread())
+    {
+        return false;
+    }
+#ifdef __linux__
+    m_events->buffer.resize(std::max<std::size_t>(1, m_settings.max_events));
+#endif
+    m_stopping = false;
+    return m_thread.start(RunMode::LOOP);
+}
+
+bool Reactor::stop()
+{
+    if (isReactorThread())
+    {
+        LOG_ERROR("Cannot stop the reactor from its own thread");
+        return false;
+    }
+    m_stopping = true;
+    if (m_wake)
+    {
+        m_wake->raise();
+    }
+    return m_thread.stop();
+}
+
+bool Reactor::add(const int fd, const uint32_t events, Handler handler)
+{
+#ifdef __linux__
+    if (!handler || m_epoll < 0)
+    {
+        LOG_ERROR("Cannot register file descriptor " << fd);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (m_registered.count(fd) > 0)
+    {
+        LOG_ERROR("File descriptor " << fd << " is already registered");
+        return false;
+    }
+    epoll_event event{};
+    event.events = toEpoll(events);
+    event.data.fd = fd;
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        LOG_ERROR("Failed to register file descriptor " << fd << ", errno " << errno);
+        return false;
+    }
+    auto registration{std::make_shared<Registration>()};
+    registration->handler = std::move(handler);
+    m_registered.emplace(fd, std::move(registration));
+    return true;
+#else
+    LOG_ERROR("Cannot register file descriptor " << fd << " on this platform");
+    return false;
+#endif
+}
+
+bool Reactor::modify(const int fd, const uint32_t events)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (m_registered.count(fd) == 0)
+    {
+        return false;
+    }
+    epoll_event event{};
+    event.events = toEpoll(events);
+    event.data.fd = fd;
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event) != 0)
+    {
+        LOG_ERROR("Failed to modify file descriptor " << fd << ", errno " << errno);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Reactor::remove(const int fd)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{m_lock};
+    auto it{m_registered.find(fd)};
+    if (it == m_registered.end())
+    {
+        return false;
+    }
+    // Fails if the descriptor was closed already, which removed it from the epoll set as well.
+    ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    it->second->active = false;
+    m_registered.erase(it);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Reactor::isReactorThread() const
+{
+    return m_thread_id.load() == std::this_thread::get_id();
+}
+
+bool Reactor::iterate()
+{
+#ifdef __linux__
+    std::vector<epoll_event>& buffer{m_events->buffer};
+    const int count{::epoll_wait(m_epoll, buffer.data(), static_cast<int>(buffer.size()), -1)};
+    if (count < 0)
+    {
+        if (errno != EINTR)
+        {
+            LOG_ERROR("epoll_wait failed, errno " << errno);
+        }
+        return !m_stopping;
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        for (int i{0}; i < count; ++i)
+        {
+            const int fd{buffer[i].data.fd};
+            if (fd == m_wake->fd)
+            {
+                m_wake->clear();
+                continue;
+            }
+            auto it{m_registered.find(fd)};
+            if (it != m_registered.end())
+            {
+                m_ready.emplace_back(it->second, fromEpoll(buffer[i].events));
+            }
+        }
+    }
+    // Handlers run without the lock, so they can register and unregister sources.
+    for (Ready& ready : m_ready)
+    {
+        if (ready.first->active)
+        {
+            ready.first->handler(ready.second);
+        }
+    }
+    m_ready.clear();
+#endif
+    return !m_stopping;
+}
+
+std::shared_ptr<Reactor::Signal> Reactor::createSignal()
+{
+#ifdef __linux__
+    const int fd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to create eventfd, errno " << errno);
+        return nullptr;
+    }
+    return std::make_shared<Signal>(fd);
+#else
+    return nullptr;
+#endif
+}
+
+bool Reactor::addSignal(const std::shared_ptr<Signal>& signal, const void* queue, Handler handler)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        if (m_queues.count(queue) > 0)
+        {
+            LOG_ERROR("Queue is already registered");
+            return false;
+        }
+    }
+    if (!add(signal->fd, READABLE, std::move(handler)))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock{m_lock};
+    m_queues.emplace(queue, signal);
+    return true;
+}
+
+std::shared_ptr<Reactor::Signal> Reactor::removeSignal(const void* queue)
+{
+    std::shared_ptr<Signal> signal{};
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        auto it{m_queues.find(queue)};
+        if (it == m_queues.end())
+        {
+            return nullptr;
+        }
+        signal = it->second;
+        m_queues.erase(it);
+    }
+    remove(signal->fd);
+    return signal;
+}
+
+} // namespace ThreadSafe
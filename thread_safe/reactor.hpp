@@ -0,0 +1,242 @@
+#pragma once
+#include "common/common.hpp"
+
+#include "queue.hpp"
+#include "thread.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief I/O thread that waits for many file descriptors and queues at once and dispatches
+ * their handlers inline.
+ *
+ * File descriptors are registered edge-triggered, so a handler is called once per change of
+ * readiness and has to read or write until the call would block. Up to `max_events` ready
+ * sources are collected by one `epoll_wait` and dispatched in a row.
+ *
+ * A `Queue` registered with `addQueue` signals an eventfd when it becomes non-empty, so the
+ * reactor thread pops its elements between two I/O events instead of a separate thread blocking
+ * in `pop`. Linux only, elsewhere every registration fails.
+ */
+class Reactor
+{
+public:
+    using Handler = std::function<void(const uint32_t events)>;
+
+    static constexpr uint32_t READABLE = 1u << 0; ///< Data can be read, or the peer closed.
+    static constexpr uint32_t WRITABLE = 1u << 1; ///< Data can be written.
+    static constexpr uint32_t HANGUP = 1u << 2;   ///< The peer closed, reported even if not requested.
+    static constexpr uint32_t ERROR = 1u << 3;    ///< An error is pending, reported even if not requested.
+
+    /**
+     * @brief Settings for the reactor.
+     */
+    struct Settings
+    {
+        std::size_t max_events{64};  ///< Ready sources collected per `epoll_wait`.
+        std::size_t queue_batch{64}; ///< Elements popped per wakeup of a queue before other sources are served.
+    };
+
+    /**
+     * @brief Constructor that creates the epoll instance.
+     * @param name The name of the reactor thread.
+     * @param priority The priority of the reactor thread.
+     * @param settings Settings for the reactor.
+     */
+    Reactor(const std::string& name, const ThreadPriority priority, const Settings& settings);
+
+    /**
+     * @brief Constructor with the default settings.
+     * @param name The name of the reactor thread.
+     * @param priority The priority of the reactor thread.
+     */
+    explicit Reactor(const std::string& name, const ThreadPriority priority = ThreadPriority::NORMAL);
+
+    /**
+     * @brief Destructor that stops the thread. Registered file descriptors are not closed.
+     */
+    ~Reactor();
+
+    // Make this class uncopyable
+    UNCOPYABLE(Reactor);
+
+    /**
+     * @brief Start the reactor thread.
+     * @return `true` if started, `false` if already running or epoll is not available.
+     */
+    bool start();
+
+    /**
+     * @brief Stop the reactor thread after the handlers of the current batch returned.
+     * @return `true` if stopped, `false` if not running.
+     */
+    bool stop();
+
+    /**
+     * @brief Register a file descriptor.
+     * @param fd The file descriptor, should be non-blocking.
+     * @param events `READABLE` and/or `WRITABLE`.
+     * @param handler Called on the reactor thread with the ready events.
+     * @return `true` if registered, `false` otherwise.
+     */
+    bool add(const int fd, const uint32_t events, Handler handler);
+
+    /**
+     * @brief Change the events of a registered file descriptor.
+     * @param fd The file descriptor.
+     * @param events `READABLE` and/or `WRITABLE`.
+     * @return `true` if changed, `false` otherwise.
+     */
+    bool modify(const int fd, const uint32_t events);
+
+    /**
+     * @brief Unregister a file descriptor.
+     *
+     * From the reactor thread the handler is not called again once this returns. From another
+     * thread, a handler call that already started may still be running.
+     *
+     * @param fd The file descriptor.
+     * @return `true` if unregistered, `false` if it was not registered.
+     */
+    bool remove(const int fd);
+
+    /**
+     * @brief Register a queue as an event source.
+     *
+     * Takes the queue's ready callback. The handler is called on the reactor thread for every
+     * popped element, at most `queue_batch` per wakeup.
+     *
+     * @tparam T Type of the queue elements.
+     * @param queue The queue, must outlive its registration.
+     * @param handler Called with each popped element.
+     * @return `true` if registered, `false` otherwise.
+     */
+    template<typename T>
+    bool addQueue(Queue<T>& queue, std::function<void(T&)> handler);
+
+    /**
+     * @brief Unregister a queue. No thread may push to it concurrently.
+     * @tparam T Type of the queue elements.
+     * @param queue The queue.
+     * @return `true` if unregistered, `false` if it was not registered.
+     */
+    template<typename T>
+    bool removeQueue(Queue<T>& queue);
+
+    /**
+     * @brief Check whether the calling thread is the reactor thread.
+     * @return `true` if called from a handler of this reactor, `false` otherwise.
+     */
+    bool isReactorThread() const;
+
+private:
+    /**
+     * @brief A registered file descriptor.
+     */
+    struct Registration
+    {
+        Handler handler;
+        std::atomic<bool> active{true}; ///< Cleared by `remove`, checked before every call.
+    };
+
+    /**
+     * @brief Eventfd signalled by a registered queue, closed with its last owner.
+     */
+    struct Signal
+    {
+        const int fd;
+
+        explicit Signal(const int signal_fd)
+            : fd{signal_fd}
+        {
+        }
+        ~Signal();
+        void raise() const; ///< Make the eventfd readable.
+        void clear() const; ///< Consume the pending signals.
+    };
+
+    struct Events; ///< Buffer for `epoll_wait`, defined with the platform headers.
+
+    using Ready = std::pair<std::shared_ptr<Registration>, uint32_t>; ///< A handler and its events.
+
+    const Settings m_settings;
+    Thread<bool> m_thread;
+    int m_epoll{-1};
+    std::shared_ptr<Signal> m_wake{};                                      ///< Wakes the thread for `stop`.
+    std::unique_ptr<Events> m_events;                                      ///< Reactor thread only.
+    std::vector<Ready> m_ready{};                                          ///< Handlers of one batch, reactor thread only.
+    mutable std::mutex m_lock{};                                           ///< Protects the maps.
+    std::unordered_map<int, std::shared_ptr<Registration>> m_registered{}; ///< Registrations by file descriptor.
+    std::map<const void*, std::shared_ptr<Signal>> m_queues{};             ///< Signals of the registered queues.
+    std::atomic<bool> m_stopping{false};                                   ///< The thread must return.
+    std::atomic<std::thread::id> m_thread_id{};                            ///< Id of the reactor thread while it runs.
+
+    bool iterate();                         ///< One `epoll_wait` and the dispatch of its events.
+    std::shared_ptr<Signal> createSignal(); ///< New eventfd, `nullptr` on failure.
+    bool addSignal(const std::shared_ptr<Signal>& signal, const void* queue, Handler handler);
+    std::shared_ptr<Signal> removeSignal(const void* queue);
+};
+
+template<typename T>
+bool Reactor::addQueue(Queue<T>& queue, std::function<void(T&)> handler)
+{
+    std::shared_ptr<Signal> signal{createSignal()};
+    if (!signal || !handler)
+    {
+        return false;
+    }
+    const std::size_t batch{std::max<std::size_t>(1, m_settings.queue_batch)};
+    auto on_ready{[&queue, signal, handler = std::move(handler), batch, elems = std::vector<T>{}](const uint32_t) mutable
+                  {
+                      signal->clear();
+                      elems.clear();
+                      queue.popBatch(elems, batch, 0);
+                      for (T& elem : elems)
+                      {
+                          handler(elem);
+                      }
+                      // Elements pushed meanwhile did not signal, the queue was not empty.
+                      if (queue.size() > 0)
+                      {
+                          signal->raise();
+                      }
+                  }};
+    if (!addSignal(signal, &queue, std::move(on_ready)))
+    {
+        return false;
+    }
+    queue.setReadyCallback([signal]()
+                           { signal->raise(); });
+    // Elements queued before the registration did not signal either.
+    if (queue.size() > 0)
+    {
+        signal->raise();
+    }
+    return true;
+}
+
+template<typename T>
+bool Reactor::removeQueue(Queue<T>& queue)
+{
+    if (!removeSignal(&queue))
+    {
+        return false;
+    }
+    queue.setReadyCallback(nullptr);
+    return true;
+}
+
+} // namespace ThreadSafe
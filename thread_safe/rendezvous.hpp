@@ -0,0 +1,332 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "cpu_topology.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Zero-capacity channel that hands an element directly from one thread to another.
+ *
+ * `put` blocks until a thread calls `take` and vice versa. Whichever side arrives second moves
+ * the element straight into (or out of) the slot of the waiting side and wakes only that thread,
+ * so an exchange costs one short critical section on the channel lock, no buffering and no
+ * broadcast. A waiting thread first spins on its slot, which catches the fast replies of a
+ * request/reply exchange without a sleep, and only then parks on the slot's own condition variable.
+ *
+ * Waiters on each side are served in FIFO order.
+ *
+ * @tparam T Type of the exchanged elements, must be move assignable.
+ */
+template<typename T>
+class Rendezvous
+{
+public:
+    static constexpr uint32_t WAIT_FOREVER = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t DEFAULT_SPIN_COUNT = 512;
+
+    /**
+     * @brief Constructor.
+     * @param spin_count Checks of the own slot before parking. Ignored with a `cpuBudget` of one CPU,
+     *                   where spinning only delays the thread that would complete the exchange.
+     */
+    explicit Rendezvous(const uint32_t spin_count = DEFAULT_SPIN_COUNT);
+
+    /**
+     * @brief Destructor that closes the channel.
+     */
+    ~Rendezvous();
+
+    // Make this class uncopyable
+    UNCOPYABLE(Rendezvous);
+
+    /**
+     * @brief Hand an element to a taker, waiting for one to arrive.
+     * @param elem The element to hand over.
+     * @param timeout_ms The maximum time to wait in milliseconds, 0 to succeed only if a taker is
+     *                   already waiting. Defaults to `WAIT_FOREVER`.
+     * @return `true` if a taker received the element, `false` on timeout or if the channel is closed.
+     */
+    bool put(T elem, const uint32_t timeout_ms = WAIT_FOREVER);
+
+    /**
+     * @brief Receive an element from a putter, waiting for one to arrive.
+     * @param elem Receives the element.
+     * @param timeout_ms The maximum time to wait in milliseconds, 0 to succeed only if a putter is
+     *                   already waiting. Defaults to `WAIT_FOREVER`.
+     * @return `true` if an element was received, `false` on timeout or if the channel is closed.
+     */
+    bool take(T& elem, const uint32_t timeout_ms = WAIT_FOREVER);
+
+    /**
+     * @brief Close the channel. Waiting and future calls return `false`.
+     */
+    void close();
+
+    /**
+     * @brief Check whether the channel is closed.
+     * @return `true` if closed, `false` otherwise.
+     */
+    bool isClosed() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint32_t WAITING = 0;
+    static constexpr uint32_t DONE = 1;
+    static constexpr uint32_t CLOSED = 2;
+
+    /**
+     * @brief A waiting thread, lives on its stack.
+     */
+    struct Slot
+    {
+        T* elem{nullptr};                 ///< Element to give or storage to receive into.
+        std::atomic<uint32_t> state{WAITING};
+        std::mutex lock{};                ///< Held by the counterpart while it fills the slot.
+        std::condition_variable condition{};
+        bool listed{false};               ///< Still waiting in a list, protected by the channel lock.
+        Slot* prev{nullptr};
+        Slot* next{nullptr};
+    };
+
+    /**
+     * @brief FIFO of waiting slots, protected by the channel lock.
+     */
+    struct List
+    {
+        Slot* head{nullptr};
+        Slot* tail{nullptr};
+
+        void push(Slot* slot);
+        Slot* popFront();
+        bool remove(Slot* slot); ///< `false` if the slot is no longer listed.
+    };
+
+    const uint32_t m_spin_count;
+    mutable std::mutex m_lock{};
+    List m_putters{};
+    List m_takers{};
+    std::atomic<bool> m_closed{false};
+
+    bool exchange(List& own, List& other, T& elem, const bool giving, const uint32_t timeout_ms);
+    bool await(List& own, Slot& slot, const uint32_t timeout_ms);
+    static void complete(Slot& slot, T& elem, const bool giving);
+};
+
+template<typename T>
+Rendezvous<T>::Rendezvous(const uint32_t spin_count)
+    : m_spin_count{cpuBudget() > 1 ? spin_count : 0}
+{
+}
+
+template<typename T>
+Rendezvous<T>::~Rendezvous()
+{
+    close();
+}
+
+template<typename T>
+bool Rendezvous<T>::put(T elem, const uint32_t timeout_ms)
+{
+    return exchange(m_putters, m_takers, elem, true, timeout_ms);
+}
+
+template<typename T>
+bool Rendezvous<T>::take(T& elem, const uint32_t timeout_ms)
+{
+    return exchange(m_takers, m_putters, elem, false, timeout_ms);
+}
+
+template<typename T>
+void Rendezvous<T>::close()
+{
+    Slot* waiters[2]{};
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        m_closed = true;
+        waiters[0] = m_putters.head;
+        waiters[1] = m_takers.head;
+        m_putters = List{};
+        m_takers = List{};
+        // Unlisted slots keep their links for the walk below, timed out owners no longer unlink them.
+        for (Slot* slot : waiters)
+        {
+            for (; slot != nullptr; slot = slot->next)
+            {
+                slot->listed = false;
+            }
+        }
+    }
+    for (Slot* slot : waiters)
+    {
+        while (slot != nullptr)
+        {
+            // Read the link first, the slot vanishes as soon as its owner sees the new state.
+            Slot* next{slot->next};
+            std::lock_guard<std::mutex> lock{slot->lock};
+            slot->state = CLOSED;
+            slot->condition.notify_one();
+            slot = next;
+        }
+    }
+}
+
+template<typename T>
+bool Rendezvous<T>::isClosed() const
+{
+    return m_closed;
+}
+
+template<typename T>
+bool Rendezvous<T>::exchange(List& own, List& other, T& elem, const bool giving, const uint32_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock{m_lock};
+    if (m_closed)
+    {
+        return false;
+    }
+    if (other.head != nullptr)
+    {
+        Slot* counterpart{other.popFront()};
+        lock.unlock();
+        complete(*counterpart, elem, giving);
+        return true;
+    }
+    if (timeout_ms == 0)
+    {
+        return false;
+    }
+    Slot slot{};
+    slot.elem = &elem;
+    own.push(&slot);
+    lock.unlock();
+    return await(own, slot, timeout_ms);
+}
+
+template<typename T>
+void Rendezvous<T>::complete(Slot& slot, T& elem, const bool giving)
+{
+    // Notify under the slot lock: the slot lives on the waiter's stack and vanishes once it returns.
+    std::lock_guard<std::mutex> lock{slot.lock};
+    if (giving)
+    {
+        *slot.elem = std::move(elem);
+    }
+    else
+    {
+        elem = std::move(*slot.elem);
+    }
+    slot.state.store(DONE, std::memory_order_release);
+    slot.condition.notify_one();
+}
+
+template<typename T>
+bool Rendezvous<T>::await(List& own, Slot& slot, const uint32_t timeout_ms)
+{
+    for (uint32_t spin{0}; spin < m_spin_count && slot.state.load(std::memory_order_acquire) == WAITING; ++spin)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    std::unique_lock<std::mutex> slot_lock{slot.lock};
+    const auto deadline{Clock::now() + std::chrono::milliseconds(timeout_ms)};
+    while (slot.state == WAITING)
+    {
+        if (timeout_ms == WAIT_FOREVER)
+        {
+            slot.condition.wait(slot_lock);
+        }
+        else if (slot.condition.wait_until(slot_lock, deadline) == std::cv_status::timeout)
+        {
+            break;
+        }
+    }
+    if (slot.state != WAITING)
+    {
+        return slot.state == DONE;
+    }
+
+    // Timed out. Withdraw unless a counterpart already claimed the slot and is about to fill it.
+    slot_lock.unlock();
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        if (own.remove(&slot))
+        {
+            return false;
+        }
+    }
+    slot_lock.lock();
+    slot.condition.wait(slot_lock, [&slot]() -> bool
+                        { return slot.state != WAITING; });
+    return slot.state == DONE;
+}
+
+template<typename T>
+void Rendezvous<T>::List::push(Slot* slot)
+{
+    slot->listed = true;
+    slot->prev = tail;
+    slot->next = nullptr;
+    if (tail != nullptr)
+    {
+        tail->next = slot;
+    }
+    else
+    {
+        head = slot;
+    }
+    tail = slot;
+}
+
+template<typename T>
+typename Rendezvous<T>::Slot* Rendezvous<T>::List::popFront()
+{
+    Slot* slot{head};
+    remove(slot);
+    return slot;
+}
+
+template<typename T>
+bool Rendezvous<T>::List::remove(Slot* slot)
+{
+    if (!slot->listed)
+    {
+        return false;
+    }
+    slot->listed = false;
+    if (slot->prev != nullptr)
+    {
+        slot->prev->next = slot->next;
+    }
+    else
+    {
+        head = slot->next;
+    }
+    if (slot->next != nullptr)
+    {
+        slot->next->prev = slot->prev;
+    }
+    else
+    {
+        tail = slot->prev;
+    }
+    slot->prev = nullptr;
+    slot->next = nullptr;
+    return true;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,438 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Blocking pool of expensive resources such as connections or buffers.
+ *
+ * Resources are created lazily by the factory, up to `max_size`, and handed out as RAII `Lease`s
+ * that return them to the pool when destroyed. Idle resources are reused LIFO, so the most
+ * recently used one, whose caches and connection state are warmest, is taken first, and the
+ * rarely used ones age out: idle resources older than `idle_timeout_ms` are destroyed, down to
+ * `min_idle`.
+ *
+ * When every resource is leased, callers wait in FIFO order. A returned resource is handed to the
+ * longest waiting caller directly, waking only that thread, and a new caller never overtakes a
+ * waiting one. A resource destroyed through `Lease::invalidate` lets the first waiter create a
+ * replacement.
+ *
+ * Resources are created, validated and destroyed outside the pool lock. The pool must outlive its
+ * leases and waiters.
+ *
+ * @tparam T Type of the pooled resources.
+ */
+template<typename T>
+class ResourcePool
+{
+public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+    using Validator = std::function<bool(T&)>;
+    static constexpr uint32_t WAIT_FOREVER = std::numeric_limits<uint32_t>::max();
+
+    class Lease;
+
+    /**
+     * @brief Settings for the pool.
+     */
+    struct Settings
+    {
+        std::size_t max_size{8};         ///< Maximum number of resources, leased and idle.
+        std::size_t min_idle{0};         ///< Idle resources kept by the eviction.
+        uint32_t idle_timeout_ms{60000}; ///< Idle time after which a resource is destroyed, 0 keeps them.
+        Validator validate{};            ///< Health check before an idle resource is reused, optional.
+    };
+
+    /**
+     * @brief Constructor.
+     * @param factory Creates a resource, returns `nullptr` on failure.
+     * @param settings Settings for the pool.
+     */
+    ResourcePool(Factory factory, const Settings& settings);
+
+    // Make this class uncopyable
+    UNCOPYABLE(ResourcePool);
+
+    /**
+     * @brief Lease a resource, reusing an idle one, creating one or waiting for one.
+     *
+     * An idle resource failing `Settings::validate` is destroyed and the next one is tried.
+     *
+     * @param timeout_ms The maximum time to wait in milliseconds.
+     * @return The lease, empty on timeout or if the factory failed.
+     */
+    Lease acquire(const uint32_t timeout_ms = WAIT_FOREVER);
+
+    /**
+     * @brief Destroy the resources idle for longer than `idle_timeout_ms`, keeping `min_idle`.
+     *
+     * Also done on every acquire and return, call it from a timer to shrink an unused pool.
+     *
+     * @return The number of destroyed resources.
+     */
+    std::size_t evictIdle();
+
+    /**
+     * @brief Number of resources, leased and idle.
+     * @return The number of resources.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Number of idle resources.
+     * @return The number of resources.
+     */
+    std::size_t idle() const;
+
+    /**
+     * @brief Number of callers waiting for a resource.
+     * @return The number of callers.
+     */
+    std::size_t waiting() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Resources = std::vector<std::unique_ptr<T>>;
+
+    struct Idle
+    {
+        std::unique_ptr<T> resource;
+        Clock::time_point since; ///< Time of the return to the pool.
+    };
+
+    /**
+     * @brief A caller blocked in `acquire`, on its own stack.
+     */
+    struct Waiter
+    {
+        std::condition_variable condition{};
+        std::unique_ptr<T> resource{}; ///< Handed over resource.
+        bool create{false};            ///< Allowed to create a resource instead.
+        bool ready{false};             ///< Served, protected by `m_lock`.
+    };
+
+    const Factory m_factory;
+    const Settings m_settings;
+    mutable std::mutex m_lock{};
+    std::deque<Idle> m_idle{};       ///< Idle resources, the most recently returned at the back.
+    std::deque<Waiter*> m_waiters{}; ///< Blocked callers, the longest waiting at the front.
+    std::size_t m_size{0};           ///< Resources leased, idle or being created.
+
+    /**
+     * @brief Hand a returned resource to the first waiter, or push it on the idle stack.
+     * @param resource The returned resource.
+     */
+    void giveBack(std::unique_ptr<T> resource);
+
+    /**
+     * @brief Account for a destroyed resource, letting the first waiter create a replacement.
+     */
+    void discard();
+
+    /**
+     * @brief Let the first waiter create a resource if below `max_size`, requires `m_lock`.
+     */
+    void grantCreateLocked();
+
+    /**
+     * @brief Move the expired idle resources out, to be destroyed after `m_lock` is released.
+     * @param now The current time.
+     * @param evicted Receives the expired resources.
+     * @return The number of expired resources.
+     */
+    std::size_t evictLocked(const Clock::time_point now, Resources& evicted);
+};
+
+/**
+ * @brief Exclusive use of a pooled resource, returned to the pool on destruction.
+ */
+template<typename T>
+class ResourcePool<T>::Lease
+{
+public:
+    Lease() = default;
+
+    Lease(Lease&& other) noexcept;
+
+    Lease& operator=(Lease&& other) noexcept;
+
+    /**
+     * @brief Destructor that returns the resource.
+     */
+    ~Lease();
+
+    /**
+     * @brief Check whether the lease holds a resource.
+     * @return `false` if `acquire` failed or the resource was returned.
+     */
+    explicit operator bool() const
+    {
+        return m_resource != nullptr;
+    }
+
+    T* get() const
+    {
+        return m_resource.get();
+    }
+
+    T& operator*() const
+    {
+        return *m_resource;
+    }
+
+    T* operator->() const
+    {
+        return m_resource.get();
+    }
+
+    /**
+     * @brief Return the resource to the pool before the lease is destroyed.
+     */
+    void release();
+
+    /**
+     * @brief Destroy the resource instead of returning it, e.g. after a connection broke.
+     */
+    void invalidate();
+
+private:
+    friend class ResourcePool;
+
+    Lease(ResourcePool* pool, std::unique_ptr<T> resource);
+
+    ResourcePool* m_pool{nullptr};
+    std::unique_ptr<T> m_resource{};
+};
+
+template<typename T>
+ResourcePool<T>::ResourcePool(Factory factory, const Settings& settings)
+    : m_factory{std::move(factory)}
+    , m_settings{settings}
+{
+}
+
+template<typename T>
+typename ResourcePool<T>::Lease ResourcePool<T>::acquire(const uint32_t timeout_ms)
+{
+    const auto deadline{Clock::now() + std::chrono::milliseconds(timeout_ms)};
+    while (true)
+    {
+        Resources evicted{};
+        std::unique_ptr<T> resource{};
+        bool create{false};
+        {
+            std::unique_lock<std::mutex> lock{m_lock};
+            evictLocked(Clock::now(), evicted);
+            // Waiting callers are served first, a new caller must not overtake them.
+            if (m_waiters.empty() && !m_idle.empty())
+            {
+                resource = std::move(m_idle.back().resource);
+                m_idle.pop_back();
+            }
+            else if (m_waiters.empty() && m_size < m_settings.max_size)
+            {
+                ++m_size;
+                create = true;
+            }
+            else
+            {
+                Waiter waiter{};
+                m_waiters.push_back(&waiter);
+                auto served = [&waiter]() -> bool
+                {
+                    return waiter.ready;
+                };
+                if (timeout_ms == WAIT_FOREVER)
+                {
+                    waiter.condition.wait(lock, served);
+                }
+                else if (!waiter.condition.wait_until(lock, deadline, served))
+                {
+                    m_waiters.erase(std::find(m_waiters.begin(), m_waiters.end(), &waiter));
+                    return Lease{};
+                }
+                resource = std::move(waiter.resource);
+                create = waiter.create;
+            }
+        }
+        if (create)
+        {
+            resource = m_factory();
+            if (!resource)
+            {
+                LOG_ERROR("Failed to create a pooled resource");
+                discard();
+                return Lease{};
+            }
+            return Lease{this, std::move(resource)};
+        }
+        if (!m_settings.validate || m_settings.validate(*resource))
+        {
+            return Lease{this, std::move(resource)};
+        }
+        resource.reset();
+        discard();
+    }
+}
+
+template<typename T>
+void ResourcePool<T>::giveBack(std::unique_ptr<T> resource)
+{
+    Resources evicted{};
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (!m_waiters.empty())
+    {
+        Waiter* waiter{m_waiters.front()};
+        m_waiters.pop_front();
+        waiter->resource = std::move(resource);
+        waiter->ready = true;
+        waiter->condition.notify_one();
+        return;
+    }
+    const auto now{Clock::now()};
+    m_idle.push_back(Idle{std::move(resource), now});
+    evictLocked(now, evicted);
+}
+
+template<typename T>
+void ResourcePool<T>::discard()
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    --m_size;
+    grantCreateLocked();
+}
+
+template<typename T>
+void ResourcePool<T>::grantCreateLocked()
+{
+    if (m_waiters.empty() || m_size >= m_settings.max_size)
+    {
+        return;
+    }
+    Waiter* waiter{m_waiters.front()};
+    m_waiters.pop_front();
+    ++m_size;
+    waiter->create = true;
+    waiter->ready = true;
+    waiter->condition.notify_one();
+}
+
+template<typename T>
+std::size_t ResourcePool<T>::evictLocked(const Clock::time_point now, Resources& evicted)
+{
+    if (m_settings.idle_timeout_ms == 0)
+    {
+        return 0;
+    }
+    const auto timeout{std::chrono::milliseconds(m_settings.idle_timeout_ms)};
+    std::size_t count{0};
+    // The front is the least recently returned, so the expired ones form a prefix.
+    while (m_idle.size() > m_settings.min_idle && now - m_idle.front().since >= timeout)
+    {
+        evicted.push_back(std::move(m_idle.front().resource));
+        m_idle.pop_front();
+        --m_size;
+        ++count;
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t ResourcePool<T>::evictIdle()
+{
+    Resources evicted{};
+    std::lock_guard<std::mutex> lock{m_lock};
+    return evictLocked(Clock::now(), evicted);
+}
+
+template<typename T>
+std::size_t ResourcePool<T>::size() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return m_size;
+}
+
+template<typename T>
+std::size_t ResourcePool<T>::idle() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return m_idle.size();
+}
+
+template<typename T>
+std::size_t ResourcePool<T>::waiting() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return m_waiters.size();
+}
+
+template<typename T>
+ResourcePool<T>::Lease::Lease(ResourcePool* pool, std::unique_ptr<T> resource)
+    : m_pool{pool}
+    , m_resource{std::move(resource)}
+{
+}
+
+template<typename T>
+ResourcePool<T>::Lease::Lease(Lease&& other) noexcept
+    : m_pool{other.m_pool}
+    , m_resource{std::move(other.m_resource)}
+{
+    other.m_pool = nullptr;
+}
+
+template<typename T>
+typename ResourcePool<T>::Lease& ResourcePool<T>::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_pool = other.m_pool;
+        m_resource = std::move(other.m_resource);
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+template<typename T>
+ResourcePool<T>::Lease::~Lease()
+{
+    release();
+}
+
+template<typename T>
+void ResourcePool<T>::Lease::release()
+{
+    if (m_resource)
+    {
+        m_pool->giveBack(std::move(m_resource));
+    }
+    m_pool = nullptr;
+}
+
+template<typename T>
+void ResourcePool<T>::Lease::invalidate()
+{
+    if (m_resource)
+    {
+        m_resource.reset();
+        m_pool->discard();
+    }
+    m_pool = nullptr;
+}
+
+} // namespace ThreadSafe
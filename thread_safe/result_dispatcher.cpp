@@ -0,0 +1,154 @@
+#include "result_dispatcher.hpp"
+
+#include "queue.hpp"
+
+#include <algorithm>
+
+namespace ThreadSafe
+{
+
+ResultDispatcher::ResultDispatcher(const Settings& settings)
+    : m_settings{settings}
+{
+    Queue<Delivery>::Settings queue_settings{};
+    queue_settings.discard = m_settings.discard;
+    queue_settings.control = Queue<Delivery>::Control::PUSH;
+    queue_settings.size = std::max<std::size_t>(1, m_settings.queue_size);
+    m_queue = std::make_unique<Queue<Delivery>>(queue_settings);
+    m_queue->openPush();
+    if (m_settings.discarded_callback)
+    {
+        m_queue->setDiscardedCallback([this](const Delivery&)
+                                      { m_settings.discarded_callback(); });
+    }
+    if (m_settings.executor)
+    {
+        return;
+    }
+    m_thread = std::make_unique<std::thread>([this]()
+                                             {
+                                                 if (m_settings.thread_init)
+                                                 {
+                                                     m_settings.thread_init();
+                                                 }
+                                                 Delivery delivery{};
+                                                 // Returns false once push is closed and every delivery ran.
+                                                 while (m_queue->pop(delivery))
+                                                 {
+                                                     delivery();
+                                                 } });
+}
+
+ResultDispatcher::~ResultDispatcher()
+{
+    stop();
+}
+
+bool ResultDispatcher::post(Delivery delivery)
+{
+    bool queued{false};
+    if (m_settings.discard == QueueDiscard::NO_DISCARD)
+    {
+        // Waits until there is room, so a failed push means the dispatcher was closed.
+        queued = m_queue->push(delivery);
+        if (!queued)
+        {
+            discarded();
+        }
+    }
+    else
+    {
+        // Never waits, so the lock tells a closed dispatcher apart from a delivery the discard
+        // policy already reported.
+        std::lock_guard<std::mutex> lock{m_close_lock};
+        if (m_closed)
+        {
+            discarded();
+            return false;
+        }
+        queued = m_queue->push(delivery);
+    }
+    schedule();
+    return queued;
+}
+
+void ResultDispatcher::close()
+{
+    std::lock_guard<std::mutex> lock{m_close_lock};
+    m_closed = true;
+    m_queue->closePush();
+}
+
+void ResultDispatcher::stop()
+{
+    if (m_stopped)
+    {
+        return;
+    }
+    m_stopped = true;
+    close();
+    if (m_thread)
+    {
+        m_thread->join();
+        m_thread.reset();
+        return;
+    }
+    schedule();
+    {
+        std::unique_lock<std::mutex> lock{m_tasks_lock};
+        m_tasks_condition.wait(lock, [this]() -> bool
+                               { return m_tasks == 0; });
+    }
+}
+
+void ResultDispatcher::discarded()
+{
+    if (m_settings.discarded_callback)
+    {
+        m_settings.discarded_callback();
+    }
+}
+
+void ResultDispatcher::schedule()
+{
+    if (!m_settings.executor || m_scheduled.exchange(true))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_tasks_lock};
+        ++m_tasks;
+    }
+    if (m_settings.executor([this]()
+                            { deliverQueued(); }))
+    {
+        return;
+    }
+    // Still holding the scheduled flag, so no task runs deliveries concurrently. Leaving them queued
+    // instead would block the next `post` on a full queue for good.
+    LOG_WARNING_RATE_LIMITED("The executor rejected a result delivery task, delivering inline");
+    deliverQueued();
+}
+
+void ResultDispatcher::deliverQueued()
+{
+    do
+    {
+        Delivery delivery{};
+        while (m_queue->pop(delivery, 0))
+        {
+            delivery();
+        }
+        m_scheduled = false;
+        // A delivery posted after the last pop but before the flag was cleared found the task
+        // still scheduled, so check again instead of leaving it in the queue.
+    } while (m_queue->size() > 0 && !m_scheduled.exchange(true));
+    // Last access to this object, stop() may release it once the lock is released.
+    std::lock_guard<std::mutex> lock{m_tasks_lock};
+    if (--m_tasks == 0)
+    {
+        m_tasks_condition.notify_all();
+    }
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,103 @@
+#pragma once
+#include "common/common.hpp"
+
+#include "queue_discard.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ThreadSafe
+{
+
+template<typename T>
+class Queue;
+
+/**
+ * @brief Asynchronous delivery of `Thread` results, shared by every result type.
+ *
+ * Each result is posted as a delivery, the result callback bound to the result, into a bounded
+ * queue. Deliveries run in order and one at a time, either on a dedicated thread or in tasks
+ * handed to an executor. Keeping the queue out of `Thread` spares its users the queue headers.
+ */
+class ResultDispatcher
+{
+public:
+    using Delivery = std::function<void()>;
+    using Executor = std::function<bool(std::function<void()>)>;
+
+    /**
+     * @brief Settings for the dispatcher.
+     */
+    struct Settings
+    {
+        std::size_t queue_size{1024};                   ///< Maximum number of queued deliveries.
+        QueueDiscard discard{QueueDiscard::NO_DISCARD}; ///< Policy when the queue is full.
+        Executor executor{};                            ///< Runs the deliveries instead of a dedicated thread, if set.
+        std::function<void()> thread_init{};            ///< Called first on the dedicated thread, optional.
+        std::function<void()> discarded_callback{};     ///< Called for every dropped delivery, optional.
+    };
+
+    /**
+     * @brief Constructor that starts the dedicated thread unless an executor is set.
+     * @param settings Settings for the dispatcher.
+     */
+    explicit ResultDispatcher(const Settings& settings);
+
+    /**
+     * @brief Destructor that runs the remaining deliveries.
+     */
+    ~ResultDispatcher();
+
+    // Make this class uncopyable
+    UNCOPYABLE(ResultDispatcher);
+
+    /**
+     * @brief Queue a delivery and make sure a delivery task is scheduled.
+     *
+     * With `QueueDiscard::NO_DISCARD` this blocks while the queue is full, until `close`. If the
+     * executor rejects the task, e.g. a pool already shut down, the queued deliveries are run by
+     * the calling thread instead, so a full queue never waits for a task that will not come.
+     *
+     * @param delivery The delivery to run.
+     * @return `true` if the delivery was queued, `false` if it was dropped or the dispatcher closed.
+     *         Either way a dropped delivery is reported to `discarded_callback` once.
+     */
+    bool post(Delivery delivery);
+
+    /**
+     * @brief Stop accepting deliveries and wake a `post` blocked on the full queue.
+     *
+     * Deliveries already queued are kept for `stop`. Safe to call concurrently with `post`.
+     */
+    void close();
+
+    /**
+     * @brief Close the dispatcher and run the queued deliveries.
+     *
+     * Waits for the delivery tasks on the executor. Must not be called concurrently with `post`.
+     */
+    void stop();
+
+private:
+    const Settings m_settings;
+    std::unique_ptr<Queue<Delivery>> m_queue;
+    std::unique_ptr<std::thread> m_thread{}; ///< Runs the deliveries without an executor.
+    std::atomic<bool> m_scheduled{false};    ///< A delivery task is queued on the executor.
+    std::mutex m_tasks_lock{};
+    std::condition_variable m_tasks_condition{}; ///< Signaled when no delivery task is left.
+    uint32_t m_tasks{0};                         ///< Delivery tasks not finished yet, protected by `m_tasks_lock`.
+    std::mutex m_close_lock{}; ///< Orders non-blocking posts against `close`.
+    bool m_closed{false};      ///< Protected by `m_close_lock`.
+    bool m_stopped{false};
+
+    void discarded();     ///< Report a delivery dropped because the dispatcher closed.
+    void schedule();      ///< Hand a delivery task to the executor, or run it inline if rejected.
+    void deliverQueued(); ///< Body of a delivery task.
+};
+
+} // namespace ThreadSafe
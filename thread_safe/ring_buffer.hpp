@@ -0,0 +1,337 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Double-ended FIFO storage in one contiguous block, not thread-safe.
+ *
+ * Unlike `std::deque`, which allocates and frees a block every few elements as the queue moves,
+ * the storage is only allocated when the size exceeds the capacity, which then doubles, and is
+ * only freed on destruction. After `reserve`, a buffer that stays within its capacity does not
+ * touch the heap at all.
+ *
+ * @tparam T Type of elements stored in the buffer.
+ */
+template<typename T>
+class RingBuffer
+{
+private:
+    template<bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using Owner = std::conditional_t<Const, const RingBuffer, RingBuffer>;
+
+        Iterator() = default;
+
+        Iterator(Owner* owner, const std::size_t index)
+            : m_owner{owner}
+            , m_index{index}
+        {
+        }
+
+        reference operator*() const
+        {
+            return (*m_owner)[m_index];
+        }
+
+        pointer operator->() const
+        {
+            return &(*m_owner)[m_index];
+        }
+
+        Iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous{*this};
+            ++m_index;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return m_owner == other.m_owner && m_index == other.m_index;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        Owner* m_owner{nullptr};
+        std::size_t m_index{0};
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    RingBuffer() = default;
+
+    ~RingBuffer();
+
+    // Make this class uncopyable
+    UNCOPYABLE(RingBuffer);
+
+    /**
+     * @brief Allocate storage for at least `capacity` elements.
+     * @param capacity The number of elements.
+     */
+    void reserve(const std::size_t capacity);
+
+    void push_back(const T& elem);
+    void push_back(T&& elem);
+    void pop_front();
+    void pop_back();
+
+    T& front();
+    T& back();
+    const T& front() const;
+    const T& back() const;
+
+    /**
+     * @brief Element at a position counted from the front.
+     * @param index The position, less than `size()`.
+     * @return The element.
+     */
+    T& operator[](const std::size_t index);
+    const T& operator[](const std::size_t index) const;
+
+    bool empty() const;
+    std::size_t size() const;
+    std::size_t capacity() const;
+
+    /**
+     * @brief Destroy every element, keeping the storage.
+     */
+    void clear();
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    T* m_data{nullptr};        ///< Storage for `m_capacity` elements.
+    std::size_t m_capacity{0}; ///< Number of slots in the storage.
+    std::size_t m_head{0};     ///< Slot of the front element.
+    std::size_t m_size{0};     ///< Number of elements.
+
+    std::size_t slot(const std::size_t index) const; ///< Storage slot of a position.
+    void grow(const std::size_t capacity);           ///< Move the elements into larger storage.
+
+    template<typename U>
+    void emplaceBack(U&& elem); ///< Shared body of `push_back`.
+};
+
+template<typename T>
+RingBuffer<T>::~RingBuffer()
+{
+    clear();
+    if (m_data != nullptr)
+    {
+        std::allocator<T>{}.deallocate(m_data, m_capacity);
+    }
+}
+
+template<typename T>
+void RingBuffer<T>::reserve(const std::size_t capacity)
+{
+    if (capacity > m_capacity)
+    {
+        grow(capacity);
+    }
+}
+
+template<typename T>
+void RingBuffer<T>::push_back(const T& elem)
+{
+    emplaceBack(elem);
+}
+
+template<typename T>
+void RingBuffer<T>::push_back(T&& elem)
+{
+    emplaceBack(std::move(elem));
+}
+
+template<typename T>
+template<typename U>
+void RingBuffer<T>::emplaceBack(U&& elem)
+{
+    if (m_size == m_capacity)
+    {
+        grow(m_capacity == 0 ? 16 : m_capacity * 2);
+    }
+    ::new (static_cast<void*>(m_data + slot(m_size))) T(std::forward<U>(elem));
+    ++m_size;
+}
+
+template<typename T>
+void RingBuffer<T>::pop_front()
+{
+    m_data[m_head].~T();
+    m_head = m_head + 1 == m_capacity ? 0 : m_head + 1;
+    --m_size;
+}
+
+template<typename T>
+void RingBuffer<T>::pop_back()
+{
+    m_data[slot(m_size - 1)].~T();
+    --m_size;
+}
+
+template<typename T>
+T& RingBuffer<T>::front()
+{
+    return m_data[m_head];
+}
+
+template<typename T>
+T& RingBuffer<T>::back()
+{
+    return m_data[slot(m_size - 1)];
+}
+
+template<typename T>
+const T& RingBuffer<T>::front() const
+{
+    return m_data[m_head];
+}
+
+template<typename T>
+const T& RingBuffer<T>::back() const
+{
+    return m_data[slot(m_size - 1)];
+}
+
+template<typename T>
+T& RingBuffer<T>::operator[](const std::size_t index)
+{
+    return m_data[slot(index)];
+}
+
+template<typename T>
+const T& RingBuffer<T>::operator[](const std::size_t index) const
+{
+    return m_data[slot(index)];
+}
+
+template<typename T>
+bool RingBuffer<T>::empty() const
+{
+    return m_size == 0;
+}
+
+template<typename T>
+std::size_t RingBuffer<T>::size() const
+{
+    return m_size;
+}
+
+template<typename T>
+std::size_t RingBuffer<T>::capacity() const
+{
+    return m_capacity;
+}
+
+template<typename T>
+void RingBuffer<T>::clear()
+{
+    while (m_size > 0)
+    {
+        pop_back();
+    }
+    m_head = 0;
+}
+
+template<typename T>
+typename RingBuffer<T>::iterator RingBuffer<T>::begin()
+{
+    return iterator{this, 0};
+}
+
+template<typename T>
+typename RingBuffer<T>::iterator RingBuffer<T>::end()
+{
+    return iterator{this, m_size};
+}
+
+template<typename T>
+typename RingBuffer<T>::const_iterator RingBuffer<T>::begin() const
+{
+    return const_iterator{this, 0};
+}
+
+template<typename T>
+typename RingBuffer<T>::const_iterator RingBuffer<T>::end() const
+{
+    return const_iterator{this, m_size};
+}
+
+template<typename T>
+std::size_t RingBuffer<T>::slot(const std::size_t index) const
+{
+    const std::size_t position{m_head + index};
+    return position < m_capacity ? position : position - m_capacity;
+}
+
+template<typename T>
+void RingBuffer<T>::grow(const std::size_t capacity)
+{
+    std::allocator<T> allocator{};
+    T* data{allocator.allocate(capacity)};
+    std::size_t moved{0};
+    try
+    {
+        for (; moved < m_size; ++moved)
+        {
+            ::new (static_cast<void*>(data + moved)) T(std::move_if_noexcept((*this)[moved]));
+        }
+    }
+    catch (...)
+    {
+        // Only a throwing copy gets here, the old elements are intact and still owned by us.
+        for (std::size_t i{0}; i < moved; ++i)
+        {
+            data[i].~T();
+        }
+        allocator.deallocate(data, capacity);
+        throw;
+    }
+    for (std::size_t i{0}; i < m_size; ++i)
+    {
+        (*this)[i].~T();
+    }
+    if (m_data != nullptr)
+    {
+        allocator.deallocate(m_data, m_capacity);
+    }
+    m_data = data;
+    m_capacity = capacity;
+    m_head = 0;
+}
+
+} // namespace ThreadSafe
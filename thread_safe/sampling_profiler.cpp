@@ -0,0 +1,372 @@
+#include "sampling_profiler.hpp"
+
+#include "thread_registry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <time.h>
+#include <ucontext.h>
+#endif
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+#ifdef __linux__
+/**
+ * @brief Sample buffer of one thread, written only by the signal handler running on that thread.
+ */
+struct Slot
+{
+    char name[ThreadRegistry::NAME_SIZE]{};
+    int64_t tid{0};
+    int32_t cpu_clock{-1};
+    uintptr_t stack_low{0};
+    uintptr_t stack_high{0};
+    timer_t timer{};
+    bool armed{false};
+    std::unique_ptr<uintptr_t[]> frames{}; ///< `samples_per_thread` rows of `max_frames`, innermost first.
+    std::unique_ptr<uint32_t[]> depths{};  ///< Frames per sample.
+    std::atomic<std::size_t> count{0};     ///< Published samples.
+    std::atomic<uint64_t> dropped{0};      ///< Samples lost to a full buffer.
+};
+
+// Serializes `start`, `stop` and the readers of the buffers.
+std::mutex g_lock{};
+SamplingProfiler::Settings g_settings{};
+std::unique_ptr<Slot[]> g_slots{};
+std::size_t g_num_of_slots{0};
+std::atomic<bool> g_active{false};
+// Handlers currently running, the buffers must outlive them.
+std::atomic<uint32_t> g_in_handler{0};
+int g_installed_signal{0};
+
+bool readable(const uintptr_t fp, const Slot& slot, const uintptr_t low)
+{
+    return fp >= low && fp % sizeof(uintptr_t) == 0 && fp <= slot.stack_high - 2 * sizeof(uintptr_t);
+}
+
+void record(Slot& slot, const ucontext_t* context)
+{
+    const std::size_t index{slot.count.load(std::memory_order_relaxed)};
+    if (index >= g_settings.samples_per_thread)
+    {
+        slot.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+#if defined(__x86_64__)
+    const auto pc{static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RIP])};
+    auto fp{static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RBP])};
+    const auto sp{static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RSP])};
+#elif defined(__aarch64__)
+    const auto pc{static_cast<uintptr_t>(context->uc_mcontext.pc)};
+    auto fp{static_cast<uintptr_t>(context->uc_mcontext.regs[29])};
+    const auto sp{static_cast<uintptr_t>(context->uc_mcontext.sp)};
+#else
+    const uintptr_t pc{0};
+    uintptr_t fp{0};
+    const uintptr_t sp{0};
+#endif
+    uintptr_t* frames{slot.frames.get() + index * g_settings.max_frames};
+    uint32_t depth{0};
+    if (pc != 0 && g_settings.max_frames > 0)
+    {
+        frames[depth++] = pc;
+    }
+    // Each frame holds the caller's frame pointer, then the return address. Without known stack
+    // bounds the chain cannot be walked safely, so the sample keeps the interrupted pc only.
+    uintptr_t low{std::max(sp, slot.stack_low)};
+    while (slot.stack_high != 0 && depth < g_settings.max_frames && readable(fp, slot, low))
+    {
+        const uintptr_t* record{reinterpret_cast<const uintptr_t*>(fp)};
+        const uintptr_t next{record[0]};
+        const uintptr_t return_address{record[1]};
+        if (return_address == 0)
+        {
+            break;
+        }
+        frames[depth++] = return_address;
+        if (next <= fp)
+        {
+            break;
+        }
+        low = fp + 2 * sizeof(uintptr_t);
+        fp = next;
+    }
+    slot.depths[index] = depth;
+    slot.count.store(index + 1, std::memory_order_release);
+}
+
+void onSample(const int signal, siginfo_t* info, void* context)
+{
+    UNUSED_PARAMETER(signal);
+    const int saved_errno{errno};
+    g_in_handler.fetch_add(1);
+    // Only our timers, a SIGPROF sent with `kill` carries no slot.
+    if (g_active.load() && info != nullptr && info->si_code == SI_TIMER)
+    {
+        const auto index{static_cast<std::size_t>(info->si_value.sival_int)};
+        if (index < g_num_of_slots)
+        {
+            record(g_slots[index], static_cast<const ucontext_t*>(context));
+        }
+    }
+    g_in_handler.fetch_sub(1);
+    errno = saved_errno;
+}
+
+bool installHandler(const int signal)
+{
+    if (g_installed_signal == signal)
+    {
+        return true;
+    }
+    struct sigaction action
+    {
+    };
+    action.sa_sigaction = onSample;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    ::sigemptyset(&action.sa_mask);
+    if (::sigaction(signal, &action, nullptr) != 0)
+    {
+        return false;
+    }
+    g_installed_signal = signal;
+    return true;
+}
+
+bool arm(Slot& slot, const std::size_t index)
+{
+    sigevent event{};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = g_settings.signal;
+    event.sigev_value.sival_int = static_cast<int>(index);
+#ifdef sigev_notify_thread_id
+    event.sigev_notify_thread_id = static_cast<pid_t>(slot.tid);
+#else
+    event._sigev_un._tid = static_cast<pid_t>(slot.tid);
+#endif
+    if (::timer_create(static_cast<clockid_t>(slot.cpu_clock), &event, &slot.timer) != 0)
+    {
+        return false;
+    }
+    itimerspec spec{};
+    spec.it_interval.tv_sec = g_settings.interval_us / 1000000;
+    spec.it_interval.tv_nsec = static_cast<long>(g_settings.interval_us % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    if (::timer_settime(slot.timer, 0, &spec, nullptr) != 0)
+    {
+        ::timer_delete(slot.timer);
+        return false;
+    }
+    slot.armed = true;
+    return true;
+}
+
+void disarm()
+{
+    for (std::size_t i{0}; i < g_num_of_slots; ++i)
+    {
+        if (g_slots[i].armed)
+        {
+            ::timer_delete(g_slots[i].timer);
+            g_slots[i].armed = false;
+        }
+    }
+}
+
+std::string symbolize(const uintptr_t address, const bool return_address)
+{
+    // A return address may already belong to the next function, the call is one byte before.
+    const uintptr_t lookup{return_address ? address - 1 : address};
+    std::ostringstream stream;
+    Dl_info info{};
+    if (::dladdr(reinterpret_cast<void*>(lookup), &info) != 0)
+    {
+        if (info.dli_sname != nullptr)
+        {
+            int status{0};
+            char* demangled{abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status)};
+            std::string name{status == 0 && demangled != nullptr ? demangled : info.dli_sname};
+            std::free(demangled);
+            // The semicolon separates frames in the folded format.
+            std::replace(name.begin(), name.end(), ';', ':');
+            return name;
+        }
+        if (info.dli_fname != nullptr)
+        {
+            const char* module{std::strrchr(info.dli_fname, '/')};
+            stream << (module != nullptr ? module + 1 : info.dli_fname) << "+0x" << std::hex
+                   << (lookup - reinterpret_cast<uintptr_t>(info.dli_fbase));
+            return stream.str();
+        }
+    }
+    stream << "0x" << std::hex << lookup;
+    return stream.str();
+}
+#endif
+
+} // namespace
+
+bool SamplingProfiler::start(const Settings& settings)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{g_lock};
+    if (g_active.load())
+    {
+        LOG_WARNING("The sampling profiler is already running!")
+        return false;
+    }
+    if (settings.interval_us == 0 || settings.max_frames == 0 || settings.samples_per_thread == 0)
+    {
+        LOG_ERROR("Invalid sampling profiler settings")
+        return false;
+    }
+    // A handler interrupted before the previous `stop` may still write to the old buffers.
+    while (g_in_handler.load() > 0)
+    {
+        std::this_thread::yield();
+    }
+    g_settings = settings;
+    if (!installHandler(g_settings.signal))
+    {
+        LOG_ERROR("Cannot install the sampling profiler signal handler")
+        return false;
+    }
+    g_slots = std::make_unique<Slot[]>(ThreadRegistry::MAX_THREADS);
+    g_num_of_slots = 0;
+    ThreadRegistry::forEach([](const ThreadRegistry::Entry& entry)
+                            {
+                                if (entry.cpu_clock == -1 || entry.tid == 0 || g_num_of_slots == ThreadRegistry::MAX_THREADS)
+                                {
+                                    return;
+                                }
+                                Slot& slot{g_slots[g_num_of_slots++]};
+                                std::memcpy(slot.name, entry.name, sizeof(slot.name));
+                                slot.stack_low = entry.stack_low;
+                                slot.stack_high = entry.stack_high;
+                                slot.cpu_clock = entry.cpu_clock;
+                                slot.tid = entry.tid;
+                                slot.frames = std::make_unique<uintptr_t[]>(g_settings.samples_per_thread * g_settings.max_frames);
+                                slot.depths = std::make_unique<uint32_t[]>(g_settings.samples_per_thread); });
+    // The buffers are complete before any handler can see them.
+    g_active.store(true);
+    std::size_t armed{0};
+    for (std::size_t i{0}; i < g_num_of_slots; ++i)
+    {
+        if (arm(g_slots[i], i))
+        {
+            ++armed;
+        }
+    }
+    LOG_INFO("Sampling profiler started on " << armed << " threads every " << g_settings.interval_us << " us of CPU time")
+    return true;
+#else
+    UNUSED_PARAMETER(settings);
+    LOG_WARNING("The sampling profiler is not supported on this platform.")
+    return false;
+#endif
+}
+
+void SamplingProfiler::stop()
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{g_lock};
+    if (!g_active.exchange(false))
+    {
+        return;
+    }
+    disarm();
+#endif
+}
+
+bool SamplingProfiler::running()
+{
+#ifdef __linux__
+    return g_active.load();
+#else
+    return false;
+#endif
+}
+
+std::string SamplingProfiler::folded()
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{g_lock};
+    std::map<std::string, uint64_t> stacks;
+    std::unordered_map<uintptr_t, std::string> symbols;
+    for (std::size_t i{0}; i < g_num_of_slots; ++i)
+    {
+        const Slot& slot{g_slots[i]};
+        const std::size_t count{slot.count.load(std::memory_order_acquire)};
+        for (std::size_t sample{0}; sample < count; ++sample)
+        {
+            const uintptr_t* frames{slot.frames.get() + sample * g_settings.max_frames};
+            std::string stack{slot.name};
+            for (uint32_t depth{slot.depths[sample]}; depth-- > 0;)
+            {
+                // Only the innermost frame is the interrupted pc, the others are return addresses.
+                auto it{symbols.find(frames[depth])};
+                if (it == symbols.end())
+                {
+                    it = symbols.emplace(frames[depth], symbolize(frames[depth], depth > 0)).first;
+                }
+                stack += ';';
+                stack += it->second;
+            }
+            ++stacks[stack];
+        }
+    }
+    std::string result;
+    for (const auto& stack : stacks)
+    {
+        result += stack.first + ' ' + std::to_string(stack.second) + '\n';
+    }
+    return result;
+#else
+    return std::string{};
+#endif
+}
+
+uint64_t SamplingProfiler::samples()
+{
+    uint64_t total{0};
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{g_lock};
+    for (std::size_t i{0}; i < g_num_of_slots; ++i)
+    {
+        total += g_slots[i].count.load(std::memory_order_acquire);
+    }
+#endif
+    return total;
+}
+
+uint64_t SamplingProfiler::dropped()
+{
+    uint64_t total{0};
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock{g_lock};
+    for (std::size_t i{0}; i < g_num_of_slots; ++i)
+    {
+        total += g_slots[i].dropped.load(std::memory_order_relaxed);
+    }
+#endif
+    return total;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,90 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <string>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief In-process sampling CPU profiler for the threads in the `ThreadRegistry`.
+ *
+ * `start` arms one timer per registered thread on that thread's CPU-time clock, so a thread is
+ * sampled in proportion to the CPU it uses and idle threads cost nothing. Each expiry delivers a
+ * signal to the thread itself, whose handler walks the frame-pointer chain of the interrupted
+ * context within the thread's stack bounds and appends the stack to a buffer of that thread. The
+ * buffers are preallocated and written without locks; a full buffer drops further samples.
+ *
+ * `folded` aggregates the samples into the folded-stack format read by flame graph tools, one
+ * line per distinct stack, rooted at the thread name. Frames are symbolized with `dladdr`, so
+ * functions of an executable only show by name when it exports its symbols (`-rdynamic`),
+ * otherwise as module and offset. Code built without frame pointers yields truncated stacks.
+ *
+ * Only threads registered when `start` is called are sampled. Linux only.
+ */
+class SamplingProfiler
+{
+public:
+#ifdef __linux__
+    static constexpr int DEFAULT_SIGNAL = SIGPROF;
+#else
+    static constexpr int DEFAULT_SIGNAL = 0;
+#endif
+
+    /**
+     * @brief Settings for the profiler.
+     */
+    struct Settings
+    {
+        uint32_t interval_us{10000};          ///< CPU time of a thread between two of its samples.
+        uint32_t max_frames{64};              ///< Maximum frames per sample, deeper stacks are cut.
+        std::size_t samples_per_thread{4096}; ///< Capacity of each thread's sample buffer.
+        int signal{DEFAULT_SIGNAL};           ///< Signal used for sampling.
+    };
+
+    /**
+     * @brief Discard the previous samples and start sampling every registered thread.
+     * @param settings Settings for the profiler.
+     * @return `true` if started, `false` if already running or unsupported on this platform.
+     */
+    static bool start(const Settings& settings);
+
+    /**
+     * @brief Stop sampling. The samples stay available to `folded`.
+     *
+     * The signal handler stays installed and ignores late signals, so a sample still in flight
+     * cannot hit the default action of the signal.
+     */
+    static void stop();
+
+    /**
+     * @brief Check whether the profiler is sampling.
+     * @return `true` between `start` and `stop`.
+     */
+    static bool running();
+
+    /**
+     * @brief Aggregate the samples into folded stacks.
+     *
+     * Each line is `<thread name>;<outermost frame>;...;<innermost frame> <count>`.
+     *
+     * @return The folded stacks, empty without samples.
+     */
+    static std::string folded();
+
+    /**
+     * @brief Number of samples recorded since `start`.
+     * @return The number of samples.
+     */
+    static uint64_t samples();
+
+    /**
+     * @brief Number of samples dropped because a thread's buffer was full.
+     * @return The number of samples.
+     */
+    static uint64_t dropped();
+};
+
+} // namespace ThreadSafe
@@ -0,0 +1,482 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "epoch.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Concurrent ordered map based on a lazy (optimistic) skip list.
+ *
+ * Lookups and range scans are lock-free: they never take a lock and never block writers.
+ * Inserts and erases lock only the predecessors of the affected node, so writers touching
+ * different parts of the key space proceed in parallel. Unlinked nodes are reclaimed through
+ * `Epoch`, which keeps them alive for readers that may still be traversing them.
+ *
+ * Values are immutable once inserted; replace an entry by erasing and inserting it again.
+ * Scans are weakly consistent: they observe every entry present for the whole scan and may or
+ * may not observe entries inserted or erased concurrently.
+ *
+ * @tparam Key Type of the keys.
+ * @tparam Value Type of the mapped values.
+ * @tparam Compare Strict weak ordering of the keys.
+ */
+template<typename Key, typename Value, typename Compare = std::less<Key>>
+class SkipListMap
+{
+public:
+    using Visitor = std::function<void(const Key&, const Value&)>;
+    static constexpr int32_t MAX_LEVEL = 24;
+
+    /**
+     * @brief Constructor.
+     * @param compare Comparator used to order the keys.
+     */
+    explicit SkipListMap(const Compare& compare = Compare{});
+
+    /**
+     * @brief Destructor. Must not run concurrently with any other member function.
+     */
+    ~SkipListMap();
+
+    // Make this class uncopyable
+    UNCOPYABLE(SkipListMap);
+
+    /**
+     * @brief Insert a new entry.
+     * @param key The key to insert.
+     * @param value The value mapped to the key.
+     * @return `true` if the entry was inserted, `false` if the key already exists.
+     */
+    bool insert(const Key& key, const Value& value);
+
+    /**
+     * @brief Erase an entry.
+     * @param key The key to erase.
+     * @return `true` if the entry was erased, `false` if the key does not exist.
+     */
+    bool erase(const Key& key);
+
+    /**
+     * @brief Look up a key without taking any lock.
+     * @param key The key to look up.
+     * @return A copy of the mapped value, or `std::nullopt` if the key does not exist.
+     */
+    std::optional<Value> find(const Key& key) const;
+
+    /**
+     * @brief Check whether a key exists without taking any lock.
+     * @param key The key to look up.
+     * @return `true` if the key exists, `false` otherwise.
+     */
+    bool contains(const Key& key) const;
+
+    /**
+     * @brief Visit every entry in key order without taking any lock.
+     * @param visitor Callable invoked with each key and value.
+     */
+    void forEach(const Visitor& visitor) const;
+
+    /**
+     * @brief Visit the entries with keys in `[from, to)` in key order without taking any lock.
+     * @param from Inclusive lower bound.
+     * @param to Exclusive upper bound.
+     * @param visitor Callable invoked with each key and value.
+     */
+    void forEachInRange(const Key& from, const Key& to, const Visitor& visitor) const;
+
+    /**
+     * @brief Number of entries. Exact only when no writer is running.
+     * @return The number of entries.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Check whether the map has no entries.
+     * @return `true` if empty, `false` otherwise.
+     */
+    bool empty() const;
+
+private:
+    struct Node
+    {
+        explicit Node(int32_t level)
+            : top_level{level}
+            , next{new std::atomic<Node*>[static_cast<std::size_t>(level)]}
+        {
+            for (int32_t i{0}; i < level; ++i)
+            {
+                next[i] = nullptr;
+            }
+        }
+        virtual ~Node() = default;
+
+        const int32_t top_level;                     ///< Number of levels this node is linked on.
+        std::unique_ptr<std::atomic<Node*>[]> next;  ///< Successor on each level.
+        std::atomic<bool> marked{false};             ///< Logically deleted.
+        std::atomic<bool> fully_linked{false};       ///< Linked on every level.
+        std::mutex lock{};                           ///< Guards structural changes of the successors.
+    };
+
+    struct DataNode : Node
+    {
+        DataNode(const Key& k, const Value& v, int32_t level)
+            : Node{level}
+            , key{k}
+            , value{v}
+        {
+        }
+
+        const Key key;
+        const Value value;
+    };
+
+    using Nodes = std::array<Node*, MAX_LEVEL>;
+
+    const Compare m_compare;
+    Node* const m_head;
+    std::atomic<std::size_t> m_size{0};
+
+    bool keyLess(const Node* node, const Key& key) const;                   ///< node < key, head is -inf, nullptr is +inf.
+    bool keyEqual(const Node* node, const Key& key) const;                  ///< node == key.
+    int32_t findNode(const Key& key, Nodes& preds, Nodes& succs) const;     ///< Level the key was found on, -1 if absent.
+    const DataNode* lowerBound(const Key& key) const;                       ///< First live node not less than key.
+    static bool isLive(const Node* node);                                   ///< Fully linked and not marked.
+    static int32_t randomLevel();                                           ///< Geometric level distribution.
+    static void unlockPreds(const Nodes& preds, int32_t highest_locked);    ///< Unlock every distinct locked pred.
+    void visit(const DataNode* node, const Key* to, const Visitor& visitor) const;
+};
+
+template<typename Key, typename Value, typename Compare>
+SkipListMap<Key, Value, Compare>::SkipListMap(const Compare& compare)
+    : m_compare{compare}
+    , m_head{new Node{MAX_LEVEL}}
+{
+    m_head->fully_linked = true;
+}
+
+template<typename Key, typename Value, typename Compare>
+SkipListMap<Key, Value, Compare>::~SkipListMap()
+{
+    Node* node{m_head->next[0].load()};
+    while (node != nullptr)
+    {
+        Node* next{node->next[0].load()};
+        delete node;
+        node = next;
+    }
+    delete m_head;
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::keyLess(const Node* node, const Key& key) const
+{
+    if (node == m_head)
+    {
+        return true;
+    }
+    if (node == nullptr)
+    {
+        return false;
+    }
+    return m_compare(static_cast<const DataNode*>(node)->key, key);
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::keyEqual(const Node* node, const Key& key) const
+{
+    if (node == nullptr || node == m_head)
+    {
+        return false;
+    }
+    const Key& node_key{static_cast<const DataNode*>(node)->key};
+    return !m_compare(node_key, key) && !m_compare(key, node_key);
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::isLive(const Node* node)
+{
+    return node->fully_linked && !node->marked;
+}
+
+template<typename Key, typename Value, typename Compare>
+int32_t SkipListMap<Key, Value, Compare>::randomLevel()
+{
+    thread_local uint64_t state{std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1};
+    // xorshift64, each additional level with probability 1/2
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int32_t level{1};
+    uint64_t bits{state};
+    while ((bits & 1) != 0 && level < MAX_LEVEL)
+    {
+        ++level;
+        bits >>= 1;
+    }
+    return level;
+}
+
+template<typename Key, typename Value, typename Compare>
+int32_t SkipListMap<Key, Value, Compare>::findNode(const Key& key, Nodes& preds, Nodes& succs) const
+{
+    int32_t found{-1};
+    Node* pred{m_head};
+    for (int32_t level{MAX_LEVEL - 1}; level >= 0; --level)
+    {
+        Node* curr{pred->next[level].load()};
+        while (keyLess(curr, key))
+        {
+            pred = curr;
+            curr = pred->next[level].load();
+        }
+        if (found == -1 && keyEqual(curr, key))
+        {
+            found = level;
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return found;
+}
+
+template<typename Key, typename Value, typename Compare>
+void SkipListMap<Key, Value, Compare>::unlockPreds(const Nodes& preds, int32_t highest_locked)
+{
+    Node* prev{nullptr};
+    for (int32_t level{0}; level <= highest_locked; ++level)
+    {
+        if (preds[level] != prev)
+        {
+            preds[level]->lock.unlock();
+            prev = preds[level];
+        }
+    }
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::insert(const Key& key, const Value& value)
+{
+    const int32_t top_level{randomLevel()};
+    Nodes preds{};
+    Nodes succs{};
+    Epoch::Guard guard{};
+    while (true)
+    {
+        const int32_t found{findNode(key, preds, succs)};
+        if (found != -1)
+        {
+            Node* node{succs[found]};
+            if (!node->marked)
+            {
+                // Another insert owns the key, wait until it is visible to keep insert linearizable.
+                while (!node->fully_linked)
+                {
+                    std::this_thread::yield();
+                }
+                return false;
+            }
+            continue;
+        }
+
+        int32_t highest_locked{-1};
+        bool valid{true};
+        Node* prev{nullptr};
+        for (int32_t level{0}; valid && level < top_level; ++level)
+        {
+            Node* pred{preds[level]};
+            Node* succ{succs[level]};
+            if (pred != prev)
+            {
+                pred->lock.lock();
+                prev = pred;
+            }
+            highest_locked = level;
+            valid = !pred->marked && (succ == nullptr || !succ->marked) && pred->next[level] == succ;
+        }
+        if (!valid)
+        {
+            unlockPreds(preds, highest_locked);
+            continue;
+        }
+
+        DataNode* node{new DataNode{key, value, top_level}};
+        for (int32_t level{0}; level < top_level; ++level)
+        {
+            node->next[level] = succs[level];
+        }
+        for (int32_t level{0}; level < top_level; ++level)
+        {
+            preds[level]->next[level] = node;
+        }
+        node->fully_linked = true;
+        unlockPreds(preds, highest_locked);
+        ++m_size;
+        return true;
+    }
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::erase(const Key& key)
+{
+    Node* victim{nullptr};
+    bool is_marked{false};
+    int32_t top_level{-1};
+    Nodes preds{};
+    Nodes succs{};
+    Epoch::Guard guard{};
+    while (true)
+    {
+        const int32_t found{findNode(key, preds, succs)};
+        if (!is_marked)
+        {
+            if (found == -1)
+            {
+                return false;
+            }
+            Node* candidate{succs[found]};
+            // Only the search that found the node on its top level may delete it.
+            if (!candidate->fully_linked || candidate->marked || candidate->top_level - 1 != found)
+            {
+                return false;
+            }
+            victim = candidate;
+            top_level = victim->top_level;
+            victim->lock.lock();
+            if (victim->marked)
+            {
+                victim->lock.unlock();
+                return false;
+            }
+            victim->marked = true;
+            is_marked = true;
+        }
+
+        int32_t highest_locked{-1};
+        bool valid{true};
+        Node* prev{nullptr};
+        for (int32_t level{0}; valid && level < top_level; ++level)
+        {
+            Node* pred{preds[level]};
+            if (pred != prev)
+            {
+                pred->lock.lock();
+                prev = pred;
+            }
+            highest_locked = level;
+            valid = !pred->marked && pred->next[level] == victim;
+        }
+        if (!valid)
+        {
+            unlockPreds(preds, highest_locked);
+            continue;
+        }
+
+        for (int32_t level{top_level - 1}; level >= 0; --level)
+        {
+            preds[level]->next[level] = victim->next[level].load();
+        }
+        victim->lock.unlock();
+        unlockPreds(preds, highest_locked);
+        --m_size;
+        Epoch::retire(static_cast<DataNode*>(victim));
+        return true;
+    }
+}
+
+template<typename Key, typename Value, typename Compare>
+std::optional<Value> SkipListMap<Key, Value, Compare>::find(const Key& key) const
+{
+    Epoch::Guard guard{};
+    const DataNode* node{lowerBound(key)};
+    if (node == nullptr || !keyEqual(node, key))
+    {
+        return std::nullopt;
+    }
+    return node->value;
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::contains(const Key& key) const
+{
+    Epoch::Guard guard{};
+    const DataNode* node{lowerBound(key)};
+    return node != nullptr && keyEqual(node, key);
+}
+
+template<typename Key, typename Value, typename Compare>
+const typename SkipListMap<Key, Value, Compare>::DataNode* SkipListMap<Key, Value, Compare>::lowerBound(const Key& key) const
+{
+    Node* pred{m_head};
+    Node* curr{nullptr};
+    for (int32_t level{MAX_LEVEL - 1}; level >= 0; --level)
+    {
+        curr = pred->next[level].load();
+        while (keyLess(curr, key))
+        {
+            pred = curr;
+            curr = pred->next[level].load();
+        }
+    }
+    while (curr != nullptr && !isLive(curr))
+    {
+        curr = curr->next[0].load();
+    }
+    return static_cast<const DataNode*>(curr);
+}
+
+template<typename Key, typename Value, typename Compare>
+void SkipListMap<Key, Value, Compare>::visit(const DataNode* node, const Key* to, const Visitor& visitor) const
+{
+    while (node != nullptr)
+    {
+        if (to != nullptr && !m_compare(node->key, *to))
+        {
+            return;
+        }
+        if (isLive(node))
+        {
+            visitor(node->key, node->value);
+        }
+        node = static_cast<const DataNode*>(node->next[0].load());
+    }
+}
+
+template<typename Key, typename Value, typename Compare>
+void SkipListMap<Key, Value, Compare>::forEach(const Visitor& visitor) const
+{
+    Epoch::Guard guard{};
+    visit(static_cast<const DataNode*>(m_head->next[0].load()), nullptr, visitor);
+}
+
+template<typename Key, typename Value, typename Compare>
+void SkipListMap<Key, Value, Compare>::forEachInRange(const Key& from, const Key& to, const Visitor& visitor) const
+{
+    Epoch::Guard guard{};
+    visit(lowerBound(from), &to, visitor);
+}
+
+template<typename Key, typename Value, typename Compare>
+std::size_t SkipListMap<Key, Value, Compare>::size() const
+{
+    return m_size;
+}
+
+template<typename Key, typename Value, typename Compare>
+bool SkipListMap<Key, Value, Compare>::empty() const
+{
+    return m_size == 0;
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "common/common.hpp"
+
+#include "event_count.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Bounded single-producer multi-consumer ring for fan-out from one dispatcher thread.
+ *
+ * The producer never takes a lock: publishing an element is a store into its slot plus a sequence
+ * update, and waking consumers costs a single atomic load unless some consumer is parked.
+ * Consumers claim a slot with one CAS on the shared head index. Blocking on empty (and, for the
+ * producer, on full) goes through an `EventCount`, so no thread sleeps on a shared mutex.
+ *
+ * Only one thread may call `push`/`tryPush`; any number of threads may call `pop`/`tryPop`.
+ *
+ * @tparam T Type of elements stored in the queue, must be default constructible.
+ */
+template<typename T>
+class SpmcQueue
+{
+public:
+    static constexpr uint32_t WAIT_FOREVER = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @brief Constructor.
+     * @param capacity Maximum number of elements, rounded up to a power of two of at least 2.
+     */
+    explicit SpmcQueue(std::size_t capacity);
+
+    // Make this class uncopyable
+    UNCOPYABLE(SpmcQueue);
+
+    /**
+     * @brief Publish an element without blocking. Producer thread only.
+     * @param elem The element to publish.
+     * @return `true` if published, `false` if the ring is full or closed.
+     */
+    bool tryPush(T elem);
+
+    /**
+     * @brief Publish an element, blocking while the ring is full. Producer thread only.
+     * @param elem The element to publish.
+     * @param timeout_ms The maximum time to wait in milliseconds. Defaults to `WAIT_FOREVER`.
+     * @return `true` if published, `false` on timeout or if the ring is closed.
+     */
+    bool push(T elem, const uint32_t timeout_ms = WAIT_FOREVER);
+
+    /**
+     * @brief Claim the oldest element without blocking.
+     * @param elem Reference where the element will be stored.
+     * @return `true` if an element was claimed, `false` if the ring is empty.
+     */
+    bool tryPop(T& elem);
+
+    /**
+     * @brief Claim the oldest element, blocking while the ring is empty.
+     * @param elem Reference where the element will be stored.
+     * @param timeout_ms The maximum time to wait in milliseconds. Defaults to `WAIT_FOREVER`.
+     * @return `true` if an element was claimed, `false` on timeout or if the ring is closed and drained.
+     */
+    bool pop(T& elem, const uint32_t timeout_ms = WAIT_FOREVER);
+
+    /**
+     * @brief Reject further pushes and wake every blocked thread. Remaining elements can still be popped.
+     */
+    void close();
+
+    /**
+     * @brief Check whether `close` has been called.
+     * @return `true` if closed, `false` otherwise.
+     */
+    bool isClosed() const;
+
+    /**
+     * @brief Approximate number of elements in the ring.
+     * @return The number of elements.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Capacity of the ring after rounding.
+     * @return The capacity.
+     */
+    std::size_t capacity() const;
+
+private:
+    static constexpr std::size_t CACHE_LINE{64};
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0}; ///< Equals position + 1 when full, position + capacity when free again.
+        T value{};
+    };
+
+    const std::size_t m_capacity;
+    const std::size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(CACHE_LINE) std::atomic<uint64_t> m_head{0}; ///< Next position to claim, shared by consumers.
+    alignas(CACHE_LINE) std::atomic<uint64_t> m_tail{0}; ///< Next position to publish, written by the producer only.
+    alignas(CACHE_LINE) std::atomic<bool> m_closed{false};
+    EventCount m_not_empty{};
+    EventCount m_not_full{};
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value);
+    static EventCount::Clock::time_point deadlineFor(const uint32_t timeout_ms);
+};
+
+template<typename T>
+SpmcQueue<T>::SpmcQueue(std::size_t capacity)
+    : m_capacity{roundUpToPowerOfTwo(capacity)}
+    , m_mask{m_capacity - 1}
+    , m_slots{new Slot[m_capacity]}
+{
+    for (std::size_t i{0}; i < m_capacity; ++i)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+std::size_t SpmcQueue<T>::roundUpToPowerOfTwo(std::size_t value)
+{
+    // A single slot cannot tell "published" from "free again" apart, the sequences would collide.
+    std::size_t result{2};
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+template<typename T>
+EventCount::Clock::time_point SpmcQueue<T>::deadlineFor(const uint32_t timeout_ms)
+{
+    if (timeout_ms == WAIT_FOREVER)
+    {
+        return EventCount::Clock::time_point::max();
+    }
+    return EventCount::Clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+template<typename T>
+bool SpmcQueue<T>::tryPush(T elem)
+{
+    if (m_closed.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    const uint64_t pos{m_tail.load(std::memory_order_relaxed)};
+    Slot& slot{m_slots[pos & m_mask]};
+    if (slot.sequence.load(std::memory_order_acquire) != pos)
+    {
+        return false; // A consumer has not released this slot yet.
+    }
+    slot.value = std::move(elem);
+    slot.sequence.store(pos + 1, std::memory_order_release);
+    m_tail.store(pos + 1, std::memory_order_relaxed);
+    m_not_empty.notify();
+    return true;
+}
+
+template<typename T>
+bool SpmcQueue<T>::push(T elem, const uint32_t timeout_ms)
+{
+    const auto deadline{deadlineFor(timeout_ms)};
+    while (true)
+    {
+        const uint64_t pos{m_tail.load(std::memory_order_relaxed)};
+        auto slot_free = [this, pos]() -> bool
+        {
+            return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) == pos;
+        };
+        if (m_closed || slot_free())
+        {
+            return tryPush(std::move(elem));
+        }
+        const EventCount::Key key{m_not_full.prepareWait()};
+        if (m_closed || slot_free())
+        {
+            m_not_full.cancelWait();
+            continue;
+        }
+        if (!m_not_full.waitUntil(key, deadline) && EventCount::Clock::now() >= deadline)
+        {
+            return tryPush(std::move(elem));
+        }
+    }
+}
+
+template<typename T>
+bool SpmcQueue<T>::tryPop(T& elem)
+{
+    uint64_t pos{m_head.load(std::memory_order_relaxed)};
+    while (true)
+    {
+        Slot& slot{m_slots[pos & m_mask]};
+        const uint64_t sequence{slot.sequence.load(std::memory_order_acquire)};
+        const auto diff{static_cast<int64_t>(sequence - (pos + 1))};
+        if (diff == 0)
+        {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                elem = std::move(slot.value);
+                slot.sequence.store(pos + m_capacity, std::memory_order_release);
+                m_not_full.notify();
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false; // Not published yet: the ring is empty.
+        }
+        else
+        {
+            pos = m_head.load(std::memory_order_relaxed); // Claimed by another consumer, catch up.
+        }
+    }
+}
+
+template<typename T>
+bool SpmcQueue<T>::pop(T& elem, const uint32_t timeout_ms)
+{
+    const auto deadline{deadlineFor(timeout_ms)};
+    while (true)
+    {
+        if (tryPop(elem))
+        {
+            return true;
+        }
+        if (m_closed)
+        {
+            return tryPop(elem);
+        }
+        const EventCount::Key key{m_not_empty.prepareWait()};
+        if (tryPop(elem))
+        {
+            m_not_empty.cancelWait();
+            return true;
+        }
+        if (m_closed)
+        {
+            m_not_empty.cancelWait();
+            return tryPop(elem);
+        }
+        if (!m_not_empty.waitUntil(key, deadline) && EventCount::Clock::now() >= deadline)
+        {
+            return tryPop(elem);
+        }
+    }
+}
+
+template<typename T>
+void SpmcQueue<T>::close()
+{
+    m_closed = true;
+    m_not_empty.notifyAll();
+    m_not_full.notifyAll();
+}
+
+template<typename T>
+bool SpmcQueue<T>::isClosed() const
+{
+    return m_closed;
+}
+
+template<typename T>
+std::size_t SpmcQueue<T>::size() const
+{
+    const uint64_t head{m_head.load(std::memory_order_relaxed)};
+    const uint64_t tail{m_tail.load(std::memory_order_relaxed)};
+    return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+}
+
+template<typename T>
+std::size_t SpmcQueue<T>::capacity() const
+{
+    return m_capacity;
+}
+
+} // namespace ThreadSafe
@@ -45,7 +45,7 @@ void setNaitiveThreadPriority(ThreadPriority priority, const std::thread::native
 #ifdef _WIN32
     if (!::SetThreadPriority(native_handle, default_prioritys.at(priority)))
     {
-        LOG_WARNING("Failed to set thread priority");
+        LOG_WARNING_RATE_LIMITED("Failed to set thread priority");
     }
 #elif __linux__
 
@@ -53,9 +53,18 @@ void setNaitiveThreadPriority(ThreadPriority priority, const std::thread::native
     sch_params.sched_priority = default_prioritys.at(priority);
     if (::pthread_setschedparam(native_handle, SCHED_FIFO, &sch_params))
     {
-        LOG_WARNING("Failed to set thread priority");
+        LOG_WARNING_RATE_LIMITED("Failed to set thread priority");
     }
 #endif
 }
 
+std::thread::native_handle_type currentNativeThreadHandle()
+{
+#ifdef _WIN32
+    return ::GetCurrentThread();
+#elif __linux__
+    return ::pthread_self();
+#endif
+}
+
 } // namespace ThreadSafe
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 #include "common/common.hpp"
 
+#include "result_dispatcher.hpp"
+#include "thread_registry.hpp"
+
 #include <atomic>
 #include <cstdint>
 #include <functional>
@@ -39,6 +42,12 @@ const NativeThreadPrioritys& defaultNativeThreadPrioritys();
  */
 void setNaitiveThreadPriority(ThreadPriority priority, const std::thread::native_handle_type native_handle);
 
+/**
+ * @brief Returns the native handle of the calling thread.
+ * @return The native handle, usable with `setNaitiveThreadPriority`.
+ */
+std::thread::native_handle_type currentNativeThreadHandle();
+
 /**
  * @brief Enum to represent whether the thread should run once or in a loop.
  */
@@ -48,6 +57,15 @@ enum class RunMode : uint8_t
     LOOP = 1
 };
 
+/**
+ * @brief Enum to represent how results reach the result callback.
+ */
+enum class ResultDelivery : uint8_t
+{
+    INLINE = 0, ///< Called by the thread itself after every run of the function.
+    ASYNC = 1   ///< Queued and called by a delivery thread or an executor.
+};
+
 /**
  * @brief A thread class that supports custom functions, thread priorities, and callbacks.
  * @tparam Return The return type of the function.
@@ -61,6 +79,23 @@ public:
     using ResultCallback = std::function<void(const Return&)>;
     using Func = std::function<Return(ArgTypes...)>;
     using Pred = std::function<bool()>;
+    using Executor = ResultDispatcher::Executor;
+
+    /**
+     * @brief Settings for delivering results to the result callback.
+     *
+     * With `ResultDelivery::ASYNC` every result is pushed to an internal bounded queue, so the
+     * thread only pays for the push and the callback runs at its own pace elsewhere. When the
+     * queue is full, `discard` decides: `NO_DISCARD` blocks the thread until there is room
+     * (backpressure), the other policies drop a result and keep the thread running.
+     */
+    struct ResultSettings
+    {
+        ResultDelivery delivery{ResultDelivery::INLINE}; ///< Inline or asynchronous delivery.
+        std::size_t queue_size{1024};                    ///< Maximum number of queued results.
+        QueueDiscard discard{QueueDiscard::NO_DISCARD};  ///< Policy when the queue is full.
+        Executor executor{};                             ///< Runs the delivery instead of a dedicated thread, if set.
+    };
 
     /**
      * @brief Constructor for creating a thread with a function and its arguments.
@@ -141,6 +176,30 @@ public:
         m_result_callback = result_callback;
     }
 
+    /**
+     * @brief Sets the result callback function together with how results are delivered to it.
+     *
+     * For asynchronous delivery without an executor, a dedicated thread runs the callback. With an
+     * executor, the results are handed over in delivery tasks that run one at a time, so the
+     * callback is never called concurrently and sees results in order. The executor returns
+     * whether it accepted a task and must run every task it accepted. Results of a rejected task
+     * go with the next one, or are delivered by `stop` at the latest.
+     *
+     * @param result_callback The callback function to handle the result.
+     * @param settings How the results are delivered.
+     * @return `true` if set, `false` if the thread is running.
+     */
+    bool setResultCallback(ResultCallback result_callback, const ResultSettings& settings)
+    {
+        if (m_thread_ptr != nullptr)
+        {
+            return false;
+        }
+        m_result_callback = result_callback;
+        m_result_settings = settings;
+        return true;
+    }
+
     /**
      * @brief Sets the exit callback function to be executed when the thread exits.
      * @param exit_callback The callback function.
@@ -172,13 +231,20 @@ public:
         {
             m_loop = true;
         }
+        startDelivery();
         m_thread_ptr = std::make_unique<std::thread>([this]()
                                                      { run(); });
         LOG_INFO("Successfully started the thread");
         return true;
     }
+
     /**
      * @brief Stops the thread's loop.
+     *
+     * Results still queued for asynchronous delivery are delivered before this returns. The
+     * delivery queue is closed first, so a result the loop produces while stopping is counted by
+     * `discardedResults` instead of blocking the join on a full queue.
+     *
      * @return `true` if stop sucessfull, `false` otherwise.
      */
     bool stop()
@@ -189,11 +255,16 @@ public:
             LOG_WARNING("The thread has already stopped!")
             return false;
         }
+        if (m_dispatcher)
+        {
+            m_dispatcher->close();
+        }
         if (m_thread_ptr->joinable())
         {
             m_thread_ptr->join();
         }
         m_thread_ptr.reset();
+        stopDelivery();
         LOG_INFO("Successfully stopped the thread");
         return true;
     }
@@ -207,6 +278,15 @@ public:
         return m_name;
     }
 
+    /**
+     * @brief Number of results dropped by the discard policy of asynchronous delivery.
+     * @return The number of results.
+     */
+    uint64_t discardedResults() const
+    {
+        return m_discarded_results;
+    }
+
 private:
     const std::string m_name;
     Func m_func{nullptr};
@@ -218,21 +298,28 @@ private:
     ResultCallback m_result_callback{};
     Callback m_exit_callback{};
     std::unique_ptr<std::thread> m_thread_ptr{};
+    ResultSettings m_result_settings{};
+    std::unique_ptr<ResultDispatcher> m_dispatcher{}; ///< Delivers the results asynchronously.
+    std::atomic<uint64_t> m_discarded_results{0};
 
     /**
      * @brief The main loop function that runs the thread.
      */
     void run()
     {
-        setNaitiveThreadPriority(m_priority, m_thread_ptr->native_handle());
+        // m_thread_ptr may not be assigned yet when the new thread gets here, use our own handle.
+        setNaitiveThreadPriority(m_priority, currentNativeThreadHandle());
+        ThreadRegistry::Entry* registry_entry{ThreadRegistry::enter(m_name)};
         startCallback();
 
         do
         {
             call();
+            ThreadRegistry::beat(registry_entry);
         } while (isContinue());
 
         exitCallback();
+        ThreadRegistry::leave(registry_entry);
     }
 
     /**
@@ -241,12 +328,54 @@ private:
     void call()
     {
         Return result{std::apply(m_func, m_args)};
-        if (m_result_callback)
+        if (m_dispatcher)
+        {
+            m_dispatcher->post([this, result]()
+                               { m_result_callback(result); });
+        }
+        else if (m_result_callback)
         {
             m_result_callback(result);
         };
     }
 
+    /**
+     * @brief Creates the dispatcher for asynchronous delivery.
+     */
+    void startDelivery()
+    {
+        if (m_result_settings.delivery != ResultDelivery::ASYNC || !m_result_callback)
+        {
+            return;
+        }
+        ResultDispatcher::Settings settings{};
+        settings.queue_size = m_result_settings.queue_size;
+        settings.discard = m_result_settings.discard;
+        settings.executor = m_result_settings.executor;
+        settings.thread_init = [priority = m_priority]()
+        {
+            setNaitiveThreadPriority(priority, currentNativeThreadHandle());
+        };
+        settings.discarded_callback = [this]()
+        {
+            ++m_discarded_results;
+        };
+        m_dispatcher = std::make_unique<ResultDispatcher>(settings);
+    }
+
+    /**
+     * @brief Delivers the remaining results and releases the dispatcher.
+     */
+    void stopDelivery()
+    {
+        if (!m_dispatcher)
+        {
+            return;
+        }
+        m_dispatcher->stop();
+        m_dispatcher.reset();
+    }
+
     /**
      * @brief Function to execute the start callback.
      */
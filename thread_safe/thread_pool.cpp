@@ -0,0 +1,317 @@
+#include "thread_pool.hpp"
+
+#include <string>
+
+namespace ThreadSafe
+{
+
+namespace
+{
+
+std::size_t levelOf(const ThreadPriority priority)
+{
+    return static_cast<std::size_t>(priority);
+}
+
+// Pool and level served by the calling worker thread, `NUM_OF_PRIORITY` for shared workers.
+thread_local const ThreadPool* t_pool{nullptr};
+thread_local std::size_t t_level{ThreadPool::NUM_OF_PRIORITY};
+
+} // namespace
+
+ThreadPool::ThreadPool(const Settings& settings)
+    : m_settings{settings}
+{
+    for (const auto& dedicated : m_settings.dedicated)
+    {
+        m_dedicated_count[levelOf(dedicated.first)] = dedicated.second;
+    }
+    for (std::size_t i{0}; i < m_settings.workers; ++i)
+    {
+        startWorker("pool-worker-" + std::to_string(i), m_settings.worker_priority, NUM_OF_PRIORITY, [this]() -> bool
+                    { return workShared(); });
+    }
+    for (const auto& dedicated : m_settings.dedicated)
+    {
+        const std::size_t level{levelOf(dedicated.first)};
+        for (std::size_t i{0}; i < dedicated.second; ++i)
+        {
+            startWorker("pool-level" + std::to_string(level) + "-" + std::to_string(i), dedicated.first, level, [this, level]() -> bool
+                        { return workDedicated(level); });
+        }
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    shutdown();
+}
+
+void ThreadPool::startWorker(const std::string& name, const ThreadPriority priority, const std::size_t level, std::function<bool()> func)
+{
+    auto worker{std::make_unique<Worker>(name, priority)};
+    worker->invoke(std::move(func));
+    worker->setStartCallback([this, level]()
+                             {
+                                 t_pool = this;
+                                 t_level = level;
+                             });
+    worker->setPredicate([this]() -> bool
+                         { return !m_stopping; });
+    worker->start(RunMode::LOOP);
+    m_workers.push_back(std::move(worker));
+}
+
+bool ThreadPool::serves(const ThreadPriority priority) const
+{
+    return m_settings.workers > 0 || m_dedicated_count[levelOf(priority)] > 0;
+}
+
+bool ThreadPool::enqueue(const ThreadPriority priority, Task task, std::shared_ptr<Job> job)
+{
+    const std::size_t level{levelOf(priority)};
+    bool helpers{false};
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        if (!m_accepting)
+        {
+            LOG_ERROR("Cannot submit because the pool is shut down");
+            return false;
+        }
+        if (!serves(priority))
+        {
+            LOG_ERROR("Cannot submit because no worker serves priority level " << level);
+            return false;
+        }
+        m_ready[level].push_back(Entry{std::move(task), Clock::now(), std::move(job)});
+        ++m_pending;
+        helpers = m_helpers > 0;
+    }
+    if (m_dedicated_count[level] > 0)
+    {
+        m_dedicated_condition[level].notify_one();
+    }
+    if (m_settings.workers > 0)
+    {
+        m_shared_condition.notify_one();
+    }
+    if (helpers)
+    {
+        // A waiting worker may serve this level, it re-checks with `hasWork`.
+        m_helper_condition.notify_all();
+    }
+    return true;
+}
+
+bool ThreadPool::selectShared(Entry& entry)
+{
+    const auto now{Clock::now()};
+    std::size_t best_level{NUM_OF_PRIORITY};
+    uint64_t best_effective{0};
+    for (std::size_t level{NUM_OF_PRIORITY}; level-- > 0;)
+    {
+        if (m_ready[level].empty())
+        {
+            continue;
+        }
+        uint64_t effective{level};
+        if (m_settings.aging_ms > 0)
+        {
+            const auto waited{std::chrono::duration_cast<std::chrono::milliseconds>(now - m_ready[level].front().enqueued).count()};
+            effective += static_cast<uint64_t>(waited) / m_settings.aging_ms;
+        }
+        // Strictly greater: on a tie the higher base level, visited first, keeps the slot.
+        if (best_level == NUM_OF_PRIORITY || effective > best_effective)
+        {
+            best_level = level;
+            best_effective = effective;
+        }
+    }
+    if (best_level == NUM_OF_PRIORITY)
+    {
+        return false;
+    }
+    entry = std::move(m_ready[best_level].front());
+    m_ready[best_level].pop_front();
+    return true;
+}
+
+bool ThreadPool::hasWork(const std::size_t level) const
+{
+    if (level < NUM_OF_PRIORITY)
+    {
+        return !m_ready[level].empty();
+    }
+    return std::any_of(m_ready.begin(), m_ready.end(), [](const std::deque<Entry>& ready)
+                       { return !ready.empty(); });
+}
+
+bool ThreadPool::select(const std::size_t level, Entry& entry)
+{
+    if (level == NUM_OF_PRIORITY)
+    {
+        return selectShared(entry);
+    }
+    if (m_ready[level].empty())
+    {
+        return false;
+    }
+    entry = std::move(m_ready[level].front());
+    m_ready[level].pop_front();
+    return true;
+}
+
+bool ThreadPool::claim(const Job& job, Entry& entry)
+{
+    std::deque<Entry>& ready{m_ready[job.level]};
+    auto it{std::find_if(ready.begin(), ready.end(), [&job](const Entry& queued)
+                         { return queued.job.get() == &job; })};
+    if (it == ready.end())
+    {
+        return false;
+    }
+    entry = std::move(*it);
+    ready.erase(it);
+    return true;
+}
+
+bool ThreadPool::isWorker() const
+{
+    return t_pool == this;
+}
+
+bool ThreadPool::help(const Job& job, const Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock{m_lock};
+    while (!job.done)
+    {
+        // The awaited task first, it is what unblocks this worker.
+        Entry entry{};
+        if (claim(job, entry) || select(t_level, entry))
+        {
+            lock.unlock();
+            runTask(entry);
+            lock.lock();
+            continue;
+        }
+        if (Clock::now() >= deadline)
+        {
+            return false;
+        }
+        auto pred = [this, &job]() -> bool
+        {
+            return job.done || hasWork(t_level);
+        };
+        ++m_helpers;
+        if (deadline == Clock::time_point::max())
+        {
+            m_helper_condition.wait(lock, pred);
+        }
+        else
+        {
+            m_helper_condition.wait_until(lock, deadline, pred);
+        }
+        --m_helpers;
+    }
+    return true;
+}
+
+bool ThreadPool::workShared()
+{
+    Entry entry{};
+    {
+        std::unique_lock<std::mutex> lock{m_lock};
+        m_shared_condition.wait(lock, [this]() -> bool
+                                { return m_stopping || hasWork(NUM_OF_PRIORITY); });
+        if (!selectShared(entry))
+        {
+            return false;
+        }
+    }
+    runTask(entry);
+    return true;
+}
+
+bool ThreadPool::workDedicated(const std::size_t level)
+{
+    Entry entry{};
+    {
+        std::unique_lock<std::mutex> lock{m_lock};
+        m_dedicated_condition[level].wait(lock, [this, level]() -> bool
+                                          { return m_stopping || hasWork(level); });
+        if (!select(level, entry))
+        {
+            return false;
+        }
+    }
+    runTask(entry);
+    return true;
+}
+
+void ThreadPool::runTask(Entry& entry)
+{
+    entry.task();
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (entry.job)
+    {
+        entry.job->done = true;
+    }
+    if (m_helpers > 0)
+    {
+        m_helper_condition.notify_all();
+    }
+    if (--m_pending == 0)
+    {
+        m_drained_condition.notify_all();
+    }
+}
+
+void ThreadPool::shutdown()
+{
+    if (isWorker())
+    {
+        // The drain would wait for the calling task itself.
+        LOG_ERROR("Cannot shut down the pool from one of its workers");
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock{m_lock};
+        if (m_shutting_down)
+        {
+            // Another caller drains and joins, wait until it is done.
+            m_drained_condition.wait(lock, [this]() -> bool
+                                     { return m_joined; });
+            return;
+        }
+        m_shutting_down = true;
+        m_accepting = false;
+        m_drained_condition.wait(lock, [this]() -> bool
+                                 { return m_pending == 0; });
+        m_stopping = true;
+    }
+    m_shared_condition.notify_all();
+    for (auto& condition : m_dedicated_condition)
+    {
+        condition.notify_all();
+    }
+    // Destroying a worker stops and joins it.
+    m_workers.clear();
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        m_joined = true;
+    }
+    m_drained_condition.notify_all();
+}
+
+std::size_t ThreadPool::pending() const
+{
+    std::lock_guard<std::mutex> lock{m_lock};
+    return m_pending;
+}
+
+std::size_t ThreadPool::workers() const
+{
+    return m_workers.size();
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,315 @@
+#pragma once
+#include "common/common.hpp"
+
+#include "cpu_topology.hpp"
+#include "thread.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Thread pool that schedules tasks by `ThreadPriority`.
+ *
+ * Every priority level has its own ready queue. Workers always pick the highest non-empty level,
+ * except that a waiting task is treated as one level higher for every `aging_ms` it has waited,
+ * so low-priority work cannot starve under a constant stream of high-priority tasks.
+ *
+ * Besides the shared workers, which serve every level, a level can be given dedicated workers.
+ * Dedicated workers only run tasks of their level, and their OS thread priority is set to that
+ * level through `setNaitiveThreadPriority`.
+ *
+ * Tasks submitted with `fork` return a `TaskFuture`. A worker waiting on one does not block while
+ * there is work: it runs the awaited task itself if no worker has picked it yet, otherwise it runs
+ * other queued tasks it serves until the result is ready. Fork/join parallelism inside the pool
+ * therefore neither deadlocks nor leaves cores idle.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t NUM_OF_PRIORITY = 6;
+    static constexpr uint32_t WAIT_FOREVER = std::numeric_limits<uint32_t>::max();
+
+    template<typename R>
+    class TaskFuture;
+
+    /**
+     * @brief Settings for the pool.
+     */
+    struct Settings
+    {
+        std::size_t workers{cpuBudget()};                       ///< Shared workers serving every level.
+        ThreadPriority worker_priority{ThreadPriority::NORMAL}; ///< OS priority of the shared workers.
+        uint32_t aging_ms{100};                                 ///< Wait per level of promotion, 0 disables aging.
+        std::map<ThreadPriority, std::size_t> dedicated{};      ///< Dedicated workers per level.
+    };
+
+    /**
+     * @brief Constructor that starts every worker.
+     * @param settings Settings to configure the pool.
+     */
+    explicit ThreadPool(const Settings& settings);
+
+    /**
+     * @brief Destructor that runs the remaining tasks and joins every worker.
+     */
+    ~ThreadPool();
+
+    // Make this class uncopyable
+    UNCOPYABLE(ThreadPool);
+
+    /**
+     * @brief Submit a task with a priority.
+     *
+     * @tparam F The callable type.
+     * @tparam Args The types of the arguments.
+     * @param priority The priority level of the task.
+     * @param func The callable to run.
+     * @param args The arguments passed to the callable.
+     * @return A future for the result. The future is invalid if the pool is shut down or no
+     *         worker serves `priority`.
+     */
+    template<typename F, typename... Args>
+    auto submit(const ThreadPriority priority, F&& func, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+    /**
+     * @brief Submit a task whose result may be awaited from inside the pool.
+     *
+     * Like `submit`, but waiting on the returned future from a worker of this pool helps with
+     * queued tasks instead of blocking the worker.
+     *
+     * @tparam F The callable type.
+     * @tparam Args The types of the arguments.
+     * @param priority The priority level of the task.
+     * @param func The callable to run.
+     * @param args The arguments passed to the callable.
+     * @return A future for the result. The future is invalid if the pool is shut down or no
+     *         worker serves `priority`.
+     */
+    template<typename F, typename... Args>
+    auto fork(const ThreadPriority priority, F&& func, Args&&... args)
+        -> TaskFuture<typename std::invoke_result<F, Args...>::type>;
+
+    /**
+     * @brief Stop accepting tasks, run every task already submitted, then join the workers.
+     *
+     * Concurrent and later calls wait for the first one to finish. Calls from a worker of the
+     * pool are rejected, as the drain would wait for the calling task.
+     */
+    void shutdown();
+
+    /**
+     * @brief Number of tasks submitted but not finished yet.
+     * @return The number of tasks.
+     */
+    std::size_t pending() const;
+
+    /**
+     * @brief Number of worker threads, shared and dedicated.
+     * @return The number of workers.
+     */
+    std::size_t workers() const;
+
+private:
+    struct Job
+    {
+        std::size_t level; ///< Ready queue of the task.
+        bool done{false};  ///< The task has finished, protected by `m_lock`.
+    };
+
+    struct Entry
+    {
+        Task task;
+        Clock::time_point enqueued;
+        std::shared_ptr<Job> job; ///< Set for tasks submitted with `fork`.
+    };
+
+    using Worker = Thread<bool>;
+
+    const Settings m_settings;
+    std::array<std::deque<Entry>, NUM_OF_PRIORITY> m_ready{};                     ///< Ready queue per level.
+    std::array<std::size_t, NUM_OF_PRIORITY> m_dedicated_count{};                 ///< Dedicated workers per level.
+    mutable std::mutex m_lock{};                                                  ///< Protects the ready queues.
+    std::condition_variable m_shared_condition{};                                 ///< Wakes shared workers.
+    std::array<std::condition_variable, NUM_OF_PRIORITY> m_dedicated_condition{}; ///< Wakes dedicated workers per level.
+    std::condition_variable m_drained_condition{};                                ///< Signaled when pending reaches zero.
+    std::condition_variable m_helper_condition{};                                 ///< Wakes workers waiting on a `TaskFuture`.
+    std::size_t m_pending{0};                                                     ///< Queued and running tasks.
+    std::size_t m_helpers{0};                                                     ///< Workers blocked in `help`.
+    bool m_accepting{true};                                                       ///< Submissions allowed.
+    bool m_shutting_down{false};                                                  ///< `shutdown` was called.
+    bool m_joined{false};                                                         ///< `shutdown` joined the workers.
+    std::atomic<bool> m_stopping{false};                                          ///< Workers must return.
+    std::vector<std::unique_ptr<Worker>> m_workers{};
+
+    bool enqueue(const ThreadPriority priority, Task task, std::shared_ptr<Job> job = nullptr); ///< Queue a task and wake a worker.
+    bool serves(const ThreadPriority priority) const;                                           ///< At least one worker runs this level.
+    bool workShared();                                                                          ///< One iteration of a shared worker.
+    bool workDedicated(const std::size_t level);                                                ///< One iteration of a dedicated worker.
+    bool hasWork(const std::size_t level) const;                                                ///< A task for a worker of this level is queued, with the lock held.
+    bool select(const std::size_t level, Entry& entry);                                         ///< Pick the next task for a worker of this level, with the lock held.
+    bool selectShared(Entry& entry);                                                            ///< Pick by priority and aging, with the lock held.
+    bool claim(const Job& job, Entry& entry);                                                   ///< Take a queued job out of its ready queue, with the lock held.
+    bool help(const Job& job, const Clock::time_point deadline);                                ///< Run tasks until the job is done or the deadline passes.
+    bool isWorker() const;                                                                      ///< The calling thread is a worker of this pool.
+    void runTask(Entry& entry);                                                                 ///< Run a task and update the pending count.
+    void startWorker(const std::string& name, const ThreadPriority priority, const std::size_t level, std::function<bool()> func);
+};
+
+template<typename F, typename... Args>
+auto ThreadPool::submit(const ThreadPriority priority, F&& func, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>
+{
+    using Return = typename std::invoke_result<F, Args...>::type;
+    auto task{std::make_shared<std::packaged_task<Return()>>(
+        [func = std::forward<F>(func), args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> Return
+        { return std::apply(std::move(func), std::move(args)); })};
+    std::future<Return> future{task->get_future()};
+    if (!enqueue(priority, [task]()
+                 { (*task)(); }))
+    {
+        return std::future<Return>{};
+    }
+    return future;
+}
+
+/**
+ * @brief Future for a task submitted with `ThreadPool::fork`.
+ *
+ * Waiting from a worker of the pool runs the awaited task, or other queued tasks the worker
+ * serves, until the result is ready. A task run this way may take longer than the remaining
+ * timeout of `waitFor`. Waiting from any other thread blocks like `std::future`.
+ *
+ * @tparam R The result type.
+ */
+template<typename R>
+class ThreadPool::TaskFuture
+{
+public:
+    TaskFuture() = default;
+
+    /**
+     * @brief Check whether the future refers to a task.
+     * @return `true` if it does, `false` if the submission failed or `get` was called.
+     */
+    bool valid() const;
+
+    /**
+     * @brief Wait until the result is ready.
+     */
+    void wait();
+
+    /**
+     * @brief Wait until the result is ready or the timeout expires.
+     * @param timeout_ms The maximum time to wait in milliseconds.
+     * @return `true` if the result is ready, `false` on timeout or if the future is invalid.
+     */
+    bool waitFor(const uint32_t timeout_ms);
+
+    /**
+     * @brief Wait until the result is ready and return it, rethrowing an exception of the task.
+     * @return The result.
+     */
+    R get();
+
+private:
+    friend class ThreadPool;
+
+    TaskFuture(ThreadPool* pool, std::shared_ptr<Job> job, std::future<R>&& future);
+
+    ThreadPool* m_pool{nullptr};
+    std::shared_ptr<Job> m_job{};
+    std::future<R> m_future{};
+};
+
+template<typename F, typename... Args>
+auto ThreadPool::fork(const ThreadPriority priority, F&& func, Args&&... args)
+    -> TaskFuture<typename std::invoke_result<F, Args...>::type>
+{
+    using Return = typename std::invoke_result<F, Args...>::type;
+    auto task{std::make_shared<std::packaged_task<Return()>>(
+        [func = std::forward<F>(func), args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> Return
+        { return std::apply(std::move(func), std::move(args)); })};
+    auto job{std::make_shared<Job>(Job{static_cast<std::size_t>(priority)})};
+    std::future<Return> future{task->get_future()};
+    if (!enqueue(priority, [task]()
+                 { (*task)(); },
+                 job))
+    {
+        return TaskFuture<Return>{};
+    }
+    return TaskFuture<Return>{this, std::move(job), std::move(future)};
+}
+
+template<typename R>
+ThreadPool::TaskFuture<R>::TaskFuture(ThreadPool* pool, std::shared_ptr<Job> job, std::future<R>&& future)
+    : m_pool{pool}
+    , m_job{std::move(job)}
+    , m_future{std::move(future)}
+{
+}
+
+template<typename R>
+bool ThreadPool::TaskFuture<R>::valid() const
+{
+    return m_future.valid();
+}
+
+template<typename R>
+void ThreadPool::TaskFuture<R>::wait()
+{
+    waitFor(WAIT_FOREVER);
+}
+
+template<typename R>
+bool ThreadPool::TaskFuture<R>::waitFor(const uint32_t timeout_ms)
+{
+    if (!valid())
+    {
+        return false;
+    }
+    auto deadline{Clock::time_point::max()};
+    if (timeout_ms != WAIT_FOREVER)
+    {
+        deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+    // The job is marked done after the task set the result, so the future is ready then.
+    if (m_pool != nullptr && m_pool->isWorker())
+    {
+        return m_pool->help(*m_job, deadline);
+    }
+    if (timeout_ms == WAIT_FOREVER)
+    {
+        m_future.wait();
+        return true;
+    }
+    return m_future.wait_until(deadline) == std::future_status::ready;
+}
+
+template<typename R>
+R ThreadPool::TaskFuture<R>::get()
+{
+    wait();
+    return m_future.get();
+}
+
+} // namespace ThreadSafe
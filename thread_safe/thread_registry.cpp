@@ -0,0 +1,84 @@
+#include "thread_registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadSafe
+{
+
+std::array<ThreadRegistry::Entry, ThreadRegistry::MAX_THREADS>& ThreadRegistry::entries()
+{
+    // Leaked on purpose: threads and signal handlers may still use it during static destruction.
+    static auto* table{new std::array<Entry, MAX_THREADS>{}};
+    return *table;
+}
+
+ThreadRegistry::Entry* ThreadRegistry::enter(const std::string& name)
+{
+    for (Entry& entry : entries())
+    {
+        uint32_t expected{FREE};
+        if (!entry.state.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire))
+        {
+            continue;
+        }
+        const std::size_t length{std::min(name.size(), NAME_SIZE - 1)};
+        std::memcpy(entry.name, name.data(), length);
+        entry.name[length] = '\0';
+        entry.tid = currentTid();
+        entry.heartbeat_ns.store(now(), std::memory_order_relaxed);
+        entry.cpu_clock = -1;
+        entry.stack_low = 0;
+        entry.stack_high = 0;
+#ifdef __linux__
+        // Filled on the thread itself, so that signal handlers can use them without a system call.
+        clockid_t cpu_clock{};
+        if (::pthread_getcpuclockid(::pthread_self(), &cpu_clock) == 0)
+        {
+            entry.cpu_clock = static_cast<int32_t>(cpu_clock);
+        }
+        pthread_attr_t attributes;
+        if (::pthread_getattr_np(::pthread_self(), &attributes) == 0)
+        {
+            void* stack{nullptr};
+            std::size_t size{0};
+            if (::pthread_attr_getstack(&attributes, &stack, &size) == 0)
+            {
+                entry.stack_low = reinterpret_cast<uintptr_t>(stack);
+                entry.stack_high = entry.stack_low + size;
+            }
+            ::pthread_attr_destroy(&attributes);
+        }
+#endif
+        entry.state.store(LIVE, std::memory_order_release);
+        return &entry;
+    }
+    LOG_WARNING_RATE_LIMITED("Thread registry is full, not registering: " << name);
+    return nullptr;
+}
+
+void ThreadRegistry::leave(Entry* entry)
+{
+    if (entry != nullptr)
+    {
+        entry->state.store(FREE, std::memory_order_release);
+    }
+}
+
+int64_t ThreadRegistry::currentTid()
+{
+#ifdef __linux__
+    return static_cast<int64_t>(::syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+} // namespace ThreadSafe
@@ -0,0 +1,106 @@
+#pragma once
+#include "common/common.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ThreadSafe
+{
+
+/**
+ * @brief Process-wide table of the running `Thread`s, readable from a signal handler.
+ *
+ * Every `Thread` enters itself when it starts running and leaves when it exits, and records a
+ * heartbeat on every loop iteration. The table is a fixed array of slots claimed with a CAS, so
+ * reading it needs no lock and no allocation, and diagnostics such as the fatal signal handler can
+ * walk it at any moment.
+ */
+class ThreadRegistry
+{
+public:
+    static constexpr std::size_t MAX_THREADS = 256;
+    static constexpr std::size_t NAME_SIZE = 32;
+
+    /**
+     * @brief Slot of one registered thread.
+     */
+    struct Entry
+    {
+        std::atomic<uint32_t> state{0};       ///< FREE, CLAIMED while being filled, LIVE.
+        char name[NAME_SIZE]{};               ///< Thread name, truncated and null-terminated.
+        int64_t tid{0};                       ///< Kernel thread id, 0 where unavailable.
+        std::atomic<int64_t> heartbeat_ns{0}; ///< Steady clock time of the last heartbeat.
+        int32_t cpu_clock{-1};                ///< Clock of the thread's CPU time, -1 where unavailable.
+        uintptr_t stack_low{0};               ///< Lowest address of the thread's stack, 0 if unknown.
+        uintptr_t stack_high{0};              ///< End of the thread's stack, 0 if unknown.
+    };
+
+    /**
+     * @brief Register the calling thread.
+     * @param name Name of the thread.
+     * @return The slot of the thread, `nullptr` if the table is full.
+     */
+    static Entry* enter(const std::string& name);
+
+    /**
+     * @brief Unregister a thread.
+     * @param entry The slot returned by `enter`, may be `nullptr`.
+     */
+    static void leave(Entry* entry);
+
+    /**
+     * @brief Record that the thread is making progress.
+     * @param entry The slot returned by `enter`, may be `nullptr`.
+     */
+    static void beat(Entry* entry)
+    {
+        if (entry != nullptr)
+        {
+            entry->heartbeat_ns.store(now(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Call a visitor for every registered thread. Async-signal-safe if the visitor is.
+     * @tparam Visitor Callable taking `const Entry&`.
+     * @param visitor The visitor.
+     */
+    template<typename Visitor>
+    static void forEach(Visitor visitor)
+    {
+        for (const Entry& entry : entries())
+        {
+            if (entry.state.load(std::memory_order_acquire) == LIVE)
+            {
+                visitor(entry);
+            }
+        }
+    }
+
+    /**
+     * @brief Kernel thread id of the calling thread. Async-signal-safe.
+     * @return The thread id, 0 where unavailable.
+     */
+    static int64_t currentTid();
+
+    /**
+     * @brief Steady clock time in nanoseconds, the base of the heartbeats. Async-signal-safe.
+     * @return The time.
+     */
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static constexpr uint32_t FREE = 0;
+    static constexpr uint32_t CLAIMED = 1;
+    static constexpr uint32_t LIVE = 2;
+
+    static std::array<Entry, MAX_THREADS>& entries();
+};
+
+} // namespace ThreadSafe
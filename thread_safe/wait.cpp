@@ -3,6 +3,11 @@
 namespace ThreadSafe
 {
 
+Wait::Wait(const bool priority_inheritance)
+    : m_lock{priority_inheritance}
+{
+}
+
 Wait::~Wait()
 {
     exit();
@@ -11,6 +16,10 @@ Wait::~Wait()
 void Wait::notify()
 {
     disableInternalPred();
+    {
+        // Serialize with waiters evaluating their predicate so the notification cannot be lost.
+        std::lock_guard<PiMutex> lock{m_lock};
+    }
     m_condition.notify_all();
 }
 
@@ -43,13 +52,16 @@ void Wait::disableInternalPred()
 void Wait::exit()
 {
     m_exit = true;
+    {
+        std::lock_guard<PiMutex> lock{m_lock};
+    }
     m_condition.notify_all();
 }
 
 Wait::Status Wait::wait()
 {
     enableInternalPred();
-    std::unique_lock<std::mutex> lock(m_lock);
+    std::unique_lock<PiMutex> lock(m_lock);
     m_condition.wait(lock, [this]() -> bool
                      { return isExit() || internalPred(); });
     if (isExit())
@@ -1,8 +1,9 @@
 #pragma once
 #include "common/common.hpp"
 
+#include "pi_mutex.hpp"
+
 #include <atomic>
-#include <condition_variable>
 #include <mutex>
 
 namespace ThreadSafe
@@ -13,6 +14,9 @@ namespace ThreadSafe
  *
  * This class provides mechanisms for waiting on a condition variable with support
  * for notifications, timeouts, and predicate-based conditions.
+ *
+ * With priority inheritance enabled, a low-priority thread holding the internal lock is boosted
+ * while a real-time thread waits for it, see `PiMutex`.
  */
 class Wait
 {
@@ -28,9 +32,11 @@ public:
     };
 
     /**
-     * @brief Default constructor for the Wait class.
+     * @brief Constructor for the Wait class.
+     *
+     * @param priority_inheritance Use a priority-inheritance mutex for the internal lock.
      */
-    Wait() = default;
+    explicit Wait(const bool priority_inheritance = false);
 
     /**
      * @brief Default destructor for the Wait class.
@@ -109,8 +115,8 @@ public:
     Status waitFor(const std::chrono::duration<Repr, Period>& timeout, Pr pred);
 
 private:
-    mutable std::mutex m_lock;                     ///< Mutex for thread-safe access
-    std::condition_variable m_condition;           ///< Condition variable for signaling
+    mutable PiMutex m_lock;                        ///< Mutex for thread-safe access
+    PiConditionVariable m_condition;               ///< Condition variable for signaling
     std::atomic<bool> m_exit{false};               ///< Atomic flag indicating an exit request
     std::atomic<bool> m_internal_pred_flag{false}; ///< Internal predicate flag used for signaling
 
@@ -151,7 +157,7 @@ private:
 template<typename Pr>
 Wait::Status Wait::wait(Pr pred)
 {
-    std::unique_lock<std::mutex> lock(m_lock);
+    std::unique_lock<PiMutex> lock(m_lock);
     m_condition.wait(lock, [this, &pred]() -> bool
                      { return isExit() || pred(); });
     if (isExit())
@@ -165,7 +171,7 @@ template<class Repr, class Period>
 Wait::Status Wait::waitFor(const std::chrono::duration<Repr, Period>& timeout)
 {
     enableInternalPred();
-    std::unique_lock<std::mutex> lock(m_lock);
+    std::unique_lock<PiMutex> lock(m_lock);
     bool status{m_condition.wait_for(lock, timeout, [this]() -> bool
                                      { return isExit() || internalPred(); })};
     if (!status)
@@ -182,7 +188,7 @@ Wait::Status Wait::waitFor(const std::chrono::duration<Repr, Period>& timeout)
 template<class Repr, class Period, typename Pr>
 Wait::Status Wait::waitFor(const std::chrono::duration<Repr, Period>& timeout, Pr pred)
 {
-    std::unique_lock<std::mutex> lock(m_lock);
+    std::unique_lock<PiMutex> lock(m_lock);
     bool status{m_condition.wait_for(lock, timeout, [this, &pred]() -> bool
                                      { return isExit() || pred(); })};
     if (!status)